@@ -110,4 +110,10 @@ int Audio_EnumPlaybackDevices(char names[][64], int max_count);
  */
 void Audio_Mix(int16_t* output, const int16_t** inputs, int input_count, int sample_count);
 
+/**
+ * @brief 计算一帧的电平 (RTP 包头电平字段, 见 RtpHeader_SetLevel)
+ * @return RTP_LEVEL_MAX + dBov (均方根), 限制在 0 ~ RTP_LEVEL_MAX
+ */
+uint8_t Audio_ComputeLevel(const int16_t* samples, int count);
+
 #endif // AUDIO_H
@@ -9,6 +9,7 @@
 #include "common.h"
 #include "protocol.h"
 #include "network.h"
+#include "jitter_buffer.h"
 
 //=============================================================================
 // 客户端事件回调
@@ -20,6 +21,8 @@ typedef struct {
     void (*onPeerJoined)(const PeerInfo* peer, void* userdata);
     void (*onPeerLeft)(uint32_t client_id, void* userdata);
     void (*onPeerListReceived)(const PeerInfo* peers, int count, void* userdata);
+    void (*onRoomJoined)(uint32_t room_id, const char* room_name, void* userdata);
+    void (*onRoomListReceived)(const RoomInfo* rooms, int count, void* userdata);
     void (*onAudioReceived)(const int16_t* pcm, int samples, void* userdata);
     void (*onError)(const char* msg, void* userdata);
     void* userdata;
@@ -105,6 +108,29 @@ void Client_LeaveSession(void);
  */
 bool Client_IsInSession(void);
 
+/**
+ * @brief 加入房间 (不存在时由服务器创建, 结果通过 onRoomJoined 回调)
+ *
+ * 连接后位于大厅; 只收到同房间用户的音频, 用户列表替换为新房间的成员.
+ * @param room_name 房间名, 空字符串或 ROOM_LOBBY_NAME 为大厅
+ */
+bool Client_JoinRoom(const char* room_name);
+
+/**
+ * @brief 离开当前房间, 回到大厅
+ */
+void Client_LeaveRoom(void);
+
+/**
+ * @brief 请求房间列表 (结果通过 onRoomListReceived 回调)
+ */
+bool Client_RequestRoomList(void);
+
+/**
+ * @brief 获取当前房间名
+ */
+const char* Client_GetRoom(void);
+
 /**
  * @brief 获取当前连接的服务器信息
  */
@@ -112,8 +138,11 @@ bool Client_GetCurrentServer(ServerInfo* server);
 
 /**
  * @brief 发送 Opus 编码音频 (UDP)
+ * @param voice 是否为语音帧 (false: DTX 期间的舒适噪声更新帧); DTX 帧本身不发送
+ * @param level 这一帧的电平 (见 Audio_ComputeLevel), 服务器据此选择转发的发言者
  */
-void Client_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp);
+void Client_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp, bool voice,
+                          uint8_t level);
 
 /**
  * @brief 获取在线用户列表
@@ -121,13 +150,41 @@ void Client_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t times
 int Client_GetPeers(PeerInfo* peers, int max_count);
 
 /**
- * @brief 获取 Jitter Buffer 统计
+ * @brief 获取 Jitter Buffer 统计 (所有接收流汇总)
  */
 void Client_GetJitterStats(float* jitter_ms, float* loss_rate, int* buffer_level);
 
+/**
+ * @brief 获取单个接收流的 Jitter Buffer 统计
+ * @param ssrc 发送者 SSRC
+ * @return 流存在返回 true
+ */
+bool Client_GetStreamStats(uint32_t ssrc, JitterStats* stats, int* buffer_level);
+
+/**
+ * @brief 获取单个接收流的质量快照 (统计 + 延迟/抖动/连续隐藏直方图)
+ *
+ * 不经过抖动缓冲的互斥锁, 可在 UI 定时器中频繁调用.
+ * @param ssrc 发送者 SSRC
+ * @return 流存在返回 true
+ */
+bool Client_GetStreamSnapshot(uint32_t ssrc, JitterSnapshot* snap);
+
 /**
  * @brief 获取分配的 SSRC
  */
 uint32_t Client_GetSSRC(void);
 
+/**
+ * @brief 开始录制接收包到达轨迹 (供 tools/jitter_replay 离线回放)
+ * @param path 轨迹文件路径 (正在录制时切换到新文件)
+ * @return 成功返回 true
+ */
+bool Client_StartJitterTrace(const char* path);
+
+/**
+ * @brief 停止录制到达轨迹
+ */
+void Client_StopJitterTrace(void);
+
 #endif // CLIENT_H
@@ -16,6 +16,10 @@
     #pragma comment(lib, "ws2_32.lib")
     #pragma comment(lib, "winmm.lib")
     #pragma comment(lib, "comctl32.lib")
+#else
+    // 非 Windows 平台只提供抖动缓冲核心所需的部分 (离线回放工具)
+    #include <pthread.h>
+    #include <unistd.h>
 #endif
 
 #include <stdio.h>
@@ -56,17 +60,21 @@
 #define OPUS_BITRATE        32000       // Opus 码率 (32kbps)
 #define OPUS_COMPLEXITY     5           // Opus 复杂度 (0-10)
 #define OPUS_MAX_PACKET     512         // Opus 最大包大小
+#define OPUS_DTX_MAX_BYTES  2           // 不超过此长度的编码输出为 DTX 帧 (不发送)
 
 // Jitter Buffer 常量
-#define JITTER_BUFFER_MS    80          // 抖动缓冲时长 (毫秒)
-#define JITTER_MIN_MS       40          // 最小缓冲
+#define JITTER_BUFFER_MS    80          // 抖动缓冲时长 (毫秒, 非自适应时使用)
+#define JITTER_MIN_MS       20          // 最小缓冲
 #define JITTER_MAX_MS       200         // 最大缓冲
+#define JITTER_LATE_LOSS    0.02f       // 自适应目标迟到丢包率 (2%)
 #define JITTER_BUFFER_SLOTS 64          // 缓冲槽数量
+#define JITTER_MAX_PAYLOAD  OPUS_MAX_PACKET // 单包最大字节数 (与收包上限一致; 32kbps 下 120ms 的包约 480 字节)
+#define JITTER_PAYLOAD_POOL (JITTER_BUFFER_SLOTS * OPUS_BITRATE / 8 * AUDIO_FRAME_MS / 1000 * 2)  // 负载池总字节数 (按实际包长分配; 64 个 20ms 包按两倍码率计, 10 KB)
 
 //=============================================================================
 // 限制常量
 //=============================================================================
-#define MAX_CLIENTS         16          // 最大客户端数
+#define MAX_SESSIONS        1024        // 服务器最大连接数 (也是一个房间的最大人数)
 #define MAX_SERVERS         32          // 最大发现服务器数
 #define MAX_NAME_LEN        32          // 名称最大长度
 #define MAX_PACKET_SIZE     4096        // 最大数据包大小
@@ -83,6 +91,12 @@
 #define MAX(a, b)       ((a) > (b) ? (a) : (b))
 #define CLAMP(v, lo, hi) MIN(MAX(v, lo), hi)
 
+#ifdef _WIN32
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
 //=============================================================================
 // 日志宏
 //=============================================================================
@@ -98,6 +112,7 @@
 //=============================================================================
 // 时间函数
 //=============================================================================
+#ifdef _WIN32
 static inline uint32_t GetTickCountMs(void) {
     return (uint32_t)GetTickCount();
 }
@@ -106,23 +121,81 @@ static inline uint64_t GetTickCount64Ms(void) {
     return GetTickCount64();
 }
 
+/**
+ * @brief QueryPerformanceCounter 计数转换为微秒 (与 GetTimeUs 同一时间基准)
+ */
+static inline uint64_t QpcToUs(uint64_t counter) {
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return counter / freq.QuadPart * 1000000 +
+           counter % freq.QuadPart * 1000000 / freq.QuadPart;
+}
+
+/**
+ * @brief 高精度单调时间 (微秒), 用于耗时统计与收包时间戳
+ */
+static inline uint64_t GetTimeUs(void) {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return QpcToUs((uint64_t)counter.QuadPart);
+}
+#else
+static inline uint64_t GetTimeUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline uint64_t GetTickCount64Ms(void) {
+    return GetTimeUs() / 1000;
+}
+
+static inline uint32_t GetTickCountMs(void) {
+    return (uint32_t)GetTickCount64Ms();
+}
+#endif
+
 //=============================================================================
 // 原子操作
 //=============================================================================
+#ifdef _WIN32
 typedef volatile LONG AtomicInt;
 #define AtomicRead(p)       InterlockedCompareExchange(p, 0, 0)
 #define AtomicSet(p, v)     InterlockedExchange(p, v)
 #define AtomicInc(p)        InterlockedIncrement(p)
 #define AtomicDec(p)        InterlockedDecrement(p)
+#define AtomicFence()       MemoryBarrier()
+#define AtomicReadPtr(p)    InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define AtomicSetPtr(p, v)  InterlockedExchangePointer((PVOID volatile*)(p), v)
+#else
+typedef volatile int32_t AtomicInt;
+#define AtomicRead(p)       __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define AtomicSet(p, v)     __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST)
+#define AtomicInc(p)        __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define AtomicDec(p)        __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define AtomicFence()       __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define AtomicReadPtr(p)    __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define AtomicSetPtr(p, v)  __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST)
+#endif
 
 //=============================================================================
 // 互斥锁
 //=============================================================================
+#ifdef _WIN32
 typedef CRITICAL_SECTION Mutex;
 #define MutexInit(m)        InitializeCriticalSection(m)
 #define MutexDestroy(m)     DeleteCriticalSection(m)
 #define MutexLock(m)        EnterCriticalSection(m)
 #define MutexUnlock(m)      LeaveCriticalSection(m)
+#else
+typedef pthread_mutex_t Mutex;
+#define MutexInit(m)        pthread_mutex_init(m, NULL)
+#define MutexDestroy(m)     pthread_mutex_destroy(m)
+#define MutexLock(m)        pthread_mutex_lock(m)
+#define MutexUnlock(m)      pthread_mutex_unlock(m)
+#endif
+
+#ifdef _WIN32
 
 //=============================================================================
 // 线程
@@ -142,4 +215,6 @@ typedef HANDLE Event;
 #define EventSet(e)         SetEvent(e)
 #define EventWait(e, ms)    WaitForSingleObject(e, ms)
 
+#endif // _WIN32
+
 #endif // COMMON_H
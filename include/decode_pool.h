@@ -0,0 +1,88 @@
+/**
+ * @file decode_pool.h
+ * @brief 服务器解码工作池 (转发优先, 解码延后)
+ *
+ * UDP 音频线程收包后立即转发, 需要解码 (本地监听 / onAudioReceived) 的包
+ * 复制一份放入有界队列, 由独立的工作线程解码并回调:
+ * 1. 按 SSRC 固定分配到某个工作线程, 同一发送者的包按到达顺序解码,
+ *    解码器只被一个线程访问, 无需加锁
+ * 2. 每个发送者独立的 Opus 解码器, 首包时懒创建, 离开时重置并回收复用
+ * 3. 队列满时丢弃 (监听为尽力而为, 不能反压转发路径)
+ */
+
+#ifndef DECODE_POOL_H
+#define DECODE_POOL_H
+
+#include "common.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define DECODE_POOL_MAX_WORKERS     4               // 最大工作线程数
+#define DECODE_POOL_QUEUE_SIZE      64              // 每个工作线程的队列长度 (包)
+#define DECODE_POOL_MAX_DECODERS    MAX_SESSIONS    // 每个工作线程最多同时持有的解码器 (发送者可能全部落在同一线程)
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 解码完成回调 (在工作线程中调用)
+ */
+typedef void (*DecodePoolCallback)(uint32_t client_id, const int16_t* pcm, int samples,
+                                   void* userdata);
+
+/**
+ * @brief 解码池统计
+ */
+typedef struct {
+    uint32_t submitted;         // 入队包数
+    uint32_t decoded;           // 解码成功包数
+    uint32_t dropped;           // 队列满丢弃的包数
+    int      queue_depth;       // 当前排队包数 (所有工作线程)
+    int      queue_max;         // 单个队列出现过的最大深度
+    int      decoders;          // 当前分配的解码器数
+    float    decode_cost_us;    // 单包平均解码耗时 (微秒)
+    float    queue_delay_us;    // 平均排队时间 (入队到开始解码, 微秒)
+} DecodePoolStats;
+
+/**
+ * @brief 解码池实例
+ */
+typedef struct DecodePool DecodePool;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 创建解码池并启动工作线程
+ * @param workers 工作线程数 (1 ~ DECODE_POOL_MAX_WORKERS)
+ * @param callback 解码完成回调
+ * @return 解码池实例, 失败返回 NULL
+ */
+DecodePool* DecodePool_Create(int workers, DecodePoolCallback callback, void* userdata);
+
+/**
+ * @brief 停止工作线程并销毁解码池 (丢弃未处理的包)
+ */
+void DecodePool_Destroy(DecodePool* pool);
+
+/**
+ * @brief 提交一个包 (复制负载, 不阻塞)
+ * @return true 已入队, false 队列满被丢弃
+ */
+bool DecodePool_Submit(DecodePool* pool, uint32_t ssrc, uint32_t client_id,
+                       const uint8_t* payload, int payload_len);
+
+/**
+ * @brief 回收发送者的解码器 (排在该发送者已提交的包之后执行)
+ */
+void DecodePool_Release(DecodePool* pool, uint32_t ssrc);
+
+/**
+ * @brief 获取统计信息
+ */
+void DecodePool_GetStats(DecodePool* pool, DecodePoolStats* stats);
+
+#endif // DECODE_POOL_H
@@ -20,25 +20,66 @@
 //=============================================================================
 #define JB_SLOT_EMPTY       0
 #define JB_SLOT_FILLED      1
-#define JB_SLOT_DECODED     2
+
+// 自适应延迟: 到达延迟直方图
+#define JB_HIST_BIN_MS      5           // 直方图桶宽 (毫秒)
+#define JB_HIST_BINS        64          // 桶数量 (覆盖 0-320ms)
+#define JB_HIST_FORGET      0.996f      // 遗忘因子 (约 250 包 / 5 秒)
+#define JB_TRANSIT_WINDOW   250         // 最小传输时延窗口 (包数)
+#define JB_SHRINK_MARGIN_MS 100         // 高于目标多少毫秒开始整帧丢弃
+#define JB_SHRINK_HOLD      10          // 连续高于目标多少次取帧后丢帧
+
+// 包时长 (由 RTP 时间戳和 Opus TOC 决定, 不要求与本地帧长一致)
+#define JB_MAX_FRAME_SAMPLES    (AUDIO_SAMPLE_RATE * 120 / 1000)   // 单包最长 120ms
+#define JB_MIN_FRAME_SAMPLES    (AUDIO_SAMPLE_RATE / 400)          // 最小粒度 2.5ms
+
+// 重新同步
+#define JB_RESYNC_GAP_MS    1000        // 时间戳跳变超过此值视为新的播放序列
+
+// 舒适噪声 (DTX)
+#define JB_CN_MAX_LEVEL     300         // 舒适噪声 RMS 上限 (约 -40 dBFS)
+#define JB_CN_MAX_MS        1000        // DTX 期间超过此时长没有新包则视为欠载
+
+// 时间伸缩
+#define JB_TSM_DEADBAND_MS  10          // 级别偏离目标超过此值才伸缩
+#define JB_OUT_BUF_SAMPLES  (JB_MAX_FRAME_SAMPLES + AUDIO_FRAME_SAMPLES)  // 输出缓冲 (一包 + 伸缩余量)
+
+// 时钟漂移补偿
+#define JB_DRIFT_WINDOW_MS  5000        // 最小传输时延窗口 (媒体时间, 毫秒)
+#define JB_DRIFT_POINTS     24          // 参与回归的窗口数 (约 2 分钟)
+#define JB_DRIFT_MIN_SPAN_MS 30000      // 窗口覆盖至少此媒体时长才开始补偿
+#define JB_DRIFT_MAX_PPM    1000        // 漂移估计上限 (ppm)
+#define JB_DRIFT_JUMP_MS    50          // 相邻窗口最小传输时延跳变超过此值视为不连续
+#define JB_DRIFT_SMOOTH     0.25f       // 每个新窗口对补偿比例的平滑系数
+
+// 无锁模式
+#define JB_INGRESS_SLOTS    64          // 入口队列长度 (2 的幂)
+
+// 播放质量直方图
+#define JB_QHIST_BINS       128         // 桶数量 (最后一个桶包含所有更大的值)
+#define JB_QHIST_MAX_COUNT  3000        // 样本数达到此值时各桶减半 (偏重最近约 1 分钟)
+#define JB_QHIST_DELAY_MS   5           // 缓冲延迟桶宽 (毫秒, 覆盖 0-640ms)
+#define JB_QHIST_JITTER_US  500         // 到达抖动桶宽 (微秒, 覆盖 0-64ms)
+#define JB_SNAPSHOT_RETRIES 16          // 读取快照时与写入冲突的最大重试次数
 
 //=============================================================================
 // 数据结构
 //=============================================================================
 
 /**
- * @brief Jitter Buffer 槽
+ * @brief Jitter Buffer 槽 (热数据, 16 字节)
+ * 
+ * 负载按实际长度存放在负载池中 (冷数据), 槽内只记偏移;
+ * 解码直接写入输出缓冲, 槽内不保存 PCM.
  */
 typedef struct {
     uint8_t  state;                         // 槽状态
+    uint8_t  vad;                           // 语音帧 (RTP VAD 标志, 0 为 DTX 舒适噪声更新帧)
     uint16_t sequence;                      // 序列号
-    uint32_t timestamp;                     // 采样时间戳
-    uint32_t ssrc;                          // 来源标识
     uint16_t payload_len;                   // 负载长度
-    uint8_t  payload[OPUS_MAX_PACKET];      // Opus 编码数据
-    int16_t  decoded[AUDIO_FRAME_SAMPLES];  // 解码后 PCM
-    int      decoded_samples;               // 解码采样数
-    uint64_t recv_time;                     // 接收时间
+    uint16_t payload_off;                   // 负载在负载池中的偏移
+    uint16_t samples;                       // 包时长 (采样数)
+    uint32_t timestamp;                     // 采样时间戳
 } JitterSlot;
 
 /**
@@ -46,23 +87,61 @@ typedef struct {
  */
 typedef struct {
     uint32_t packets_received;  // 接收包数
-    uint32_t packets_lost;      // 丢包数
+    uint32_t packets_lost;      // 丢包数 (= 已恢复 + 已补偿)
+    uint32_t packets_recovered; // 通过 FEC 恢复的丢包数
+    uint32_t packets_concealed; // 通过 PLC 补偿的丢包数
     uint32_t packets_late;      // 迟到包数
     uint32_t packets_reorder;   // 乱序包数
     uint32_t underruns;         // 欠载次数 (缓冲区空)
     uint32_t overruns;          // 过载次数 (缓冲区满)
+    uint32_t packets_oversize;  // 超过单包最大字节数而丢弃的包数
+    uint32_t frames_dropped;    // 为降低延迟丢弃的帧数
+    uint32_t resyncs;           // 重新同步次数 (SSRC/序列号/时间戳跳变, 新讲话段)
+    uint32_t frames_accelerated;// 加速 (缩短) 帧数
+    uint32_t frames_decelerated;// 减速 (拉长) 帧数
+    uint32_t frames_comfort_noise;// DTX 静音期生成的舒适噪声帧数
+    float    stretch_cost_us;   // 时间伸缩单帧平均耗时 (微秒)
+    float    put_cost_us;       // 收包 (Put) 平均耗时 (微秒)
+    float    put_cost_max_us;   // 收包 (Put) 峰值耗时 (微秒)
+    uint32_t target_delay_ms;   // 当前目标延迟 (毫秒)
     float    avg_jitter_ms;     // 平均抖动 (毫秒)
+    float    drift_ppm;         // 发送端时钟漂移补偿量 (ppm, 正 = 发送端偏慢, 播放拉长)
     float    loss_rate;         // 丢包率
 } JitterStats;
 
+/**
+ * @brief 直方图 (值按 bin_width 分桶)
+ */
+typedef struct {
+    uint32_t bins[JB_QHIST_BINS];
+    uint32_t count;             // 样本总数
+    uint32_t bin_width;         // 桶宽 (单位见所在字段)
+} JitterHistogram;
+
+/**
+ * @brief 统计快照 (播放线程每次 Get 后发布, 读取不加锁)
+ */
+typedef struct {
+    JitterStats     stats;
+    int             level_ms;       // 缓冲级别 (毫秒)
+    JitterHistogram delay_ms;       // 解码帧出缓冲时的缓冲延迟 (毫秒)
+    JitterHistogram jitter_us;      // 每包到达间隔抖动 |D| (RFC 3550, 微秒)
+    JitterHistogram conceal_run;    // 连续 PLC 补偿帧数 (每段连续丢包记一次)
+} JitterSnapshot;
+
 /**
  * @brief Jitter Buffer 配置
  */
 typedef struct {
     uint32_t min_delay_ms;      // 最小延迟
     uint32_t max_delay_ms;      // 最大延迟
-    uint32_t target_delay_ms;   // 目标延迟
+    uint32_t target_delay_ms;   // 目标延迟 (非自适应时固定使用)
     bool     adaptive;          // 自适应延迟
+    float    late_loss_rate;    // 自适应目标迟到丢包率 (0-1)
+    uint16_t max_payload;       // 单包最大字节数 (0 = OPUS_MAX_PACKET)
+    uint16_t pool_bytes;        // 负载池总字节数 (0 = JITTER_PAYLOAD_POOL)
+    bool     lock_free;         // 无锁单生产者/单消费者模式 (Put 不加锁)
+    bool     drift_compensation;// 估计发送端时钟漂移并重采样补偿
 } JitterConfig;
 
 /**
@@ -74,6 +153,11 @@ typedef struct JitterBuffer JitterBuffer;
 // 公共接口
 //=============================================================================
 
+/**
+ * @brief 获取默认配置
+ */
+void JitterBuffer_GetDefaultConfig(JitterConfig* config);
+
 /**
  * @brief 创建 Jitter Buffer
  * @param config 配置 (NULL 使用默认配置)
@@ -87,40 +171,64 @@ JitterBuffer* JitterBuffer_Create(const JitterConfig* config);
 void JitterBuffer_Destroy(JitterBuffer* jb);
 
 /**
- * @brief 重置 Jitter Buffer
+ * @brief 重置 Jitter Buffer (无锁模式下须在收发线程停止时调用)
  */
 void JitterBuffer_Reset(JitterBuffer* jb);
 
 /**
  * @brief 放入 RTP 包
+ * 
+ * 无锁模式下只能由一个线程调用, 包在下次 Get 时才排序入槽,
+ * 因此返回值只反映入队结果 (迟到/重复等计入统计).
+ * 
  * @param jb JitterBuffer 实例
  * @param rtp RTP 包头
  * @param payload 编码数据
  * @param payload_len 数据长度
+ * @param recv_time_us 收包时间 (微秒, GetTimeUs 时间基准, 最好取自套接字层), 0 表示取当前时钟
  * @return 0 成功, <0 失败
  */
 int JitterBuffer_Put(JitterBuffer* jb, const RtpHeader* rtp, 
-                     const uint8_t* payload, uint16_t payload_len);
+                     const uint8_t* payload, uint16_t payload_len, uint64_t recv_time_us);
 
 /**
- * @brief 获取解码后的音频帧
+ * @brief 取出指定数量的解码 PCM
+ * 
+ * num_samples 可为任意值 (如 5ms/10ms 的设备周期), 与包时长无关;
+ * 一包中未取完的部分保留到下次调用. 内部会做时间伸缩以平滑调整延迟.
+ * 
  * @param jb JitterBuffer 实例
  * @param samples 输出 PCM 缓冲区
- * @param max_samples 缓冲区最大采样数
- * @return 实际采样数, 0 表示无数据, <0 表示错误
+ * @param num_samples 请求的采样数
+ * @return num_samples (数据不足时补零), 0 表示无数据, <0 表示错误
  */
-int JitterBuffer_Get(JitterBuffer* jb, int16_t* samples, int max_samples);
+int JitterBuffer_Get(JitterBuffer* jb, int16_t* samples, int num_samples);
 
 /**
- * @brief 获取当前缓冲级别 (毫秒)
+ * @brief 获取当前缓冲级别 (毫秒, 按 RTP 时间戳计算的已缓冲时长)
  */
 int JitterBuffer_GetLevel(JitterBuffer* jb);
 
 /**
- * @brief 获取统计信息
+ * @brief 获取统计信息 (与播放线程共用互斥锁, 结果反映最新的 Put)
  */
 void JitterBuffer_GetStats(JitterBuffer* jb, JitterStats* stats);
 
+/**
+ * @brief 读取最近一次发布的统计快照 (顺序锁, 不获取互斥锁, 不阻塞播放线程)
+ * 
+ * 适合界面定时轮询; 快照在每次 Get 结束时更新.
+ * @return 成功返回 true, 连续与写入冲突时返回 false
+ */
+bool JitterBuffer_GetSnapshot(JitterBuffer* jb, JitterSnapshot* snap);
+
+/**
+ * @brief 直方图分位数
+ * @param percentile 分位 (0-1, 如 0.5 / 0.95 / 0.99)
+ * @return 该分位所在桶的最大值 (与直方图同单位), 无样本时返回 0
+ */
+uint32_t JitterHistogram_Percentile(const JitterHistogram* hist, float percentile);
+
 /**
  * @brief 设置 Opus 解码器 (外部提供)
  * @param jb JitterBuffer 实例
@@ -137,4 +245,21 @@ void JitterBuffer_SetDecoder(JitterBuffer* jb, void* decoder, OpusDecodeFunc dec
 typedef int (*PlcFunc)(void* decoder, int16_t* pcm, int frame_size);
 void JitterBuffer_SetPlc(JitterBuffer* jb, PlcFunc plc_func);
 
+/**
+ * @brief 设置时钟 (微秒, 单调递增), 用于离线回放等需要确定性时间的场合
+ * 
+ * 只在 Put 未给出收包时间时使用.
+ * @param clock_func 时钟函数 (NULL 恢复 GetTimeUs)
+ * @param ctx 传给时钟函数的上下文
+ */
+typedef uint64_t (*JitterClockFunc)(void* ctx);
+void JitterBuffer_SetClock(JitterBuffer* jb, JitterClockFunc clock_func, void* ctx);
+
+/**
+ * @brief 设置包时长解析回调 (未设置时每包按 AUDIO_FRAME_SAMPLES 计)
+ * @return 包的采样数, <=0 表示无法解析
+ */
+typedef int (*PacketSamplesFunc)(const uint8_t* data, int len);
+void JitterBuffer_SetPacketSamples(JitterBuffer* jb, PacketSamplesFunc samples_func);
+
 #endif // JITTER_BUFFER_H
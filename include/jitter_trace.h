@@ -0,0 +1,102 @@
+/**
+ * @file jitter_trace.h
+ * @brief 抖动缓冲到达轨迹 (录制 / 回放)
+ *
+ * 在接收线程记录每个 RTP 包的到达时间与包头, 供离线回放工具
+ * (tools/jitter_replay.c) 以确定性时钟重放, 用于调整 JitterConfig.
+ *
+ * 文件格式 (小端):
+ * 1. 文件头 JitterTraceFileHeader
+ * 2. 若干条记录: JitterTraceRecord + payload_len 字节负载
+ */
+
+#ifndef JITTER_TRACE_H
+#define JITTER_TRACE_H
+
+#include "common.h"
+#include "protocol.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define JITTER_TRACE_MAGIC      0x544A5653  // 'SVJT'
+#define JITTER_TRACE_VERSION    1
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+#pragma pack(push, 1)
+
+/**
+ * @brief 轨迹文件头
+ */
+typedef struct {
+    uint32_t magic;         // JITTER_TRACE_MAGIC
+    uint16_t version;       // JITTER_TRACE_VERSION
+    uint16_t reserved;
+    uint32_t sample_rate;   // RTP 时间戳采样率
+    uint32_t reserved2;
+} JitterTraceFileHeader;
+
+/**
+ * @brief 单个包的到达记录
+ */
+typedef struct {
+    uint64_t recv_time_us;  // 接收时间 (单调时钟, 微秒)
+    uint32_t ssrc;          // 来源标识
+    uint32_t timestamp;     // RTP 时间戳
+    uint16_t sequence;      // 序列号
+    uint16_t flags;         // RtpHeader.flags
+    uint16_t payload_len;   // 负载长度
+    uint16_t samples;       // 包时长 (采样数, 录制时由 Opus TOC 解析, 0 = 未知)
+} JitterTraceRecord;
+
+#pragma pack(pop)
+
+/**
+ * @brief 轨迹文件句柄
+ */
+typedef struct JitterTrace JitterTrace;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 创建轨迹文件 (录制)
+ * @return 句柄, 失败返回 NULL
+ */
+JitterTrace* JitterTrace_Create(const char* path);
+
+/**
+ * @brief 打开轨迹文件 (回放)
+ * @return 句柄, 失败或格式不符返回 NULL
+ */
+JitterTrace* JitterTrace_Open(const char* path);
+
+/**
+ * @brief 关闭轨迹文件
+ */
+void JitterTrace_Close(JitterTrace* trace);
+
+/**
+ * @brief 写入一条到达记录
+ * @param samples 包时长 (采样数, 0 = 未知)
+ * @param recv_time_us 接收时间 (GetTimeUs)
+ * @return 成功返回 true
+ */
+bool JitterTrace_Write(JitterTrace* trace, const RtpHeader* rtp,
+                       const uint8_t* payload, uint16_t payload_len,
+                       int samples, uint64_t recv_time_us);
+
+/**
+ * @brief 读取下一条记录
+ * @param record 输出记录
+ * @param payload 输出负载缓冲区
+ * @param max_payload 负载缓冲区大小 (超出部分被截断, record->payload_len 为截断后长度)
+ * @return 成功返回 true, 文件结束或出错返回 false
+ */
+bool JitterTrace_Read(JitterTrace* trace, JitterTraceRecord* record,
+                      uint8_t* payload, uint16_t max_payload);
+
+#endif // JITTER_TRACE_H
@@ -0,0 +1,133 @@
+/**
+ * @file mcu.h
+ * @brief 服务器混音 (MCU) 接口
+ *
+ * 转发模式下每个客户端收到 N-1 路流, 下行带宽与解码负载随人数增长.
+ * MCU 模式下服务器:
+ * 1. 每个发送者使用独立的 JitterBuffer + 解码器 (StreamMixer)
+ * 2. 每 MCU_TICK_MS 从所有发送者各取一帧, 求和
+ * 3. 对每个收听者减去其自身一路 (mix-minus), 用该收听者独立的编码器编码后发送
+ * 因此无论房间多大, 每个客户端只收到一路流. 求和按房间分开, 收听者只听到同房间的发送者.
+ *
+ * 输出流使用服务器 SSRC, 各收听者独立维护序列号, 时间戳按 tick 推进.
+ */
+
+#ifndef MCU_H
+#define MCU_H
+
+#include "common.h"
+#include "protocol.h"
+#include "stream_mixer.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define MCU_TICK_MS             AUDIO_FRAME_MS  // 混音周期 (毫秒)
+#define MCU_MAX_LISTENERS       (MIXER_MAX_STREAMS - 1)    // 最大收听者数 (即 MCU 模式的会话上限; 混音器另需一路给服务器本地语音)
+#define MCU_ENCODER_COMPLEXITY  5               // 每个收听者一个编码器, 复杂度低于客户端以控制 CPU
+#define MCU_MAX_LAG_TICKS       5               // 落后超过此 tick 数时放弃追赶
+#define MCU_DEFAULT_ROOM        0               // 服务器本地语音 (SSRC 与输出流相同) 所属房间
+#define MCU_NO_ROOM             0xFFFFFFFFu     // 发送者已不在路由中 (本周期不混入)
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 收听者 (由服务器在每个 tick 提供)
+ */
+typedef struct {
+    uint32_t    ssrc;           // 收听者自身的 SSRC (混音时排除)
+    uint32_t    room;           // 所在房间 (只混入同房间的发送者)
+    SOCKADDR_IN addr;           // UDP 音频地址
+    SOCKET      sock;           // 发送用的 UDP socket (收听者所联系的端口)
+} McuListener;
+
+/**
+ * @brief 获取当前收听者列表
+ * @return 收听者数量
+ */
+typedef int (*McuListenersFunc)(McuListener* listeners, int max_count, void* ctx);
+
+/**
+ * @brief 查询本周期各发送者所在房间 (一次查询所有发送者)
+ * @param rooms 输出, 与 ssrcs 一一对应, 未知的发送者为 MCU_NO_ROOM
+ */
+typedef void (*McuSourceRoomsFunc)(const uint32_t* ssrcs, int count, uint32_t* rooms, void* ctx);
+
+/**
+ * @brief MCU 统计
+ */
+typedef struct {
+    uint32_t ticks;             // 已完成的混音周期数
+    uint32_t ticks_skipped;     // 因落后过多而放弃的周期数
+    uint32_t frames_encoded;    // 编码帧数 (所有收听者)
+    uint32_t frames_idle;       // 无人说话且编码器已进入 DTX 而跳过编码的帧数
+    uint32_t packets_sent;      // 发送包数
+    int      sources;           // 上一周期有数据的发送者数
+    int      listeners;         // 上一周期的收听者数
+    float    tick_cost_us;      // 单周期平均耗时 (取帧 + 解码 + 混音 + 编码 + 发送, 微秒)
+    float    tick_cost_max_us;  // 单周期峰值耗时 (微秒)
+    float    listener_cost_us;  // 平均每个收听者的耗时 (微秒)
+} McuStats;
+
+/**
+ * @brief MCU 实例
+ */
+typedef struct Mcu Mcu;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 创建 MCU
+ * @param ssrc 输出流 SSRC
+ * @param listeners_func 每个周期获取收听者列表
+ * @param rooms_func 每个周期查询发送者所在房间 (与收听者列表无关; NULL 表示所有人在同一房间)
+ * @return MCU 实例, 失败返回 NULL
+ */
+Mcu* Mcu_Create(uint32_t ssrc, McuListenersFunc listeners_func,
+                McuSourceRoomsFunc rooms_func, void* ctx);
+
+/**
+ * @brief 销毁 MCU (先停止混音线程)
+ */
+void Mcu_Destroy(Mcu* mcu);
+
+/**
+ * @brief 启动混音线程 (每 MCU_TICK_MS 调用一次 Mcu_Tick)
+ */
+bool Mcu_Start(Mcu* mcu);
+
+/**
+ * @brief 停止混音线程
+ */
+void Mcu_Stop(Mcu* mcu);
+
+/**
+ * @brief 放入发送者的 RTP 包
+ * @param recv_time_us 收包时间 (微秒), 0 表示取当前时间
+ * @return 0 成功, <0 失败
+ */
+int Mcu_Put(Mcu* mcu, const RtpHeader* rtp, const uint8_t* payload,
+            uint16_t payload_len, uint64_t recv_time_us);
+
+/**
+ * @brief 移除发送者 (客户端离开)
+ */
+void Mcu_RemoveSource(Mcu* mcu, uint32_t ssrc);
+
+/**
+ * @brief 执行一个混音周期
+ *
+ * Mcu_Start 后由混音线程调用; 不启动线程时可直接调用 (基准测试).
+ */
+void Mcu_Tick(Mcu* mcu);
+
+/**
+ * @brief 获取统计信息
+ */
+void Mcu_GetStats(Mcu* mcu, McuStats* stats);
+
+#endif // MCU_H
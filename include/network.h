@@ -35,6 +35,27 @@ typedef struct {
     bool        active;
 } AudioClientInfo;
 
+//=============================================================================
+// 一对多批量发送
+//=============================================================================
+#define NETWORK_BATCH_MAX       256     // 单次提交的最大目标数 (更多时分批)
+#define NETWORK_BATCH_DEPTH     4       // 可同时在途的批次数
+
+/**
+ * @brief 批量发送器 (同一数据报发往多个地址)
+ */
+typedef struct UdpBatch UdpBatch;
+
+/**
+ * @brief 批量发送统计
+ */
+typedef struct {
+    uint32_t    datagrams;      // 已提交的数据报数 (每个目标一个)
+    uint32_t    syscalls;       // 为此进入内核的次数
+    uint32_t    fallbacks;      // 在途批次未完成而改为逐个 sendto 的批次数
+    bool        rio;            // 是否使用 RIO 延迟提交
+} UdpBatchStats;
+
 //=============================================================================
 // 网络模块接口
 //=============================================================================
@@ -61,11 +82,37 @@ SOCKET Network_CreateUdpBroadcast(uint16_t port, bool bind_port);
  */
 SOCKET Network_CreateUdpAudio(uint16_t port, uint16_t* out_port);
 
+/**
+ * @brief 创建用于一对多转发的 UDP 音频socket (服务器)
+ *
+ * 与 Network_CreateUdpAudio 相同, 系统支持时以 WSA_FLAG_REGISTERED_IO 创建,
+ * 使 Network_CreateUdpBatch 可以使用 RIO 批量发送.
+ */
+SOCKET Network_CreateUdpFanout(uint16_t port, uint16_t* out_port);
+
 /**
  * @brief 创建TCP监听socket (控制通道)
  */
 SOCKET Network_CreateTcpListener(uint16_t port);
 
+/**
+ * @brief 创建唤醒 socket (绑定 127.0.0.1 随机端口的非阻塞 UDP socket)
+ *
+ * Winsock 没有 eventfd: 把它加入 WSAPoll 集合, 其他线程调用 Network_Wakeup
+ * 向它发送一个字节, 即可让等待立即返回.
+ */
+SOCKET Network_CreateWakeup(void);
+
+/**
+ * @brief 唤醒在该 socket 上等待的 WSAPoll (任意线程)
+ */
+void Network_Wakeup(SOCKET wakeup);
+
+/**
+ * @brief 读空唤醒 socket (等待线程被唤醒后调用)
+ */
+void Network_DrainWakeup(SOCKET wakeup);
+
 /**
  * @brief 创建TCP客户端连接 (控制通道)
  */
@@ -92,12 +139,48 @@ int Network_UdpRecvFrom(SOCKET sock, void* buf, int len, SOCKADDR_IN* from);
 int Network_SendRtpPacket(SOCKET sock, const RtpHeader* rtp, const uint8_t* payload,
                            uint16_t payload_len, const SOCKADDR_IN* addr);
 
+/**
+ * @brief 创建批量发送器
+ *
+ * 数据报只构造一次, 所有目标以 RIO_MSG_DEFER 排队后一次提交 (一次系统调用);
+ * socket 不支持 RIO 时退回逐个 sendto (仍只构造一次数据报).
+ * @param sock 由 Network_CreateUdpFanout 创建的 socket
+ */
+UdpBatch* Network_CreateUdpBatch(SOCKET sock);
+
+/**
+ * @brief 销毁批量发送器 (在 socket 关闭之后调用, 关闭 socket 会取消在途发送)
+ */
+void Network_DestroyUdpBatch(UdpBatch* batch);
+
+/**
+ * @brief 把同一个 RTP 包发送给多个地址 (线程安全)
+ * @return 成功提交的目标数
+ */
+int Network_SendRtpBatch(UdpBatch* batch, const RtpHeader* rtp, const uint8_t* payload,
+                         uint16_t payload_len, const SOCKADDR_IN* addrs, int count);
+
+/**
+ * @brief 把同一个 RTP 包逐个 sendto 到多个地址 (不加锁, 可与该 socket 上的其他发送并发)
+ *
+ * 用于从不属于本线程的 socket 发出 (该 socket 的 RIO 请求队列只归其所属线程使用).
+ * @return 成功发送的目标数
+ */
+int Network_SendRtpMulti(SOCKET sock, const RtpHeader* rtp, const uint8_t* payload,
+                         uint16_t payload_len, const SOCKADDR_IN* addrs, int count);
+
+/**
+ * @brief 获取批量发送统计
+ */
+void Network_GetUdpBatchStats(UdpBatch* batch, UdpBatchStats* stats);
+
 /**
  * @brief 接收RTP音频包 (UDP)
+ * @param recv_time_us 输出收包时间 (微秒, GetTimeUs 时间基准; 支持时取内核时间戳), 可为 NULL
  * @return payload长度, <0 表示错误
  */
 int Network_RecvRtpPacket(SOCKET sock, RtpHeader* rtp, uint8_t* payload,
-                           uint16_t max_len, SOCKADDR_IN* from);
+                           uint16_t max_len, SOCKADDR_IN* from, uint64_t* recv_time_us);
 
 /**
  * @brief 发送TCP数据 (控制通道)
@@ -93,6 +93,11 @@ int OpusCodec_Decode(OpusCodec* codec, const uint8_t* data, int len,
  */
 int OpusCodec_Plc(OpusCodec* codec, int16_t* pcm, int frame_size);
 
+/**
+ * @brief 重置解码器状态 (切换到另一路流前调用, 避免上一路的预测状态混入)
+ */
+void OpusCodec_ResetDecoder(OpusCodec* codec);
+
 /**
  * @brief 设置编码器码率
  */
@@ -108,6 +113,14 @@ int OpusCodec_GetBitrate(OpusCodec* codec);
  */
 int OpusCodec_SetComplexity(OpusCodec* codec, int complexity);
 
+/**
+ * @brief 上一帧编码时编码器是否处于 DTX 状态
+ * 
+ * DTX 期间编码器每 400ms 输出一个舒适噪声更新帧, 其余帧长度 <= OPUS_DTX_MAX_BYTES, 无需发送.
+ * @return true 表示上一帧为 DTX 帧或舒适噪声更新帧 (opus.dll 不支持查询时返回 false)
+ */
+bool OpusCodec_IsInDtx(OpusCodec* codec);
+
 /**
  * @brief 获取原始解码器指针 (用于 JitterBuffer)
  */
@@ -138,4 +151,12 @@ int OpusCodec_JitterDecode(void* decoder, const uint8_t* data, int len,
  */
 int OpusCodec_JitterPlc(void* decoder, int16_t* pcm, int frame_size);
 
+/**
+ * @brief 根据 TOC 字节计算包时长 (PacketSamplesFunc 签名, 不依赖 opus.dll)
+ * @param data Opus 包
+ * @param len 包长度
+ * @return 48kHz 下的采样数, <0 表示包格式错误
+ */
+int OpusCodec_GetPacketSamples(const uint8_t* data, int len);
+
 #endif // OPUS_CODEC_H
@@ -30,6 +30,8 @@ typedef int32_t opus_int32;
 #define OPUS_SET_PACKET_LOSS_PERC_REQUEST 4014
 #define OPUS_SET_DTX_REQUEST            4016
 #define OPUS_SET_SIGNAL_REQUEST         4024
+#define OPUS_RESET_STATE                4028
+#define OPUS_GET_IN_DTX_REQUEST         4049
 
 // Opus CTL宏
 #define OPUS_SET_BITRATE(x)         OPUS_SET_BITRATE_REQUEST, (opus_int32)(x)
@@ -40,6 +42,7 @@ typedef int32_t opus_int32;
 #define OPUS_SET_PACKET_LOSS_PERC(x) OPUS_SET_PACKET_LOSS_PERC_REQUEST, (opus_int32)(x)
 #define OPUS_SET_DTX(x)             OPUS_SET_DTX_REQUEST, (opus_int32)(x)
 #define OPUS_SET_SIGNAL(x)          OPUS_SET_SIGNAL_REQUEST, (opus_int32)(x)
+#define OPUS_GET_IN_DTX(x)          OPUS_GET_IN_DTX_REQUEST, (opus_int32*)(x)
 
 // 函数指针类型定义
 typedef OpusEncoder* (*opus_encoder_create_fn)(int32_t Fs, int channels, int application, int *error);
@@ -50,6 +53,7 @@ typedef int (*opus_encoder_ctl_fn)(OpusEncoder *st, int request, ...);
 typedef OpusDecoder* (*opus_decoder_create_fn)(int32_t Fs, int channels, int *error);
 typedef void (*opus_decoder_destroy_fn)(OpusDecoder *st);
 typedef int (*opus_decode_fn)(OpusDecoder *st, const unsigned char *data, int32_t len, int16_t *pcm, int frame_size, int decode_fec);
+typedef int (*opus_decoder_ctl_fn)(OpusDecoder *st, int request, ...);
 
 typedef const char* (*opus_strerror_fn)(int error);
 typedef const char* (*opus_get_version_string_fn)(void);
@@ -62,6 +66,7 @@ extern opus_encoder_ctl_fn          p_opus_encoder_ctl;
 extern opus_decoder_create_fn       p_opus_decoder_create;
 extern opus_decoder_destroy_fn      p_opus_decoder_destroy;
 extern opus_decode_fn               p_opus_decode;
+extern opus_decoder_ctl_fn          p_opus_decoder_ctl;
 extern opus_strerror_fn             p_opus_strerror;
 extern opus_get_version_string_fn   p_opus_get_version_string;
 
@@ -35,9 +35,17 @@ typedef enum {
     MSG_PEER_LIST           = 0x0301,   // 用户列表
     MSG_PEER_JOIN           = 0x0302,   // 用户加入
     MSG_PEER_LEAVE          = 0x0303,   // 用户离开
-    MSG_PEER_STATE          = 0x0304    // 用户状态变化
+    MSG_PEER_STATE          = 0x0304,   // 用户状态变化
+    
+    // TCP 房间 (转发与用户列表只在房间内进行, 连接后位于大厅)
+    MSG_ROOM_JOIN           = 0x0401,   // 加入房间 (不存在时创建)
+    MSG_ROOM_JOIN_ACK       = 0x0402,   // 加入房间确认 (成功时随后发送新房间的用户列表)
+    MSG_ROOM_LEAVE          = 0x0403,   // 离开房间 (回到大厅)
+    MSG_ROOM_LIST           = 0x0404    // 房间列表 (请求无负载, 响应后接 RoomInfo 数组)
 } MessageType;
 
+#define ROOM_LOBBY_NAME     "lobby"     // 大厅名称
+
 //=============================================================================
 // RTP Payload Type (音频编码类型)
 //=============================================================================
@@ -75,9 +83,12 @@ typedef struct {
     uint32_t timestamp;     // 采样时间戳 (48kHz 基准)
     uint32_t ssrc;          // 同步源标识符 (发送者ID)
     uint16_t payload_len;   // 负载长度
-    uint16_t flags;         // 标志位: bit0=marker, bit1=vad_active
+    uint16_t flags;         // 标志位: bit0=marker, bit1=vad_active, bit8-14=电平 (见 RtpHeader_SetLevel)
 } RtpHeader;
 
+#define RTP_LEVEL_SHIFT     8
+#define RTP_LEVEL_MAX       127     // 电平 = 127 + dBov (0 dBov 为 127, -127 dBov 及以下或未知为 0)
+
 /**
  * @brief 完整 RTP 音频包
  */
@@ -116,6 +127,7 @@ typedef struct {
 #define CAP_OPUS        0x0001  // 支持 Opus 编码
 #define CAP_VAD         0x0002  // 支持 VAD
 #define CAP_JITTER      0x0004  // 支持 Jitter Buffer
+#define CAP_MCU         0x0008  // 服务器混音 (每个客户端只收到一路 mix-minus 流)
 
 /**
  * @brief HELLO 握手请求 (TCP)
@@ -134,7 +146,8 @@ typedef struct {
     PacketHeader header;
     uint32_t result;            // 0=成功
     uint32_t assigned_id;       // 分配的客户端ID
-    uint16_t audio_udp_port;    // 服务器 UDP 音频端口
+    uint16_t audio_udp_port;    // 本客户端的 UDP 音频端口 (按 SSRC 分配; 多工作线程时可能不是发现响应中的端口,
+                                // 客户端须改发到此端口, 下行音频也从此端口发出)
     uint16_t reserved;
     uint64_t server_time;       // 服务器时间戳 (用于同步)
 } HelloAck;
@@ -220,10 +233,15 @@ typedef struct {
 typedef struct {
     PacketHeader header;
     uint8_t  peer_count;
-    uint8_t  reserved[3];
+    uint8_t  flags;             // PEER_LIST_APPEND
+    uint8_t  reserved[2];
     // 后接 PeerInfo 数组
 } PeerListPacket;
 
+// 一个用户列表包最多容纳的用户数 (房间人数更多时分成多个包发送)
+#define PEER_LIST_MAX_PEERS ((int)((MAX_PACKET_SIZE - sizeof(PeerListPacket)) / sizeof(PeerInfo)))
+#define PEER_LIST_APPEND    0x01    // 接续上一个列表包 (否则替换整个列表)
+
 /**
  * @brief 用户状态通知 (TCP)
  */
@@ -232,6 +250,49 @@ typedef struct {
     PeerInfo peer;
 } PeerNotifyPacket;
 
+/**
+ * @brief 加入房间请求 (TCP)
+ */
+typedef struct {
+    PacketHeader header;
+    char     room_name[MAX_NAME_LEN];   // 空字符串或 ROOM_LOBBY_NAME 为大厅
+} RoomJoinRequest;
+
+/**
+ * @brief 加入房间确认 (TCP)
+ */
+typedef struct {
+    PacketHeader header;
+    uint32_t result;            // 0=成功, 1=房间数已满
+    uint32_t room_id;
+    uint16_t members;           // 加入后的成员数 (含自己)
+    uint16_t reserved;
+    char     room_name[MAX_NAME_LEN];
+} RoomJoinAck;
+
+/**
+ * @brief 房间信息
+ */
+typedef struct {
+    uint32_t room_id;
+    uint16_t members;
+    uint16_t reserved;
+    char     name[MAX_NAME_LEN];
+} RoomInfo;
+
+/**
+ * @brief 房间列表 (TCP)
+ */
+typedef struct {
+    PacketHeader header;
+    uint16_t room_count;
+    uint16_t reserved;
+    // 后接 RoomInfo 数组
+} RoomListPacket;
+
+// 一个房间列表包最多容纳的房间数
+#define ROOM_LIST_MAX_ROOMS ((int)((MAX_PACKET_SIZE - sizeof(RoomListPacket)) / sizeof(RoomInfo)))
+
 #pragma pack(pop)
 
 //=============================================================================
@@ -281,6 +342,21 @@ static inline bool RtpHeader_GetVadActive(const RtpHeader* hdr) {
     return (hdr->flags & 0x02) != 0;
 }
 
+/**
+ * @brief 设置发送端电平 (0 ~ RTP_LEVEL_MAX, 见 Audio_ComputeLevel), 服务器据此选择发言者
+ */
+static inline void RtpHeader_SetLevel(RtpHeader* hdr, uint8_t level) {
+    hdr->flags = (uint16_t)((hdr->flags & ~(RTP_LEVEL_MAX << RTP_LEVEL_SHIFT)) |
+                            ((MIN(level, RTP_LEVEL_MAX) & RTP_LEVEL_MAX) << RTP_LEVEL_SHIFT));
+}
+
+/**
+ * @brief 获取发送端电平 (0 为静音或发送端未提供)
+ */
+static inline uint8_t RtpHeader_GetLevel(const RtpHeader* hdr) {
+    return (uint8_t)((hdr->flags >> RTP_LEVEL_SHIFT) & RTP_LEVEL_MAX);
+}
+
 //=============================================================================
 // TCP 报文辅助函数
 //=============================================================================
@@ -0,0 +1,61 @@
+/**
+ * @file resampler.h
+ * @brief 微调重采样 (时钟漂移补偿) 接口
+ *
+ * 用于 Jitter Buffer 输出路径上的发送端时钟漂移补偿:
+ * 发送端声卡时钟与本地相差数十 ppm, 以 out/in = 1 + 漂移 的比例
+ * 对解码 PCM 做连续重采样, 使长时间会话中缓冲级别不随时间漂移.
+ *
+ * 4 点三次 (Catmull-Rom) 插值, Q32 相位累加. 保留上一块末尾的采样,
+ * 块与块之间连续, 因此同一路流的所有 PCM (含 PLC / 舒适噪声) 都须经过它.
+ * 仅支持单声道 16-bit PCM.
+ */
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "common.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define RESAMPLER_TAPS          4           // 插值点数
+#define RESAMPLER_HISTORY       (RESAMPLER_TAPS - 1)    // 跨块保留的采样数
+#define RESAMPLER_MAX_RATIO     1.01f       // 比例上限 (远大于实际声卡漂移)
+#define RESAMPLER_MIN_RATIO     0.99f       // 比例下限
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 重采样状态 (由调用者分配)
+ */
+typedef struct {
+    int16_t  history[RESAMPLER_HISTORY];    // 上一块末尾采样
+    int32_t  pos;                           // 下一个输出采样的整数位置 (相对 history 起点)
+    uint32_t frac;                          // 下一个输出采样的小数位置 (Q32)
+} Resampler;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 初始化 (清空历史)
+ */
+void Resampler_Init(Resampler* rs);
+
+/**
+ * @brief 对一块 PCM 重采样
+ * @param ratio 输出/输入采样数比例 (>1 拉长, <1 缩短, 限制在 [MIN_RATIO, MAX_RATIO])
+ * @param in 输入 PCM
+ * @param in_len 输入采样数
+ * @param out 输出 PCM (不能与 in 重叠)
+ * @param max_out 输出缓冲区最大采样数 (至少 in_len * ratio + 2, 不足时多余输出被丢弃)
+ * @return 输出采样数, <0 表示错误
+ */
+int Resampler_Process(Resampler* rs, float ratio, const int16_t* in, int in_len,
+                      int16_t* out, int max_out);
+
+#endif // RESAMPLER_H
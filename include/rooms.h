@@ -0,0 +1,92 @@
+/**
+ * @file rooms.h
+ * @brief 服务器房间表 (命名房间 + 成员列表)
+ *
+ * 每个会话恰好属于一个房间, 连接建立时进入大厅 (ROOM_LOBBY_ID, 始终存在),
+ * 之后可按名称加入其他房间 (不存在时创建), 最后一个成员离开时房间被删除.
+ * 转发、用户列表与加入/离开通知都只在房间内进行.
+ *
+ * 只由服务器控制面调用 (持有 clients_mutex), 内部不加锁.
+ */
+
+#ifndef ROOMS_H
+#define ROOMS_H
+
+#include "common.h"
+#include "protocol.h"
+#include "session_table.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define ROOM_LOBBY_ID       0               // 大厅
+#define ROOM_MAX_ROOMS      256             // 最多同时存在的房间数 (含大厅)
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 房间
+ */
+typedef struct {
+    uint32_t        id;
+    char            name[MAX_NAME_LEN];
+    SessionHandle*  members;
+    int             member_count;
+    int             member_capacity;
+} Room;
+
+/**
+ * @brief 房间表
+ */
+typedef struct {
+    Room*       rooms[ROOM_MAX_ROOMS];      // 0 号为大厅, 其余按创建顺序 (删除时末项移入空位)
+    int         count;
+    uint32_t    next_id;
+} RoomRegistry;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 初始化 (创建大厅)
+ */
+bool RoomRegistry_Init(RoomRegistry* registry);
+
+/**
+ * @brief 释放所有房间
+ */
+void RoomRegistry_Destroy(RoomRegistry* registry);
+
+/**
+ * @brief 按 ID 查找房间
+ * @return 房间, 不存在返回 NULL
+ */
+Room* RoomRegistry_Get(RoomRegistry* registry, uint32_t room_id);
+
+/**
+ * @brief 按名称查找房间 (空名称或 ROOM_LOBBY_NAME 为大厅)
+ * @return 房间, 不存在返回 NULL
+ */
+Room* RoomRegistry_Find(RoomRegistry* registry, const char* name);
+
+/**
+ * @brief 把会话加入指定名称的房间 (不存在时创建; 空名称或 ROOM_LOBBY_NAME 为大厅)
+ * @return 房间, 房间数已满或内存不足返回 NULL
+ */
+Room* RoomRegistry_Join(RoomRegistry* registry, const char* name, SessionHandle member);
+
+/**
+ * @brief 把会话移出房间 (房间变空时删除, 大厅除外)
+ */
+void RoomRegistry_Leave(RoomRegistry* registry, uint32_t room_id, SessionHandle member);
+
+/**
+ * @brief 导出房间列表
+ * @return 导出的房间数
+ */
+int RoomRegistry_List(const RoomRegistry* registry, RoomInfo* rooms, int max_count);
+
+#endif // ROOMS_H
@@ -0,0 +1,120 @@
+/**
+ * @file route_table.h
+ * @brief 音频转发路由表 (RCU 风格的不可变快照)
+ *
+ * 控制面 (TCP 线程, 持有 clients_mutex) 在加入/离开/静音等变化时构造一张新表并发布,
+ * 音频面 (UDP 接收线程、MCU 线程、本地语音发送) 只读取当前快照:
+ * 1. 读者: Routing_Acquire / Routing_Release, 只有两次原子加减, 从不等待控制面
+ * 2. 写者: Routing_Publish 原子替换指针, 等待宽限期 (所有可能看到旧表的读者退出) 后释放旧表
+ * 3. 快照发布后不再修改, 读者无需任何锁
+ *
+ * 宽限期用按纪元奇偶分开的两个读者计数实现: 写者替换指针后翻转纪元, 只需等待
+ * 旧纪元的计数归零. 读者持有快照期间不得阻塞 (复制所需数据后立即释放).
+ *
+ * 发布时为快照建立两个开放寻址哈希索引 (SSRC -> 路由项, UDP 源地址 -> 路由项),
+ * 音频面查找与会话数无关. 路由项按房间排序, 同一房间的路由项在 entries 中连续,
+ * 收集收听者只需遍历发送者所在房间.
+ */
+
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include "common.h"
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 路由项 (一个已握手的客户端)
+ */
+typedef struct {
+    uint32_t    ssrc;
+    uint32_t    client_id;
+    uint32_t    room;           // 所在房间
+    SOCKADDR_IN addr;           // UDP 音频地址 (receiving 为 false 时无效)
+    bool        receiving;      // 已加入音频会话, 接收转发
+    bool        muted;          // 静音: 不转发其发出的音频
+} RouteEntry;
+
+/**
+ * @brief 路由表快照 (发布后只读)
+ */
+typedef struct {
+    uint32_t    version;        // 发布序号
+    int         count;
+    int         capacity;
+    int         buckets;        // 每个哈希索引的桶数 (2 的幂, 不少于 2 * capacity)
+    RouteEntry  entries[];      // 其后紧跟 SSRC 索引与地址索引 (各 buckets 个 int, -1 为空)
+} RouteTable;
+
+/**
+ * @brief 路由表发布点
+ */
+typedef struct {
+    RouteTable* volatile current;
+    AtomicInt   epoch;
+    AtomicInt   readers[2];     // 按纪元奇偶计数的读者
+    Mutex       write_mutex;    // 串行化写者
+    uint32_t    version;
+} Routing;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 初始化 (发布一张空表)
+ */
+void Routing_Init(Routing* routing);
+
+/**
+ * @brief 释放当前表 (须在所有读者线程停止后调用)
+ */
+void Routing_Destroy(Routing* routing);
+
+/**
+ * @brief 分配一张空表
+ * @param capacity 最大路由项数
+ * @return 新表, 失败返回 NULL
+ */
+RouteTable* RouteTable_Create(int capacity);
+
+/**
+ * @brief 发布新表 (接管所有权), 按房间排序并建立哈希索引后替换, 等待宽限期后释放旧表
+ *
+ * 不得在读者区间内调用.
+ */
+void Routing_Publish(Routing* routing, RouteTable* table);
+
+/**
+ * @brief 进入读者区间并取得当前快照 (不阻塞)
+ * @param token 输出, 传给 Routing_Release
+ */
+const RouteTable* Routing_Acquire(Routing* routing, int* token);
+
+/**
+ * @brief 离开读者区间 (之后不得再访问快照)
+ */
+void Routing_Release(Routing* routing, int token);
+
+/**
+ * @brief 按 SSRC 查找路由项 (O(1))
+ * @return 路由项, 未找到返回 NULL
+ */
+const RouteEntry* RouteTable_Find(const RouteTable* table, uint32_t ssrc);
+
+/**
+ * @brief 按 UDP 源地址查找路由项 (O(1), 只索引 receiving 的路由项)
+ * @return 路由项, 未找到返回 NULL
+ */
+const RouteEntry* RouteTable_FindByAddr(const RouteTable* table, const SOCKADDR_IN* addr);
+
+/**
+ * @brief 查找房间的路由项范围 (二分查找)
+ * @param first 输出, 房间第一个路由项在 entries 中的下标
+ * @return 房间的路由项数, 房间无路由项返回 0
+ */
+int RouteTable_RoomRange(const RouteTable* table, uint32_t room, int* first);
+
+#endif // ROUTE_TABLE_H
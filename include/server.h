@@ -8,6 +8,17 @@
 
 #include "common.h"
 #include "protocol.h"
+#include "mcu.h"
+#include "network.h"
+#include "decode_pool.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define SERVER_DECODE_WORKERS   2       // onAudioReceived 解码线程数
+#define SERVER_MAX_SESSIONS     MAX_SESSIONS    // 最大连接数 (会话表按需增长到此上限; MCU 模式见 MCU_MAX_LISTENERS)
+#define SERVER_DEFAULT_AUDIO_WORKERS 1  // UDP 音频接收/转发线程数 (每个占用一个音频端口)
+#define SERVER_MAX_AUDIO_WORKERS 8
 
 //=============================================================================
 // 服务器事件回调
@@ -17,11 +28,32 @@ typedef struct {
     void (*onStopped)(void* userdata);
     void (*onClientJoined)(uint32_t client_id, const char* name, void* userdata);
     void (*onClientLeft)(uint32_t client_id, void* userdata);
+    // 在解码工作线程中调用 (可能多个线程并发), 不阻塞转发
     void (*onAudioReceived)(uint32_t client_id, const int16_t* pcm, int samples, void* userdata);
     void (*onError)(const char* msg, void* userdata);
     void* userdata;
 } ServerCallbacks;
 
+/**
+ * @brief 转发流水线统计
+ *
+ * 转发延迟 = 收包时间戳 (见 Network_RecvRtpPacket) 到转发给所有收听者完成,
+ * 解码在工作池中进行, 不计入转发延迟. 各 UDP 音频工作线程分别统计, 读取时汇总.
+ */
+typedef struct {
+    uint32_t        packets_received;       // 收到的 RTP 包数
+    uint32_t        packets_forwarded;      // 已转发的包数
+    uint32_t        packets_unknown;        // 丢弃: 源地址与 SSRC 都不属于任何已加入的会话
+    uint32_t        packets_spoofed;        // 丢弃: SSRC 与源地址不属于同一会话
+    uint32_t        packets_suppressed;     // 未转发: 发送者不在房间电平最高的几路之中
+    float           forward_latency_us;     // 平均转发延迟 (微秒)
+    float           forward_latency_max_us; // 峰值转发延迟 (微秒)
+    int             audio_workers;          // UDP 音频工作线程数
+    uint32_t        worker_packets[SERVER_MAX_AUDIO_WORKERS];   // 各工作线程收到的包数
+    DecodePoolStats decode;                 // 解码工作池 (未注册 onAudioReceived 时全为 0)
+    UdpBatchStats   fanout;                 // 批量转发 (系统调用次数)
+} ServerPipelineStats;
+
 //=============================================================================
 // 服务器接口
 //=============================================================================
@@ -36,6 +68,43 @@ bool Server_Init(void);
  */
 void Server_Shutdown(void);
 
+/**
+ * @brief 设置音频路由模式 (下次 Server_Start 生效)
+ * @param enabled true: 服务器混音 (MCU), 每个客户端收到一路 mix-minus;
+ *                false: 逐包转发 (默认), 每个客户端收到 N-1 路
+ */
+void Server_SetMcuMode(bool enabled);
+
+/**
+ * @brief 获取 MCU 统计
+ * @return 服务器运行于 MCU 模式时返回 true
+ */
+bool Server_GetMcuStats(McuStats* stats);
+
+/**
+ * @brief 设置 UDP 音频接收/转发线程数 (下次 Server_Start 生效)
+ *
+ * 每个线程绑定自己的音频端口 (udp_port 起的连续端口, 0 时自动分配), 线程间不共享批量发送器
+ * 与统计; 客户端在 HELLO_ACK 中得到按 SSRC 分配的端口, 同一发送者的包总由同一线程按序转发.
+ * 发给其他线程的收听者时直接 sendto 对方的端口 (收听者只从自己的端口收到音频).
+ * @param count 1 ~ SERVER_MAX_AUDIO_WORKERS
+ */
+void Server_SetAudioWorkers(int count);
+
+/**
+ * @brief 设置转发模式下每个房间转发的发言者数 (下次 Server_Start 生效)
+ * @param count 按 VAD 与发送端电平选出最响的 count 路 (默认 SPEAKER_DEFAULT_FORWARD,
+ *              最多 SPEAKER_MAX_FORWARD), 每个收听者的下行与解码量与房间人数无关;
+ *              0 为全部转发
+ */
+void Server_SetMaxSpeakers(int count);
+
+/**
+ * @brief 获取转发流水线统计
+ * @return 服务器运行中返回 true
+ */
+bool Server_GetPipelineStats(ServerPipelineStats* stats);
+
 /**
  * @brief 启动服务器
  * @param name 服务器名称
@@ -87,8 +156,11 @@ int Server_GetClients(PeerInfo* peers, int max_count);
  * @param opus_data Opus 编码数据
  * @param opus_len 数据长度
  * @param timestamp 采样时间戳
+ * @param voice 是否为语音帧 (false: DTX 期间的舒适噪声更新帧); DTX 帧本身不发送
+ * @param level 这一帧的电平 (见 Audio_ComputeLevel), 用于发言者选择
  */
-void Server_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp);
+void Server_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp, bool voice,
+                          uint8_t level);
 
 /**
  * @brief 广播音频控制消息 (TCP)
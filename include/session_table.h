@@ -0,0 +1,91 @@
+/**
+ * @file session_table.h
+ * @brief 动态会话表 (分页槽位 + 带代数的稳定句柄)
+ *
+ * 会话数不再受固定数组限制:
+ * 1. 槽位按页分配 (每页 SESSION_TABLE_PAGE_SIZE 个), 需要时才分配新页, 页在表销毁前不释放,
+ *    因此槽位地址固定不变, 持有的会话指针不会因扩容而失效
+ * 2. 句柄 = 槽位号 | 代数 << 16, 槽位每次复用代数加一, 过期句柄解析为 NULL
+ * 3. 空闲槽位用链表管理, 分配与释放都是 O(1)
+ *
+ * 所有操作 (包括 SessionTable_Get) 都由调用者加锁 (服务器的 clients_mutex).
+ * 音频面不访问会话: 它需要的字段在路由快照 (route_table.h) 中, 电平与讲话状态由音频工作线程
+ * 自己保存; 不加锁读写会话会与控制面的释放复用竞争.
+ */
+
+#ifndef SESSION_TABLE_H
+#define SESSION_TABLE_H
+
+#include "common.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define SESSION_TABLE_PAGE_SIZE     64              // 每页槽位数
+#define SESSION_TABLE_MAX_PAGES     64              // 最多 4096 个槽位
+#define SESSION_HANDLE_INVALID      0
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 会话句柄 (0 为无效句柄)
+ */
+typedef uint32_t SessionHandle;
+
+/**
+ * @brief 会话表
+ */
+typedef struct {
+    uint8_t*    pages[SESSION_TABLE_MAX_PAGES];
+    size_t      item_size;      // 会话结构大小
+    size_t      slot_size;      // 槽位大小 (槽位头 + 会话, 8 字节对齐)
+    int         max_slots;      // 槽位上限
+    int         limit;          // 已分配页覆盖的槽位数 (遍历上界)
+    int         count;          // 使用中的会话数
+    int         free_head;      // 空闲槽位链表头 (-1 为空)
+} SessionTable;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 初始化 (不预分配槽位)
+ * @param item_size 会话结构大小
+ * @param max_sessions 会话数上限 (最多 SESSION_TABLE_PAGE_SIZE * SESSION_TABLE_MAX_PAGES)
+ */
+void SessionTable_Init(SessionTable* table, size_t item_size, int max_sessions);
+
+/**
+ * @brief 释放所有页 (之后所有句柄与会话指针失效)
+ */
+void SessionTable_Destroy(SessionTable* table);
+
+/**
+ * @brief 分配一个会话 (内容清零)
+ * @param handle 输出句柄
+ * @return 会话, 已满或内存不足返回 NULL
+ */
+void* SessionTable_Alloc(SessionTable* table, SessionHandle* handle);
+
+/**
+ * @brief 释放会话 (句柄过期时忽略)
+ */
+void SessionTable_Free(SessionTable* table, SessionHandle handle);
+
+/**
+ * @brief 按句柄解析会话
+ * @return 会话, 句柄无效或已过期返回 NULL
+ */
+void* SessionTable_Get(const SessionTable* table, SessionHandle handle);
+
+/**
+ * @brief 按槽位号访问 (遍历用, 0 <= slot < table->limit)
+ * @param handle 输出句柄, 可为 NULL
+ * @return 会话, 槽位空闲返回 NULL
+ */
+void* SessionTable_At(const SessionTable* table, int slot, SessionHandle* handle);
+
+#endif // SESSION_TABLE_H
@@ -0,0 +1,80 @@
+/**
+ * @file speaker_selector.h
+ * @brief 活跃发言者选择 (每个房间只转发最响的 K 路)
+ *
+ * 大房间里多数转发的包只是背景噪声, 每个客户端还要逐路解码混音.
+ * 服务器按包头中的 VAD 标志与发送端电平 (见 RtpHeader_SetLevel) 给发送者排名,
+ * 每个房间只保留 K 个"发言席位", 只有占据席位的发送者被转发:
+ * 1. 电平平滑: 上升快 (约 2 帧), 下降慢 (约 8 帧), 句间停顿不会立刻失去席位
+ * 2. 迟滞: 新发送者的平滑电平须比席位中最弱者高出 SPEAKER_HYSTERESIS, 且最弱者
+ *    已占据席位至少 SPEAKER_MIN_HOLD_MS (最弱者已静音时除外), 才能取而代之
+ * 3. 超过 SPEAKER_IDLE_MS 没有包的席位视为空闲 (DTX 期间发送端不发包)
+ *
+ * 因此每个收听者的下行最多 K 路, 与房间人数无关.
+ * 线程安全 (按房间分段加锁, 临界区只有几次比较; 不同分段的房间可并行处理).
+ */
+
+#ifndef SPEAKER_SELECTOR_H
+#define SPEAKER_SELECTOR_H
+
+#include "common.h"
+#include "protocol.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define SPEAKER_DEFAULT_FORWARD     3               // 默认每个房间转发的发言者数
+#define SPEAKER_MAX_FORWARD         16              // 每个房间转发的发言者数上限
+#define SPEAKER_HYSTERESIS          6               // 抢占席位所需的电平差 (dB)
+#define SPEAKER_MIN_HOLD_MS         600             // 席位最短保持时间
+#define SPEAKER_IDLE_MS             500             // 超过此时间无包的席位视为空闲
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 选择器实例
+ */
+typedef struct SpeakerSelector SpeakerSelector;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 创建选择器
+ * @param max_forward 每个房间转发的发言者数 (1 ~ SPEAKER_MAX_FORWARD)
+ * @return 选择器实例, 失败返回 NULL
+ */
+SpeakerSelector* SpeakerSelector_Create(int max_forward);
+
+/**
+ * @brief 销毁选择器
+ */
+void SpeakerSelector_Destroy(SpeakerSelector* selector);
+
+/**
+ * @brief 由包头更新发送者的平滑电平
+ * @param previous 上一次的平滑电平 (首包为 0)
+ * @return 新的平滑电平 (0 ~ RTP_LEVEL_MAX, 0 为静音)
+ */
+uint8_t SpeakerSelector_Smooth(uint8_t previous, const RtpHeader* rtp);
+
+/**
+ * @brief 判断发送者的这个包是否转发
+ * @param room 发送者所在房间
+ * @param level 发送者的平滑电平 (见 SpeakerSelector_Smooth)
+ * @param now_ms 当前时间 (毫秒)
+ * @param promoted 输出: 本包刚获得席位 (转发时应置 marker, 收听端从新讲话段开始缓冲)
+ * @return true 转发, false 丢弃
+ */
+bool SpeakerSelector_Admit(SpeakerSelector* selector, uint32_t room, uint32_t ssrc,
+                           uint8_t level, uint64_t now_ms, bool* promoted);
+
+/**
+ * @brief 释放发送者的席位 (离开房间或断开时调用)
+ */
+void SpeakerSelector_Remove(SpeakerSelector* selector, uint32_t room, uint32_t ssrc);
+
+#endif // SPEAKER_SELECTOR_H
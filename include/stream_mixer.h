@@ -0,0 +1,116 @@
+/**
+ * @file stream_mixer.h
+ * @brief 多路接收混音器 (每个 SSRC 独立 JitterBuffer + 解码器)
+ *
+ * StreamMixer 用于:
+ * 1. 按 SSRC 将 RTP 包分发到各自的 JitterBuffer
+ * 2. 每路使用独立的 Opus 解码器 (PLC/解码状态互不干扰)
+ * 3. 播放时逐路同步取帧, 经 Audio_Mix 混合为一帧输出
+ * 4. 按路统计丢包/补偿, 超时或离开的流自动回收
+ *
+ * 客户端播放用 StreamMixer_Mix; 服务器 MCU 用 StreamMixer_GetFrames 取各路 PCM
+ * 与总和, 对每个收听者减去其自身一路得到 mix-minus.
+ */
+
+#ifndef STREAM_MIXER_H
+#define STREAM_MIXER_H
+
+#include "common.h"
+#include "protocol.h"
+#include "jitter_buffer.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define MIXER_MAX_STREAMS       64                  // 最大同时接收流数 (客户端收到的流受服务器发言者选择限制,
+                                                    // 不限发言者时超出的流被忽略; MCU 模式见 MCU_MAX_LISTENERS)
+#define MIXER_STREAM_TIMEOUT    HEARTBEAT_TIMEOUT   // 流空闲回收时间 (毫秒)
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief StreamMixer 实例
+ */
+typedef struct StreamMixer StreamMixer;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 创建混音器
+ * @param config 每路 JitterBuffer 配置 (NULL 使用默认配置)
+ * @return StreamMixer 实例
+ */
+StreamMixer* StreamMixer_Create(const JitterConfig* config);
+
+/**
+ * @brief 销毁混音器 (同时销毁所有流)
+ */
+void StreamMixer_Destroy(StreamMixer* mixer);
+
+/**
+ * @brief 重置混音器 (移除所有流, 须在收发线程停止时调用)
+ */
+void StreamMixer_Reset(StreamMixer* mixer);
+
+/**
+ * @brief 放入 RTP 包 (按 SSRC 分发, 首包时创建流)
+ * @param recv_time_us 收包时间 (微秒, 见 Network_RecvRtpPacket), 0 表示取当前时间
+ * @return 0 成功, <0 失败
+ */
+int StreamMixer_Put(StreamMixer* mixer, const RtpHeader* rtp,
+                    const uint8_t* payload, uint16_t payload_len, uint64_t recv_time_us);
+
+/**
+ * @brief 从所有流各取相同数量的采样并混合
+ * @param mixer StreamMixer 实例
+ * @param samples 输出 PCM 缓冲区
+ * @param num_samples 请求的采样数 (可小于一帧, 超过一帧时只混合一帧)
+ * @return 实际采样数, 0 表示所有流均无数据, <0 表示错误
+ */
+int StreamMixer_Mix(StreamMixer* mixer, int16_t* samples, int num_samples);
+
+/**
+ * @brief 从所有流各取一帧, 输出各路 PCM 与逐点总和 (供 mix-minus 使用)
+ * @param num_samples 采样数 (不超过 AUDIO_FRAME_SAMPLES)
+ * @param ssrcs 输出有数据的流 SSRC (至少 MIXER_MAX_STREAMS 项)
+ * @param pcm 输出对应各路 PCM (指向混音器内部缓冲, 有效至下次取帧)
+ * @param total 输出各路逐点求和 (num_samples 项, 未限幅)
+ * @return 有数据的流数, <0 表示错误
+ */
+int StreamMixer_GetFrames(StreamMixer* mixer, int num_samples, uint32_t* ssrcs,
+                          const int16_t** pcm, int32_t* total);
+
+/**
+ * @brief 移除指定流 (延迟到播放线程回收)
+ */
+void StreamMixer_RemoveStream(StreamMixer* mixer, uint32_t ssrc);
+
+/**
+ * @brief 获取当前流数量
+ */
+int StreamMixer_GetStreamCount(StreamMixer* mixer);
+
+/**
+ * @brief 获取单路统计信息 (读取快照, 不阻塞播放线程)
+ * @param level_ms 输出该路缓冲级别 (可为 NULL)
+ * @return 流存在返回 true
+ */
+bool StreamMixer_GetStreamStats(StreamMixer* mixer, uint32_t ssrc,
+                                JitterStats* stats, int* level_ms);
+
+/**
+ * @brief 获取单路统计快照 (含缓冲延迟/到达抖动/连续补偿直方图)
+ * @return 流存在且读取成功返回 true
+ */
+bool StreamMixer_GetStreamSnapshot(StreamMixer* mixer, uint32_t ssrc, JitterSnapshot* snap);
+
+/**
+ * @brief 获取汇总统计信息 (计数求和, 抖动/缓冲级别取最大值; 读取快照, 不阻塞播放线程)
+ */
+void StreamMixer_GetStats(StreamMixer* mixer, JitterStats* stats, int* level_ms);
+
+#endif // STREAM_MIXER_H
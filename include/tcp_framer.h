@@ -0,0 +1,96 @@
+/**
+ * @file tcp_framer.h
+ * @brief TCP 控制报文分帧 (每连接一个环形缓冲) 与发送队列
+ *
+ * recv 直接写入环形缓冲的连续空闲区, 完整报文在缓冲中连续时原地返回指针,
+ * 只有跨越缓冲末尾的报文才复制到调用者提供的临时缓冲; 消费报文只移动读位置,
+ * 不再在每个报文后 memmove 剩余数据. 缓冲读空时读写位置回到起点,
+ * 因此通常一次 recv 收到的报文都是连续的.
+ *
+ * 发送队列用于非阻塞 socket: 先直接 send, 发不完的部分排队, socket 可写时再发;
+ * 队列在第一次积压时才分配, 积压超过 TCP_SEND_QUEUE_LIMIT 视为对端不再接收.
+ *
+ * 由单个线程使用, 内部不加锁.
+ */
+
+#ifndef TCP_FRAMER_H
+#define TCP_FRAMER_H
+
+#include "common.h"
+#include "protocol.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define TCP_FRAMER_RING_SIZE    (2 * MAX_PACKET_SIZE)   // 2 的幂, 不小于 MAX_PACKET_SIZE
+#define TCP_SEND_QUEUE_LIMIT    (64 * MAX_PACKET_SIZE)  // 每连接最多积压的字节数 (容得下满员房间的整份用户列表)
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 分帧器 (读写位置单调递增, 按 TCP_FRAMER_RING_SIZE 取模得到下标)
+ */
+typedef struct {
+    uint8_t*    ring;
+    uint32_t    head;           // 读位置
+    uint32_t    tail;           // 写位置
+} TcpFramer;
+
+/**
+ * @brief 发送队列 (未发出的字节, 按发送顺序)
+ */
+typedef struct {
+    uint8_t*    buf;
+    int         len;
+    int         capacity;
+} TcpSendQueue;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 分配环形缓冲
+ */
+bool TcpFramer_Init(TcpFramer* framer);
+
+/**
+ * @brief 释放环形缓冲
+ */
+void TcpFramer_Free(TcpFramer* framer);
+
+/**
+ * @brief 从 socket 接收一次 (写入连续空闲区; socket 可读时调用)
+ * @return recv 的返回值 (<= 0 表示连接关闭或出错)
+ */
+int TcpFramer_Recv(TcpFramer* framer, SOCKET sock);
+
+/**
+ * @brief 取出下一个完整报文
+ * @param frame 输出报文指针 (缓冲内原地或 scratch), 在下一次 TcpFramer_Recv 之前有效
+ * @param scratch 报文跨越缓冲末尾时使用的临时缓冲 (MAX_PACKET_SIZE 字节)
+ * @return 报文长度; 0 表示尚无完整报文; -1 表示报文头无效或超长 (已丢弃缓冲中的数据)
+ */
+int TcpFramer_Next(TcpFramer* framer, const uint8_t** frame, uint8_t* scratch);
+
+/**
+ * @brief 发送一个报文 (非阻塞 socket; 队列非空时直接排在队尾, 保持顺序)
+ * @return 仍在排队的字节数 (>0 时需等 socket 可写后调用 TcpSendQueue_Flush);
+ *         -1 表示连接出错或积压超过 TCP_SEND_QUEUE_LIMIT
+ */
+int TcpSendQueue_Send(TcpSendQueue* queue, SOCKET sock, const void* data, int len);
+
+/**
+ * @brief 尽量发出排队的数据 (socket 可写时调用)
+ * @return 仍在排队的字节数, -1 表示连接出错
+ */
+int TcpSendQueue_Flush(TcpSendQueue* queue, SOCKET sock);
+
+/**
+ * @brief 释放发送队列
+ */
+void TcpSendQueue_Free(TcpSendQueue* queue);
+
+#endif // TCP_FRAMER_H
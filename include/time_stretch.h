@@ -0,0 +1,52 @@
+/**
+ * @file time_stretch.h
+ * @brief WSOLA 时间伸缩 (加速/减速) 接口
+ *
+ * 用于 Jitter Buffer 输出路径上的平滑延迟调整:
+ * 1. 加速: 删除一段与后续波形最相似的片段, 帧变短
+ * 2. 减速: 重复一段与前面波形最相似的片段, 帧变长
+ * 3. 拼接点使用互相关搜索 + 交叉淡化, 避免爆音
+ *
+ * 仅支持单声道 16-bit PCM, 每帧只做一次拼接, 无内部状态.
+ */
+
+#ifndef TIME_STRETCH_H
+#define TIME_STRETCH_H
+
+#include "common.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define TSM_OVERLAP_SAMPLES (AUDIO_SAMPLE_RATE * 5 / 1000)     // 交叉淡化长度 (5ms)
+#define TSM_MIN_LAG_SAMPLES (AUDIO_SAMPLE_RATE * 1 / 1000)     // 最小伸缩量 (1ms)
+#define TSM_MAX_LAG_SAMPLES (AUDIO_SAMPLE_RATE * 5 / 1000)     // 最大伸缩量 (5ms)
+#define TSM_MIN_CORRELATION 0.6f                                // 拼接所需最小归一化相关
+#define TSM_SILENCE_ENERGY  100                                 // 低于此 RMS 视为静音, 任意拼接
+
+/**
+ * @brief 时间伸缩模式
+ */
+typedef enum {
+    TSM_NORMAL      = 0,    // 不处理
+    TSM_ACCELERATE  = 1,    // 加速 (缩短)
+    TSM_DECELERATE  = 2     // 减速 (拉长)
+} TsmMode;
+
+//=============================================================================
+// 公共接口
+//=============================================================================
+
+/**
+ * @brief 对一帧 PCM 做时间伸缩
+ * @param mode 伸缩模式
+ * @param in 输入 PCM
+ * @param in_len 输入采样数 (至少 2 * TSM_OVERLAP_SAMPLES + TSM_MAX_LAG_SAMPLES)
+ * @param out 输出 PCM (不能与 in 重叠)
+ * @param max_out 输出缓冲区最大采样数 (至少 in_len + TSM_MAX_LAG_SAMPLES)
+ * @return 输出采样数; 找不到合适拼接点时原样复制, 返回 in_len; <0 表示错误
+ */
+int TimeStretch_Process(TsmMode mode, const int16_t* in, int in_len,
+                        int16_t* out, int max_out);
+
+#endif // TIME_STRETCH_H
@@ -4,6 +4,8 @@
  */
 
 #include "audio.h"
+#include "protocol.h"
+#include <math.h>
 
 //=============================================================================
 // 内部常量
@@ -350,3 +352,18 @@ void Audio_Mix(int16_t* output, const int16_t** inputs, int input_count, int sam
         output[i] = (int16_t)CLAMP(sum, -32768, 32767);
     }
 }
+
+uint8_t Audio_ComputeLevel(const int16_t* samples, int count) {
+    if (!samples || count <= 0) return 0;
+    
+    double energy = 0;
+    for (int i = 0; i < count; i++) {
+        energy += (double)samples[i] * samples[i];
+    }
+    if (energy <= 0) return 0;
+    
+    // 均方根相对满幅的 dBov, 映射到 0 ~ RTP_LEVEL_MAX
+    double dbov = 10.0 * log10(energy / count / (32768.0 * 32768.0));
+    int level = RTP_LEVEL_MAX + (int)lround(dbov);
+    return (uint8_t)CLAMP(level, 0, RTP_LEVEL_MAX);
+}
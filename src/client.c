@@ -5,13 +5,14 @@
  * 架构:
  * - UDP 发现线程: 发送广播, 接收服务器响应
  * - TCP 控制线程: 会话管理、心跳、音频控制
- * - UDP 音频线程: 接收 RTP 包 -> JitterBuffer -> 解码 -> 播放
- * - 播放线程: 从 JitterBuffer 取数据播放
+ * - UDP 音频线程: 接收 RTP 包 -> 按 SSRC 分发到各路 JitterBuffer
+ * - 播放线程: 各路同步取帧 -> 解码 -> 混音 -> 播放
  */
 
 #include "client.h"
+#include "stream_mixer.h"
+#include "jitter_trace.h"
 #include "opus_codec.h"
-#include "jitter_buffer.h"
 #include "audio.h"
 
 //=============================================================================
@@ -45,10 +46,11 @@ typedef struct {
     int             server_count;
     Mutex           servers_mutex;
     
-    // 在线用户
-    PeerInfo        peers[MAX_CLIENTS];
+    // 在线用户 (当前房间)
+    PeerInfo        peers[MAX_SESSIONS];
     int             peer_count;
     Mutex           peers_mutex;
+    char            room[MAX_NAME_LEN];
     
     // 线程
     Thread          discovery_thread;
@@ -65,12 +67,14 @@ typedef struct {
     // RTP 发送
     uint16_t        rtp_sequence;
     uint32_t        rtp_timestamp;
+    bool            rtp_marker;         // 下一个包置 marker (新讲话段)
     
-    // Opus 解码器
-    OpusCodec*      opus_decoder;
+    // 多路接收混音 (每个 SSRC 独立 JitterBuffer + 解码器)
+    StreamMixer*    mixer;
     
-    // Jitter Buffer
-    JitterBuffer*   jitter_buffer;
+    // 到达轨迹录制 (离线回放调参用)
+    JitterTrace*    jitter_trace;
+    Mutex           trace_mutex;
     
     // 回调
     ClientCallbacks callbacks;
@@ -98,6 +102,7 @@ bool Client_Init(void) {
     memset(&g_client, 0, sizeof(g_client));
     MutexInit(&g_client.servers_mutex);
     MutexInit(&g_client.peers_mutex);
+    MutexInit(&g_client.trace_mutex);
     
     g_client.client_id = (uint32_t)time(NULL) ^ GetCurrentProcessId();
     g_client.ssrc = g_client.client_id;
@@ -114,9 +119,11 @@ void Client_Shutdown(void) {
     
     Client_StopDiscovery();
     Client_Disconnect();
+    Client_StopJitterTrace();
     
     MutexDestroy(&g_client.servers_mutex);
     MutexDestroy(&g_client.peers_mutex);
+    MutexDestroy(&g_client.trace_mutex);
     g_client.initialized = false;
     
     LOG_INFO("Client module shutdown");
@@ -225,41 +232,25 @@ bool Client_Connect(const char* ip, uint16_t tcp_port, uint16_t audio_udp_port)
     g_client.current_server.tcp_port = tcp_port;
     g_client.current_server.audio_udp_port = audio_udp_port;
     
-    // 创建 Opus 解码器
-    OpusDecoderConfig dec_config;
-    OpusCodec_GetDefaultDecoderConfig(&dec_config);
-    g_client.opus_decoder = OpusCodec_Create(NULL, &dec_config);
-    if (!g_client.opus_decoder) {
+    // 创建多路混音器 (解码器和 Jitter Buffer 按 SSRC 延迟创建)
+    g_client.mixer = StreamMixer_Create(NULL);
+    if (!g_client.mixer) {
         Network_CloseSocket(g_client.tcp_control);
         Network_CloseSocket(g_client.udp_audio);
-        LOG_ERROR("Failed to create Opus decoder");
+        LOG_ERROR("Failed to create stream mixer");
         return false;
     }
     
-    // 创建 Jitter Buffer
-    g_client.jitter_buffer = JitterBuffer_Create(NULL);
-    if (!g_client.jitter_buffer) {
-        OpusCodec_Destroy(g_client.opus_decoder);
-        Network_CloseSocket(g_client.tcp_control);
-        Network_CloseSocket(g_client.udp_audio);
-        LOG_ERROR("Failed to create Jitter Buffer");
-        return false;
-    }
-    
-    // 配置 Jitter Buffer 解码器
-    JitterBuffer_SetDecoder(g_client.jitter_buffer, 
-                            OpusCodec_GetDecoder(g_client.opus_decoder),
-                            OpusCodec_JitterDecode);
-    JitterBuffer_SetPlc(g_client.jitter_buffer, OpusCodec_JitterPlc);
-    
     g_client.stop_event = EventCreate();
     g_client.connected = true;
     g_client.recv_len = 0;
     g_client.rtp_sequence = 0;
     g_client.rtp_timestamp = 0;
+    g_client.rtp_marker = true;
     
     MutexLock(&g_client.peers_mutex);
     g_client.peer_count = 0;
+    strncpy(g_client.room, ROOM_LOBBY_NAME, MAX_NAME_LEN - 1);
     MutexUnlock(&g_client.peers_mutex);
     
     // 启动线程
@@ -307,16 +298,10 @@ void Client_Disconnect(void) {
     
     EventDestroy(g_client.stop_event);
     
-    // 销毁 Opus 解码器
-    if (g_client.opus_decoder) {
-        OpusCodec_Destroy(g_client.opus_decoder);
-        g_client.opus_decoder = NULL;
-    }
-    
-    // 销毁 Jitter Buffer
-    if (g_client.jitter_buffer) {
-        JitterBuffer_Destroy(g_client.jitter_buffer);
-        g_client.jitter_buffer = NULL;
+    // 销毁混音器 (含各路解码器和 Jitter Buffer)
+    if (g_client.mixer) {
+        StreamMixer_Destroy(g_client.mixer);
+        g_client.mixer = NULL;
     }
     
     g_client.tcp_control = INVALID_SOCKET;
@@ -349,8 +334,8 @@ bool Client_JoinSession(void) {
     
     g_client.in_session = true;
     
-    // 重置 Jitter Buffer
-    JitterBuffer_Reset(g_client.jitter_buffer);
+    // 清空上次会话的接收流
+    StreamMixer_Reset(g_client.mixer);
     
     // 启动 UDP 音频接收和播放线程
     ThreadCreate(&g_client.udp_audio_thread, UdpAudioRecvThreadProc, NULL);
@@ -383,22 +368,69 @@ bool Client_IsInSession(void) {
     return g_client.in_session;
 }
 
+bool Client_JoinRoom(const char* room_name) {
+    if (!g_client.connected) return false;
+    
+    RoomJoinRequest req;
+    memset(&req, 0, sizeof(req));
+    PacketHeader_Init(&req.header, MSG_ROOM_JOIN, sizeof(RoomJoinRequest) - sizeof(PacketHeader));
+    if (room_name) {
+        strncpy(req.room_name, room_name, MAX_NAME_LEN - 1);
+    }
+    
+    if (Network_TcpSend(g_client.tcp_control, &req, sizeof(req)) != sizeof(req)) {
+        LOG_ERROR("Failed to send ROOM_JOIN");
+        return false;
+    }
+    return true;
+}
+
+void Client_LeaveRoom(void) {
+    if (!g_client.connected) return;
+    
+    PacketHeader pkt;
+    PacketHeader_Init(&pkt, MSG_ROOM_LEAVE, 0);
+    Network_TcpSend(g_client.tcp_control, &pkt, sizeof(pkt));
+}
+
+bool Client_RequestRoomList(void) {
+    if (!g_client.connected) return false;
+    
+    PacketHeader pkt;
+    PacketHeader_Init(&pkt, MSG_ROOM_LIST, 0);
+    return Network_TcpSend(g_client.tcp_control, &pkt, sizeof(pkt)) == sizeof(pkt);
+}
+
+const char* Client_GetRoom(void) {
+    return g_client.room;
+}
+
 bool Client_GetCurrentServer(ServerInfo* server) {
     if (!g_client.connected || !server) return false;
     *server = g_client.current_server;
     return true;
 }
 
-void Client_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp) {
+void Client_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp, bool voice,
+                          uint8_t level) {
     if (!g_client.in_session || !opus_data || opus_len <= 0) return;
     
+    // DTX 帧不发送 (接收端按时间戳间隙生成舒适噪声), 之后的语音包标记为新讲话段
+    if (opus_len <= OPUS_DTX_MAX_BYTES) {
+        g_client.rtp_marker = true;
+        return;
+    }
+    
     // 构建 RTP 包
     RtpHeader rtp;
     RtpHeader_Init(&rtp, g_client.ssrc, PAYLOAD_OPUS);
     rtp.sequence = g_client.rtp_sequence++;
     rtp.timestamp = timestamp;
     rtp.payload_len = opus_len;
-    RtpHeader_SetVadActive(&rtp, true);
+    RtpHeader_SetVadActive(&rtp, voice);
+    RtpHeader_SetLevel(&rtp, level);
+    RtpHeader_SetMarker(&rtp, voice && g_client.rtp_marker);
+    g_client.rtp_marker = !voice;
     
     // 发送到服务器
     Network_SendRtpPacket(g_client.udp_audio, &rtp, opus_data, opus_len, 
@@ -416,25 +448,49 @@ int Client_GetPeers(PeerInfo* peers, int max_count) {
 }
 
 void Client_GetJitterStats(float* jitter_ms, float* loss_rate, int* buffer_level) {
-    if (!g_client.jitter_buffer) {
-        if (jitter_ms) *jitter_ms = 0;
-        if (loss_rate) *loss_rate = 0;
-        if (buffer_level) *buffer_level = 0;
-        return;
-    }
-    
     JitterStats stats;
-    JitterBuffer_GetStats(g_client.jitter_buffer, &stats);
+    int level = 0;
+    StreamMixer_GetStats(g_client.mixer, &stats, &level);
     
     if (jitter_ms) *jitter_ms = stats.avg_jitter_ms;
     if (loss_rate) *loss_rate = stats.loss_rate;
-    if (buffer_level) *buffer_level = JitterBuffer_GetLevel(g_client.jitter_buffer);
+    if (buffer_level) *buffer_level = level;
+}
+
+bool Client_GetStreamStats(uint32_t ssrc, JitterStats* stats, int* buffer_level) {
+    return StreamMixer_GetStreamStats(g_client.mixer, ssrc, stats, buffer_level);
+}
+
+bool Client_GetStreamSnapshot(uint32_t ssrc, JitterSnapshot* snap) {
+    return StreamMixer_GetStreamSnapshot(g_client.mixer, ssrc, snap);
 }
 
 uint32_t Client_GetSSRC(void) {
     return g_client.ssrc;
 }
 
+bool Client_StartJitterTrace(const char* path) {
+    JitterTrace* trace = JitterTrace_Create(path);
+    if (!trace) return false;
+    
+    MutexLock(&g_client.trace_mutex);
+    JitterTrace* old = g_client.jitter_trace;
+    g_client.jitter_trace = trace;
+    MutexUnlock(&g_client.trace_mutex);
+    
+    JitterTrace_Close(old);
+    return true;
+}
+
+void Client_StopJitterTrace(void) {
+    MutexLock(&g_client.trace_mutex);
+    JitterTrace* trace = g_client.jitter_trace;
+    g_client.jitter_trace = NULL;
+    MutexUnlock(&g_client.trace_mutex);
+    
+    JitterTrace_Close(trace);
+}
+
 //=============================================================================
 // 内部函数实现
 //=============================================================================
@@ -596,16 +652,25 @@ static DWORD WINAPI UdpAudioRecvThreadProc(LPVOID param) {
     
     while (g_client.in_session) {
         SOCKADDR_IN from;
+        uint64_t recv_us;
         int payload_len = Network_RecvRtpPacket(g_client.udp_audio, &rtp, payload,
-                                                 sizeof(payload), &from);
+                                                 sizeof(payload), &from, &recv_us);
         
         if (payload_len <= 0) continue;
         
         // 跳过自己的包
         if (rtp.ssrc == g_client.ssrc) continue;
         
-        // 放入 Jitter Buffer
-        JitterBuffer_Put(g_client.jitter_buffer, &rtp, payload, payload_len);
+        // 录制到达轨迹
+        if (g_client.jitter_trace) {
+            MutexLock(&g_client.trace_mutex);
+            JitterTrace_Write(g_client.jitter_trace, &rtp, payload, (uint16_t)payload_len,
+                              OpusCodec_GetPacketSamples(payload, payload_len), recv_us);
+            MutexUnlock(&g_client.trace_mutex);
+        }
+        
+        // 按 SSRC 放入对应的 Jitter Buffer
+        StreamMixer_Put(g_client.mixer, &rtp, payload, payload_len, recv_us);
     }
     
     LOG_DEBUG("UDP audio recv thread stopped");
@@ -618,8 +683,8 @@ static DWORD WINAPI PlaybackThreadProc(LPVOID param) {
     int16_t pcm[AUDIO_FRAME_SAMPLES];
     
     while (g_client.in_session) {
-        // 从 Jitter Buffer 获取音频
-        int samples = JitterBuffer_Get(g_client.jitter_buffer, pcm, AUDIO_FRAME_SAMPLES);
+        // 各路同步取一帧并混音
+        int samples = StreamMixer_Mix(g_client.mixer, pcm, AUDIO_FRAME_SAMPLES);
         
         if (samples > 0) {
             // 回调
@@ -661,17 +726,23 @@ static void HandleTcpPacket(const uint8_t* data, int len) {
         PeerListPacket* list = (PeerListPacket*)data;
         PeerInfo* peers = (PeerInfo*)(data + sizeof(PeerListPacket));
         
+        int count = MIN(list->peer_count, PEER_LIST_MAX_PEERS);
+        
+        // 房间人数超过一个包的容量时, 后续的包接在前面的列表之后
         MutexLock(&g_client.peers_mutex);
-        g_client.peer_count = MIN(list->peer_count, MAX_CLIENTS);
-        for (int i = 0; i < g_client.peer_count; i++) {
-            g_client.peers[i] = peers[i];
+        if (!(list->flags & PEER_LIST_APPEND)) {
+            g_client.peer_count = 0;
+        }
+        for (int i = 0; i < count && g_client.peer_count < MAX_SESSIONS; i++) {
+            g_client.peers[g_client.peer_count++] = peers[i];
         }
         MutexUnlock(&g_client.peers_mutex);
         
-        LOG_INFO("Peer list received: %d peers", list->peer_count);
+        LOG_INFO("Peer list received: %d peers%s", count,
+                 (list->flags & PEER_LIST_APPEND) ? " (continued)" : "");
         
         if (g_client.callbacks.onPeerListReceived) {
-            g_client.callbacks.onPeerListReceived(peers, list->peer_count, g_client.callbacks.userdata);
+            g_client.callbacks.onPeerListReceived(peers, count, g_client.callbacks.userdata);
         }
         break;
     }
@@ -680,7 +751,7 @@ static void HandleTcpPacket(const uint8_t* data, int len) {
         PeerNotifyPacket* notify = (PeerNotifyPacket*)data;
         
         MutexLock(&g_client.peers_mutex);
-        if (g_client.peer_count < MAX_CLIENTS) {
+        if (g_client.peer_count < MAX_SESSIONS) {
             g_client.peers[g_client.peer_count++] = notify->peer;
         }
         MutexUnlock(&g_client.peers_mutex);
@@ -700,6 +771,8 @@ static void HandleTcpPacket(const uint8_t* data, int len) {
         MutexLock(&g_client.peers_mutex);
         for (int i = 0; i < g_client.peer_count; i++) {
             if (g_client.peers[i].client_id == left_id) {
+                // 回收该用户的接收流
+                StreamMixer_RemoveStream(g_client.mixer, g_client.peers[i].ssrc);
                 memmove(&g_client.peers[i], &g_client.peers[i + 1],
                         (g_client.peer_count - i - 1) * sizeof(PeerInfo));
                 g_client.peer_count--;
@@ -716,6 +789,50 @@ static void HandleTcpPacket(const uint8_t* data, int len) {
         break;
     }
     
+    case MSG_ROOM_JOIN_ACK: {
+        RoomJoinAck* ack = (RoomJoinAck*)data;
+        if (ack->result != 0) {
+            LOG_WARN("Cannot join room %.*s: result=%u", MAX_NAME_LEN, ack->room_name, ack->result);
+            if (g_client.callbacks.onError) {
+                g_client.callbacks.onError("Cannot join room", g_client.callbacks.userdata);
+            }
+            break;
+        }
+        
+        // 回收原房间用户的接收流, 随后服务器发送新房间的用户列表
+        MutexLock(&g_client.peers_mutex);
+        bool changed = strncmp(g_client.room, ack->room_name, MAX_NAME_LEN) != 0;
+        if (changed) {
+            for (int i = 0; i < g_client.peer_count; i++) {
+                StreamMixer_RemoveStream(g_client.mixer, g_client.peers[i].ssrc);
+            }
+            g_client.peer_count = 0;
+            memcpy(g_client.room, ack->room_name, MAX_NAME_LEN);
+            g_client.room[MAX_NAME_LEN - 1] = '\0';
+        }
+        MutexUnlock(&g_client.peers_mutex);
+        
+        LOG_INFO("Room joined: %s (id=%u, %u members)", g_client.room, ack->room_id, ack->members);
+        
+        if (g_client.callbacks.onRoomJoined) {
+            g_client.callbacks.onRoomJoined(ack->room_id, g_client.room, g_client.callbacks.userdata);
+        }
+        break;
+    }
+    
+    case MSG_ROOM_LIST: {
+        RoomListPacket* list = (RoomListPacket*)data;
+        int count = MIN(list->room_count, (len - (int)sizeof(RoomListPacket)) / (int)sizeof(RoomInfo));
+        
+        LOG_DEBUG("Room list received: %d rooms", count);
+        
+        if (g_client.callbacks.onRoomListReceived) {
+            g_client.callbacks.onRoomListReceived((const RoomInfo*)(data + sizeof(RoomListPacket)),
+                                                  MAX(count, 0), g_client.callbacks.userdata);
+        }
+        break;
+    }
+    
     case MSG_HEARTBEAT:
         // 心跳响应
         break;
@@ -0,0 +1,312 @@
+/**
+ * @file decode_pool.c
+ * @brief 服务器解码工作池实现
+ *
+ * 每个工作线程一个环形队列 (互斥锁 + 自动复位事件), 发送者按 SSRC 取模固定到
+ * 某个工作线程, 解码器归该线程独占. 回收请求也走同一队列, 因此总在该发送者
+ * 之前提交的包解码完之后才执行; 队列为回收请求预留了空间, 不会因包太多而丢失.
+ * 统计也按工作线程分开, 由队列锁保护, 提交路径上不同工作线程之间没有共享的锁.
+ */
+
+#include "decode_pool.h"
+#include "opus_codec.h"
+
+//=============================================================================
+// 内部结构
+//=============================================================================
+
+#define JOB_RING_SIZE   (DECODE_POOL_QUEUE_SIZE + DECODE_POOL_MAX_DECODERS)
+
+/**
+ * @brief 队列项 (payload_len = 0 表示回收该 SSRC 的解码器)
+ */
+typedef struct {
+    uint32_t    ssrc;
+    uint32_t    client_id;
+    uint64_t    enqueue_us;
+    int         payload_len;
+    uint8_t     payload[OPUS_MAX_PACKET];
+} DecodeJob;
+
+/**
+ * @brief 发送者解码器
+ */
+typedef struct {
+    uint32_t    ssrc;           // 0 表示空闲
+    OpusCodec*  codec;          // 回收时只重置状态, 供下一个发送者复用
+    uint64_t    last_used_us;
+} SenderDecoder;
+
+typedef struct {
+    DecodePool*     pool;
+
+    // 队列与统计 (mutex 保护; stats 中的 queue_depth / decoders 在读取时计算)
+    DecodeJob       jobs[JOB_RING_SIZE];
+    int             head;
+    int             count;
+    DecodePoolStats stats;
+    Mutex           mutex;
+    Event           wake_event;
+
+    // 解码器 (仅本线程访问)
+    SenderDecoder   decoders[DECODE_POOL_MAX_DECODERS];
+
+    Thread          thread;
+} DecodeWorker;
+
+struct DecodePool {
+    DecodeWorker*       workers;
+    int                 worker_count;
+    DecodePoolCallback  callback;
+    void*               userdata;
+    volatile bool       running;
+};
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+static DecodeWorker* worker_for(DecodePool* pool, uint32_t ssrc) {
+    return &pool->workers[ssrc % (uint32_t)pool->worker_count];
+}
+
+/**
+ * @brief 入队并计入该工作线程的统计
+ * @param limit 队列允许的最大长度 (包受 DECODE_POOL_QUEUE_SIZE 限制, 回收请求可用预留空间)
+ */
+static bool enqueue(DecodeWorker* w, uint32_t ssrc, uint32_t client_id,
+                    const uint8_t* payload, int payload_len, int limit) {
+    MutexLock(&w->mutex);
+    if (w->count >= limit) {
+        if (payload_len > 0) w->stats.dropped++;
+        MutexUnlock(&w->mutex);
+        return false;
+    }
+
+    DecodeJob* job = &w->jobs[(w->head + w->count) % JOB_RING_SIZE];
+    job->ssrc = ssrc;
+    job->client_id = client_id;
+    job->enqueue_us = GetTimeUs();
+    job->payload_len = payload_len;
+    if (payload_len > 0) {
+        memcpy(job->payload, payload, payload_len);
+        w->stats.submitted++;
+    }
+    w->count++;
+    w->stats.queue_max = MAX(w->stats.queue_max, w->count);
+    MutexUnlock(&w->mutex);
+
+    EventSet(w->wake_event);
+    return true;
+}
+
+/**
+ * @brief 获取发送者的解码器 (首包时分配, 优先复用已回收的; 满时回收最久未用的)
+ */
+static OpusCodec* acquire_decoder(DecodeWorker* w, uint32_t ssrc, uint64_t now) {
+    SenderDecoder* slot = NULL;
+    SenderDecoder* oldest = NULL;
+
+    for (int i = 0; i < DECODE_POOL_MAX_DECODERS; i++) {
+        SenderDecoder* d = &w->decoders[i];
+        if (d->ssrc == ssrc) {
+            d->last_used_us = now;
+            return d->codec;
+        }
+        if (d->ssrc == 0) {
+            if (!slot || (d->codec && !slot->codec)) slot = d;
+        } else if (!oldest || d->last_used_us < oldest->last_used_us) {
+            oldest = d;
+        }
+    }
+
+    if (!slot) {
+        // 离开的客户端未及时回收 (不应发生): 复用最久未用的
+        slot = oldest;
+        OpusCodec_ResetDecoder(slot->codec);
+        LOG_WARN("Decode pool full, reclaiming decoder of ssrc=%u", slot->ssrc);
+    }
+
+    if (!slot->codec) {
+        OpusDecoderConfig dec_config;
+        OpusCodec_GetDefaultDecoderConfig(&dec_config);
+        slot->codec = OpusCodec_Create(NULL, &dec_config);
+        if (!slot->codec) return NULL;
+    }
+
+    slot->ssrc = ssrc;
+    slot->last_used_us = now;
+    LOG_DEBUG("Decoder assigned to ssrc=%u", ssrc);
+    return slot->codec;
+}
+
+static void release_decoder(DecodeWorker* w, uint32_t ssrc) {
+    for (int i = 0; i < DECODE_POOL_MAX_DECODERS; i++) {
+        SenderDecoder* d = &w->decoders[i];
+        if (d->ssrc == ssrc) {
+            OpusCodec_ResetDecoder(d->codec);
+            d->ssrc = 0;
+            break;
+        }
+    }
+}
+
+static int count_decoders(DecodeWorker* w) {
+    int count = 0;
+    for (int i = 0; i < DECODE_POOL_MAX_DECODERS; i++) {
+        if (w->decoders[i].ssrc != 0) count++;
+    }
+    return count;
+}
+
+static DWORD WINAPI DecodeWorkerProc(LPVOID param) {
+    DecodeWorker* w = (DecodeWorker*)param;
+    DecodePool* pool = w->pool;
+    int16_t pcm[AUDIO_FRAME_SAMPLES * 6];  // 最长 120ms 的包
+    DecodeJob job;
+
+    while (pool->running) {
+        MutexLock(&w->mutex);
+        bool has_job = w->count > 0;
+        if (has_job) {
+            job.ssrc = w->jobs[w->head].ssrc;
+            job.client_id = w->jobs[w->head].client_id;
+            job.enqueue_us = w->jobs[w->head].enqueue_us;
+            job.payload_len = w->jobs[w->head].payload_len;
+            memcpy(job.payload, w->jobs[w->head].payload, job.payload_len);
+            w->head = (w->head + 1) % JOB_RING_SIZE;
+            w->count--;
+        }
+        MutexUnlock(&w->mutex);
+
+        if (!has_job) {
+            EventWait(w->wake_event, 100);
+            continue;
+        }
+
+        if (job.payload_len == 0) {
+            release_decoder(w, job.ssrc);
+            continue;
+        }
+
+        uint64_t t0 = GetTimeUs();
+        OpusCodec* decoder = acquire_decoder(w, job.ssrc, t0);
+        int samples = decoder ? OpusCodec_Decode(decoder, job.payload, job.payload_len,
+                                                 pcm, (int)ARRAY_SIZE(pcm), 0) : -1;
+        uint64_t t1 = GetTimeUs();
+
+        MutexLock(&w->mutex);
+        DecodePoolStats* st = &w->stats;
+        if (samples > 0) {
+            st->decoded++;
+        }
+        st->decode_cost_us += ((float)(t1 - t0) - st->decode_cost_us) / 64.0f;
+        st->queue_delay_us += ((float)(t0 - job.enqueue_us) - st->queue_delay_us) / 64.0f;
+        MutexUnlock(&w->mutex);
+
+        if (samples > 0 && pool->callback) {
+            pool->callback(job.client_id, pcm, samples, pool->userdata);
+        }
+    }
+
+    return 0;
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+DecodePool* DecodePool_Create(int workers, DecodePoolCallback callback, void* userdata) {
+    workers = CLAMP(workers, 1, DECODE_POOL_MAX_WORKERS);
+
+    DecodePool* pool = (DecodePool*)calloc(1, sizeof(DecodePool));
+    if (!pool) return NULL;
+
+    pool->workers = (DecodeWorker*)calloc(workers, sizeof(DecodeWorker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pool->worker_count = workers;
+    pool->callback = callback;
+    pool->userdata = userdata;
+    pool->running = true;
+
+    for (int i = 0; i < workers; i++) {
+        DecodeWorker* w = &pool->workers[i];
+        w->pool = pool;
+        MutexInit(&w->mutex);
+        w->wake_event = EventCreate();
+        ThreadCreate(&w->thread, DecodeWorkerProc, w);
+    }
+
+    LOG_INFO("Decode pool started: %d workers, queue %d packets each",
+             workers, DECODE_POOL_QUEUE_SIZE);
+    return pool;
+}
+
+void DecodePool_Destroy(DecodePool* pool) {
+    if (!pool) return;
+
+    pool->running = false;
+    for (int i = 0; i < pool->worker_count; i++) {
+        EventSet(pool->workers[i].wake_event);
+    }
+
+    for (int i = 0; i < pool->worker_count; i++) {
+        DecodeWorker* w = &pool->workers[i];
+        ThreadJoin(w->thread);
+        ThreadClose(w->thread);
+        EventDestroy(w->wake_event);
+        MutexDestroy(&w->mutex);
+
+        for (int j = 0; j < DECODE_POOL_MAX_DECODERS; j++) {
+            OpusCodec_Destroy(w->decoders[j].codec);
+        }
+    }
+
+    free(pool->workers);
+    free(pool);
+
+    LOG_INFO("Decode pool stopped");
+}
+
+bool DecodePool_Submit(DecodePool* pool, uint32_t ssrc, uint32_t client_id,
+                       const uint8_t* payload, int payload_len) {
+    if (!pool || !payload || payload_len <= 0 || payload_len > OPUS_MAX_PACKET) {
+        return false;
+    }
+
+    return enqueue(worker_for(pool, ssrc), ssrc, client_id, payload, payload_len,
+                   DECODE_POOL_QUEUE_SIZE);
+}
+
+void DecodePool_Release(DecodePool* pool, uint32_t ssrc) {
+    if (!pool) return;
+
+    if (!enqueue(worker_for(pool, ssrc), ssrc, 0, NULL, 0, JOB_RING_SIZE)) {
+        LOG_WARN("Decode pool: release of ssrc=%u lost (queue full)", ssrc);
+    }
+}
+
+void DecodePool_GetStats(DecodePool* pool, DecodePoolStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!pool) return;
+
+    // 各工作线程累加, 平均耗时取各线程的平均; 解码器由工作线程独占, 此处只读计数
+    for (int i = 0; i < pool->worker_count; i++) {
+        DecodeWorker* w = &pool->workers[i];
+        MutexLock(&w->mutex);
+        stats->submitted += w->stats.submitted;
+        stats->decoded += w->stats.decoded;
+        stats->dropped += w->stats.dropped;
+        stats->queue_max = MAX(stats->queue_max, w->stats.queue_max);
+        stats->decode_cost_us += w->stats.decode_cost_us / pool->worker_count;
+        stats->queue_delay_us += w->stats.queue_delay_us / pool->worker_count;
+        stats->queue_depth += w->count;
+        MutexUnlock(&w->mutex);
+        stats->decoders += count_decoders(w);
+    }
+}
@@ -7,19 +7,97 @@
  * 2. 按序列号排序
  * 3. 延迟一定时间后输出
  * 4. 丢包时使用 PLC 补偿
+ * 
+ * 自适应延迟:
+ * 每个包计算相对到达延迟 (传输时延 - 近期最小传输时延), 记入带遗忘因子的
+ * 直方图, 取 (1 - late_loss_rate) 分位数作为目标延迟, 限制在 [min, max] 内.
+ * 缓冲区空时重新预缓冲到目标延迟.
+ * 
+ * 延迟收敛:
+ * 解码帧经 WSOLA 时间伸缩 (加速/减速若干毫秒) 后进入输出缓冲,
+ * 使缓冲级别平滑逼近目标; 仅在远高于目标时才整帧丢弃.
+ * 
+ * 取数据:
+ * 每次返回调用者请求的任意采样数. 整包能放进调用者缓冲区时直接解码过去,
+ * 否则解码到输出缓冲, 剩余部分通过 out_pos 保留到下次调用, 不做搬移.
+ * 
+ * 播放时钟:
+ * 每包时长取自 Opus TOC (可为 2.5-120ms 及多帧包), 播放位置 play_ts 按
+ * RTP 时间戳推进, 缓冲级别 = 最新包结束时间戳 - play_ts, 与包长无关.
+ * 丢包补偿时长取下一个包的时间戳差 (未到达时沿用上一包时长).
+ * 
+ * 重新同步:
+ * 来源 SSRC 变化, 序列号跳出窗口, 时间戳跳变超过 JB_RESYNC_GAP_MS,
+ * 或缓冲区空时收到 marker (新讲话段), 均清空槽并以新包为起点重新开始,
+ * 而不是把新包当作迟到/溢出丢弃. 重新开始时只预缓冲到最小延迟 (默认一帧),
+ * 讲话在一帧内恢复; 延迟直方图保留 (网络状况未变), 之后由减速把级别
+ * 逐步拉回目标延迟. 欠载仍按目标延迟重新预缓冲.
+ * 
+ * 时钟漂移补偿:
+ * 发送端声卡时钟与本地有数十 ppm 偏差, 每次取一帧的播放方式下缓冲会缓慢
+ * 涨满或取空. 以媒体时间 JB_DRIFT_WINDOW_MS 为窗口记录最小传输时延
+ * (到达时间 - RTP 时间戳), 对最近 JB_DRIFT_POINTS 个窗口做线性回归, 斜率即漂移.
+ * 估计可用后所有输出帧 (含 PLC / 舒适噪声) 都经微调重采样, 比例 1 + 漂移.
+ * 漂移估计独立于重新同步 (讲话段之间保留), 仅在 SSRC 变化或最小时延跳变时重来.
+ * 
+ * DTX:
+ * 发送端静音期不发包, 序列号连续而时间戳跳过一段, 据此与丢包 (序列号缺口) 区分.
+ * 收到非语音帧 (VAD 标志为 0 的舒适噪声更新帧) 后缓冲区空、或 head 包之前的
+ * 时间戳间隙, 都以舒适噪声填充, 不运行 Opus PLC, 也不计欠载.
+ * 
+ * 内存布局:
+ * 槽元数据 (热, 16 字节) 与负载池 (冷) 分离, 不保存解码 PCM. 负载池是按到达顺序
+ * 环形分配的字节区, 每包只占实际长度; 无锁入口队列的负载同样按实际长度存放在
+ * 同一块分配的后半部分. 伸缩/重采样用的暂存帧是线程局部的 (同一播放线程上的
+ * 各路流共用), 每路流只保留跨调用的输出缓冲. 不需要伸缩时直接解码到调用者的
+ * 输出缓冲区.
+ * 
+ * 无锁模式 (config.lock_free):
+ * 接收线程只把包写入单生产者/单消费者入口队列 (记录接收时间后发布 tail),
+ * 不获取互斥锁; 播放线程在 Get 开头批量取出入队包完成排序/抖动估计,
+ * 因此槽、统计与解码器状态只由播放线程修改, 解码不再阻塞收包.
+ * 互斥锁仅用于播放线程与统计查询之间.
  */
 
 #include "jitter_buffer.h"
+#include "time_stretch.h"
+#include "resampler.h"
+#include <math.h>
+
+// 暂存帧 (一包按最大比例重采样拉长)
+#define JB_SCRATCH_SAMPLES      (JB_MAX_FRAME_SAMPLES + JB_MAX_FRAME_SAMPLES / 100 + 2)
+
+// 待伸缩 / 重采样帧暂存 (只在一次 Get 内使用, 不跨调用保留)
+static THREAD_LOCAL int16_t g_scratch[JB_SCRATCH_SAMPLES];
 
 //=============================================================================
 // 内部结构
 //=============================================================================
+
+/**
+ * @brief 入口队列项 (负载在 ingress_pool 中)
+ */
+typedef struct {
+    uint16_t sequence;
+    uint16_t payload_len;
+    uint32_t timestamp;
+    uint64_t recv_time;     // 微秒
+    uint32_t ssrc;
+    bool     marker;        // 讲话段开始
+    bool     vad;           // 语音帧
+    uint16_t payload_off;   // 负载在 ingress_pool 中的偏移
+} JitterIngress;
+
 struct JitterBuffer {
     // 配置
     JitterConfig config;
     
     // 环形缓冲区
-    JitterSlot   slots[JITTER_BUFFER_SLOTS];
+    JitterSlot   slots[JITTER_BUFFER_SLOTS];    // 槽元数据 (热)
+    uint8_t*     payload_pool;      // 负载池 (冷), 按到达顺序环形分配
+    int          pool_size;         // 负载池字节数
+    int          pool_write;        // 下一个写入偏移
+    int          max_payload;       // 单包最大字节数
     int          head;              // 读取位置
     int          tail;              // 写入位置
     int          count;             // 当前包数
@@ -27,24 +105,93 @@ struct JitterBuffer {
     // 序列号跟踪
     uint16_t     next_seq;          // 期望的下一个序列号
     bool         seq_initialized;   // 序列号是否初始化
+    uint32_t     ssrc;              // 当前来源 (变化时重新同步)
     
     // 时间戳跟踪
     uint32_t     base_timestamp;    // 基准时间戳
-    uint64_t     base_time;         // 基准本地时间
+    uint64_t     base_time;         // 基准本地时间 (微秒)
     bool         time_initialized;  // 时间是否初始化
+    uint32_t     play_ts;           // 播放位置 (下一个待输出采样的 RTP 时间戳)
+    uint32_t     end_ts;            // 已缓冲包的最晚结束时间戳
+    int          last_frame_samples;// 上一包时长 (采样数)
     
     // 抖动计算
-    float        jitter;            // 当前抖动估计
-    uint64_t     last_recv_time;    // 上次接收时间
+    float        jitter;            // 当前抖动估计 (RTP 时间戳单位)
+    uint64_t     last_recv_time;    // 上次接收时间 (微秒)
     uint32_t     last_timestamp;    // 上次时间戳
     
+    // 自适应延迟
+    float        delay_hist[JB_HIST_BINS];  // 相对到达延迟直方图
+    int64_t      ext_timestamp;     // 扩展时间戳 (处理 32 位回绕)
+    int64_t      min_transit;       // 当前窗口最小传输时延 (微秒)
+    int64_t      prev_min_transit;  // 上一窗口最小传输时延 (微秒)
+    int          transit_count;     // 当前窗口包数
+    uint32_t     target_delay_ms;   // 当前目标延迟
+    bool         buffering;         // 预缓冲中 (未达到目标延迟前不输出)
+    bool         fast_start;        // 重新同步后的预缓冲: 达到最小延迟即开始输出
+    int          over_target_count; // 连续高于目标的取帧次数
+    
+    // 时钟漂移 (媒体时间与传输时延均为微秒)
+    bool         drift_started;     // 已收到第一个包
+    uint32_t     drift_last_ts;     // 上一包时间戳
+    int64_t      drift_ext_ts;      // 扩展时间戳 (与 ext_timestamp 不同, 重新同步时不清零)
+    int64_t      drift_win_start;   // 当前窗口起点 (媒体时间)
+    int64_t      drift_win_min;     // 当前窗口最小传输时延
+    int64_t      drift_win_x;       // 最小传输时延所在媒体时间
+    int64_t      drift_x[JB_DRIFT_POINTS];  // 各窗口最小点: 媒体时间
+    int64_t      drift_y[JB_DRIFT_POINTS];  // 各窗口最小点: 传输时延
+    int          drift_count;       // 有效窗口数
+    int          drift_next;        // 下一个写入位置
+    bool         drift_active;      // 输出经重采样 (估计可用后保持, 避免切换路径)
+    Resampler    resampler;
+    
+    // 舒适噪声 (发送端 DTX 期间不发包)
+    bool         in_dtx;            // 发送端处于 DTX 静音期
+    int          cn_level;          // 噪声幅度 (RMS, 取最近解码帧)
+    int          cn_samples;        // 自上次解码以来生成的舒适噪声采样数
+    uint32_t     cn_seed;           // 噪声发生器状态
+    
+    // 输出缓冲 (时间伸缩后的 PCM)
+    int16_t      out_buf[JB_OUT_BUF_SAMPLES];       // 待输出 PCM (只在取空后重新填充)
+    int          out_len;                           // 有效采样数
+    int          out_pos;                           // 读取位置 (跨调用保留帧的剩余部分)
+    
+    // 无锁入口队列 (单生产者: 接收线程, 单消费者: 播放线程)
+    JitterIngress ingress[JB_INGRESS_SLOTS];   // 入队包元数据
+    uint8_t*     ingress_pool;      // 入队包负载 (环形, 与负载池同一块分配)
+    int          ingress_size;      // 入队负载区字节数
+    int          ingress_write;     // 下一个写入偏移 (仅接收线程读写)
+    AtomicInt    ingress_head;      // 消费位置 (仅播放线程写)
+    AtomicInt    ingress_tail;      // 生产位置 (仅接收线程写)
+    AtomicInt    ingress_drops;     // 队列满丢弃数 (接收线程计数)
+    AtomicInt    ingress_oversize;  // 超大包丢弃数 (接收线程计数)
+    
+    // 收包耗时 (接收线程写)
+    float        put_cost_us;       // 平均
+    float        put_cost_max_us;   // 峰值
+    
     // 统计
     JitterStats  stats;
     
+    // 播放质量直方图 (播放线程写)
+    JitterHistogram hist_delay;     // 缓冲延迟 (毫秒)
+    JitterHistogram hist_jitter;    // 到达抖动 (微秒)
+    JitterHistogram hist_conceal;   // 连续补偿帧数
+    int          conceal_run;       // 当前连续补偿帧数
+    
+    // 统计快照 (顺序锁: 写入期间 snapshot_seq 为奇数)
+    JitterSnapshot snapshot;
+    AtomicInt    snapshot_seq;
+    
     // 解码器
     void*        decoder;
     OpusDecodeFunc decode_func;
     PlcFunc      plc_func;
+    PacketSamplesFunc samples_func;
+    
+    // 时钟 (微秒, NULL 使用 GetTimeUs)
+    JitterClockFunc clock_func;
+    void*        clock_ctx;
     
     // 同步
     Mutex        mutex;
@@ -80,8 +227,9 @@ static int find_slot_for_seq(JitterBuffer* jb, uint16_t seq) {
     
     int distance = seq_distance(jb->next_seq, seq);
     
-    // 太旧的包 (已经播放过)
-    if (distance < -JITTER_BUFFER_SLOTS / 2) {
+    // 太旧的包 (已经播放过或已被 PLC 跳过)
+    // 不能放入 head 之前的槽, 否则会虚增 count 并在回绕后错位
+    if (distance < 0) {
         return -1;  // 丢弃
     }
     
@@ -96,7 +244,49 @@ static int find_slot_for_seq(JitterBuffer* jb, uint16_t seq) {
 }
 
 /**
- * @brief 更新抖动估计 (RFC 3550 算法)
+ * @brief 初始化直方图
+ */
+static void hist_init(JitterHistogram* hist, uint32_t bin_width) {
+    memset(hist, 0, sizeof(*hist));
+    hist->bin_width = bin_width;
+}
+
+/**
+ * @brief 记入一个样本, 样本数达到上限时各桶减半以偏重近期数据
+ */
+static void hist_add(JitterHistogram* hist, uint32_t value) {
+    uint32_t bin = MIN(value / hist->bin_width, JB_QHIST_BINS - 1);
+    hist->bins[bin]++;
+    
+    if (++hist->count >= JB_QHIST_MAX_COUNT) {
+        hist->count = 0;
+        for (int i = 0; i < JB_QHIST_BINS; i++) {
+            hist->bins[i] /= 2;
+            hist->count += hist->bins[i];
+        }
+    }
+}
+
+/**
+ * @brief 发布统计快照 (持有锁; 顺序锁写端, 不等待读者)
+ */
+static void publish_snapshot(JitterBuffer* jb) {
+    AtomicInc(&jb->snapshot_seq);   // 奇数: 写入中
+    
+    jb->snapshot.stats = jb->stats;
+    jb->snapshot.level_ms = JitterBuffer_GetLevel(jb);
+    jb->snapshot.delay_ms = jb->hist_delay;
+    jb->snapshot.jitter_us = jb->hist_jitter;
+    jb->snapshot.conceal_run = jb->hist_conceal;
+    
+    AtomicInc(&jb->snapshot_seq);   // 偶数: 可读
+}
+
+/**
+ * @brief 更新抖动估计 (RFC 3550 6.4.1, 以 RTP 时间戳为单位)
+ * 
+ * D(i-1, i) = (R_i - R_{i-1}) - (S_i - S_{i-1}), J += (|D| - J) / 16
+ * 到达时间为微秒精度, 换算到 RTP 单位后不再受系统时钟 10-16ms 粒度影响.
  */
 static void update_jitter(JitterBuffer* jb, uint32_t timestamp, uint64_t recv_time) {
     if (jb->last_recv_time == 0) {
@@ -105,11 +295,11 @@ static void update_jitter(JitterBuffer* jb, uint32_t timestamp, uint64_t recv_ti
         return;
     }
     
-    // 到达间隔 (毫秒)
-    int64_t d_recv = (int64_t)(recv_time - jb->last_recv_time);
+    // 到达间隔 (微秒 -> RTP 单位)
+    int64_t d_recv = (int64_t)(recv_time - jb->last_recv_time) * AUDIO_SAMPLE_RATE / 1000000;
     
-    // 时间戳间隔 (转换为毫秒, 48kHz -> ms)
-    int64_t d_ts = ((int64_t)(timestamp - jb->last_timestamp) * 1000) / AUDIO_SAMPLE_RATE;
+    // 时间戳间隔 (RTP 单位)
+    int64_t d_ts = (int32_t)(timestamp - jb->last_timestamp);
     
     // 差异
     int64_t diff = d_recv - d_ts;
@@ -117,39 +307,359 @@ static void update_jitter(JitterBuffer* jb, uint32_t timestamp, uint64_t recv_ti
     
     // 指数移动平均
     jb->jitter = jb->jitter + ((float)diff - jb->jitter) / 16.0f;
-    jb->stats.avg_jitter_ms = jb->jitter;
+    jb->stats.avg_jitter_ms = jb->jitter * 1000.0f / AUDIO_SAMPLE_RATE;
+    
+    hist_add(&jb->hist_jitter, (uint32_t)MIN(diff * 1000000 / AUDIO_SAMPLE_RATE, UINT32_MAX));
     
     jb->last_recv_time = recv_time;
     jb->last_timestamp = timestamp;
 }
 
+/**
+ * @brief 更新相对到达延迟直方图并重新计算目标延迟
+ * 
+ * 必须在 update_jitter 之前调用 (使用上一个包的时间戳)
+ */
+static void update_delay_histogram(JitterBuffer* jb, uint32_t timestamp, uint64_t recv_time) {
+    if (jb->last_recv_time == 0) {
+        jb->ext_timestamp = 0;
+    } else {
+        jb->ext_timestamp += (int32_t)(timestamp - jb->last_timestamp);
+    }
+    
+    // 传输时延 (微秒, 含未知的时钟偏移, 只用其相对值)
+    int64_t transit = (int64_t)recv_time - (jb->ext_timestamp * 1000000) / AUDIO_SAMPLE_RATE;
+    
+    // 两个窗口交替跟踪最小传输时延, 避免永久锁定在历史最小值
+    if (jb->last_recv_time == 0 || transit < jb->min_transit) {
+        jb->min_transit = transit;
+    }
+    if (jb->last_recv_time == 0) {
+        jb->prev_min_transit = transit;
+    }
+    if (++jb->transit_count >= JB_TRANSIT_WINDOW) {
+        jb->prev_min_transit = jb->min_transit;
+        jb->min_transit = transit;
+        jb->transit_count = 0;
+    }
+    
+    int64_t delay = transit - MIN(jb->min_transit, jb->prev_min_transit);
+    int bin = (int)MIN(MAX(delay, 0) / (JB_HIST_BIN_MS * 1000), JB_HIST_BINS - 1);
+    
+    // 遗忘旧数据, 记入新样本
+    float total = 0;
+    for (int i = 0; i < JB_HIST_BINS; i++) {
+        jb->delay_hist[i] *= JB_HIST_FORGET;
+        if (i == bin) jb->delay_hist[i] += 1.0f - JB_HIST_FORGET;
+        total += jb->delay_hist[i];
+    }
+    
+    if (!jb->config.adaptive) {
+        jb->target_delay_ms = jb->config.target_delay_ms;
+        return;
+    }
+    
+    // 取 (1 - late_loss_rate) 分位数
+    float threshold = total * (1.0f - jb->config.late_loss_rate);
+    float cumulative = 0;
+    int quantile_bin = JB_HIST_BINS - 1;
+    for (int i = 0; i < JB_HIST_BINS; i++) {
+        cumulative += jb->delay_hist[i];
+        if (cumulative >= threshold) {
+            quantile_bin = i;
+            break;
+        }
+    }
+    
+    uint32_t target = (uint32_t)(quantile_bin + 1) * JB_HIST_BIN_MS;
+    jb->target_delay_ms = CLAMP(target, jb->config.min_delay_ms, jb->config.max_delay_ms);
+    jb->stats.target_delay_ms = jb->target_delay_ms;
+}
+
+/**
+ * @brief 清空漂移估计 (新的发送端)
+ */
+static void drift_reset(JitterBuffer* jb) {
+    jb->drift_started = false;
+    jb->drift_count = 0;
+    jb->drift_next = 0;
+    jb->drift_active = false;
+    jb->stats.drift_ppm = 0;
+    Resampler_Init(&jb->resampler);
+}
+
+/**
+ * @brief 对窗口最小点做最小二乘拟合, 返回斜率 (ppm)
+ * @return 覆盖的媒体时长不足 JB_DRIFT_MIN_SPAN_MS 时返回 false
+ */
+static bool drift_fit(JitterBuffer* jb, float* ppm) {
+    if (jb->drift_count < 3) return false;
+    
+    int first = (jb->drift_next - jb->drift_count + JB_DRIFT_POINTS) % JB_DRIFT_POINTS;
+    int last = (jb->drift_next - 1 + JB_DRIFT_POINTS) % JB_DRIFT_POINTS;
+    if (jb->drift_x[last] - jb->drift_x[first] < (int64_t)JB_DRIFT_MIN_SPAN_MS * 1000) {
+        return false;
+    }
+    
+    // 以第一个点为原点, 避免大数相减损失精度
+    double mx = 0, my = 0;
+    for (int i = 0; i < jb->drift_count; i++) {
+        int k = (first + i) % JB_DRIFT_POINTS;
+        mx += (double)(jb->drift_x[k] - jb->drift_x[first]);
+        my += (double)(jb->drift_y[k] - jb->drift_y[first]);
+    }
+    mx /= jb->drift_count;
+    my /= jb->drift_count;
+    
+    double sxy = 0, sxx = 0;
+    for (int i = 0; i < jb->drift_count; i++) {
+        int k = (first + i) % JB_DRIFT_POINTS;
+        double dx = (double)(jb->drift_x[k] - jb->drift_x[first]) - mx;
+        double dy = (double)(jb->drift_y[k] - jb->drift_y[first]) - my;
+        sxy += dx * dy;
+        sxx += dx * dx;
+    }
+    if (sxx <= 0) return false;
+    
+    *ppm = (float)CLAMP(sxy / sxx * 1e6, -JB_DRIFT_MAX_PPM, JB_DRIFT_MAX_PPM);
+    return true;
+}
+
+/**
+ * @brief 更新发送端时钟漂移估计
+ * 
+ * 传输时延 = 到达时间 - 发送端媒体时间, 其最小值 (无排队的包) 随时间的斜率
+ * 即发送端时钟相对本地的偏差: 斜率为正说明发送端采样率偏低, 缓冲会被取空.
+ */
+static void update_drift(JitterBuffer* jb, uint32_t timestamp, uint64_t recv_time) {
+    if (!jb->drift_started) {
+        jb->drift_started = true;
+        jb->drift_ext_ts = 0;
+        jb->drift_win_start = 0;
+        jb->drift_win_min = INT64_MAX;
+    } else {
+        jb->drift_ext_ts += (int32_t)(timestamp - jb->drift_last_ts);
+    }
+    jb->drift_last_ts = timestamp;
+    
+    int64_t media_us = jb->drift_ext_ts * 1000000 / AUDIO_SAMPLE_RATE;
+    int64_t transit = (int64_t)recv_time - media_us;
+    
+    if (transit < jb->drift_win_min) {
+        jb->drift_win_min = transit;
+        jb->drift_win_x = media_us;
+    }
+    if (media_us - jb->drift_win_start < (int64_t)JB_DRIFT_WINDOW_MS * 1000) {
+        return;
+    }
+    
+    // 窗口结束: 记录最小点
+    int last = (jb->drift_next - 1 + JB_DRIFT_POINTS) % JB_DRIFT_POINTS;
+    if (jb->drift_count > 0) {
+        int64_t step = jb->drift_win_min - jb->drift_y[last];
+        if (step > (int64_t)JB_DRIFT_JUMP_MS * 1000 || step < -(int64_t)JB_DRIFT_JUMP_MS * 1000) {
+            // 发送端重启 / 时间戳跳变: 旧点不再可比, 已有估计继续使用
+            jb->drift_count = 0;
+        }
+    }
+    
+    jb->drift_x[jb->drift_next] = jb->drift_win_x;
+    jb->drift_y[jb->drift_next] = jb->drift_win_min;
+    jb->drift_next = (jb->drift_next + 1) % JB_DRIFT_POINTS;
+    jb->drift_count = MIN(jb->drift_count + 1, JB_DRIFT_POINTS);
+    
+    jb->drift_win_start = media_us;
+    jb->drift_win_min = INT64_MAX;
+    
+    float ppm;
+    if (!jb->config.drift_compensation || !drift_fit(jb, &ppm)) {
+        return;
+    }
+    
+    if (!jb->drift_active) {
+        jb->drift_active = true;
+        jb->stats.drift_ppm = ppm;
+        LOG_DEBUG("JitterBuffer: clock drift %.1f ppm, resampling enabled", ppm);
+    } else {
+        jb->stats.drift_ppm += (ppm - jb->stats.drift_ppm) * JB_DRIFT_SMOOTH;
+    }
+}
+
+/**
+ * @brief 获取槽对应的负载
+ */
+static inline uint8_t* slot_payload(JitterBuffer* jb, JitterSlot* slot) {
+    return jb->payload_pool + slot->payload_off;
+}
+
+/**
+ * @brief [pos, pos + len) 是否与某个已缓冲包的负载重叠
+ */
+static bool pool_overlaps(JitterBuffer* jb, int pos, int len) {
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        JitterSlot* slot = &jb->slots[i];
+        if (slot->state == JB_SLOT_FILLED &&
+            slot->payload_off < pos + len && pos < slot->payload_off + slot->payload_len) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 在负载池中分配 len 字节
+ * 
+ * 按到达顺序从 pool_write 向后分配, 到末尾回到开头. 包基本按到达顺序播放,
+ * 写入位置前方通常是已播放的旧负载; 被乱序包占住时整体回绕到开头再试一次.
+ * @return 偏移, <0 表示池中没有足够的连续空间
+ */
+static int pool_alloc(JitterBuffer* jb, int len) {
+    int pos = jb->pool_write;
+    if (pos + len > jb->pool_size || pool_overlaps(jb, pos, len)) {
+        pos = 0;
+        if (pool_overlaps(jb, pos, len)) {
+            return -1;
+        }
+    }
+    
+    jb->pool_write = pos + len;
+    return pos;
+}
+
+/**
+ * @brief 已缓冲的包所覆盖的采样数 (按时间戳, 含中间丢失的部分)
+ */
+static int buffered_samples(JitterBuffer* jb) {
+    if (jb->count == 0) {
+        return 0;
+    }
+    
+    int32_t span = (int32_t)(jb->end_ts - jb->play_ts);
+    return CLAMP(span, 0, JITTER_BUFFER_SLOTS * JB_MAX_FRAME_SAMPLES);
+}
+
+/**
+ * @brief 丢失帧的补偿时长
+ * 
+ * 下一个包已到达时取其时间戳与播放位置之差, 否则沿用上一包时长.
+ * Opus PLC/FEC 要求时长为 2.5ms 的整数倍.
+ */
+static int lost_frame_samples(JitterBuffer* jb, int max_samples) {
+    int samples = jb->last_frame_samples;
+    
+    for (int i = 1; i < JITTER_BUFFER_SLOTS; i++) {
+        JitterSlot* next = &jb->slots[(jb->head + i) % JITTER_BUFFER_SLOTS];
+        if (next->state == JB_SLOT_FILLED && next->sequence == (uint16_t)(jb->next_seq + i)) {
+            // 中间 i 个包全部丢失时平均分配
+            int32_t gap = (int32_t)(next->timestamp - jb->play_ts) / i;
+            if (gap > 0) samples = gap;
+            break;
+        }
+    }
+    
+    samples = CLAMP(samples, JB_MIN_FRAME_SAMPLES, MIN(JB_MAX_FRAME_SAMPLES, max_samples));
+    return samples - samples % JB_MIN_FRAME_SAMPLES;
+}
+
+/**
+ * @brief head 位置包的时长 (丢失时为预计补偿时长)
+ */
+static int head_samples(JitterBuffer* jb) {
+    JitterSlot* slot = &jb->slots[jb->head];
+    if (slot->state == JB_SLOT_FILLED) {
+        return slot->samples;
+    }
+    return lost_frame_samples(jb, JB_MAX_FRAME_SAMPLES);
+}
+
 /**
  * @brief 解码槽中的数据
+ * @param pcm 输出缓冲区
+ * @param max_samples 输出缓冲区最大采样数
+ * @return 解码采样数, <0 表示失败
  */
-static int decode_slot(JitterBuffer* jb, JitterSlot* slot) {
+static int decode_slot(JitterBuffer* jb, JitterSlot* slot, int16_t* pcm, int max_samples) {
     if (slot->state != JB_SLOT_FILLED) {
         return -1;
     }
     
     if (jb->decode_func && jb->decoder) {
-        slot->decoded_samples = jb->decode_func(
+        int samples = jb->decode_func(
             jb->decoder,
-            slot->payload,
+            slot_payload(jb, slot),
             slot->payload_len,
-            slot->decoded,
-            AUDIO_FRAME_SAMPLES,
+            pcm,
+            max_samples,
             0  // no FEC
         );
         
-        if (slot->decoded_samples > 0) {
-            slot->state = JB_SLOT_DECODED;
-            return slot->decoded_samples;
+        if (samples > 0) {
+            return samples;
         }
     }
     
     return -1;
 }
 
+/**
+ * @brief 用下一个包携带的带内 FEC 恢复丢失帧
+ * 
+ * Opus 编码器启用 FEC 后, 包 N+1 中带有包 N 的低码率副本.
+ * 解码时 frame_size 必须等于丢失帧时长.
+ * 
+ * @return 恢复的采样数, <0 表示下一个包尚未到达或无法恢复
+ */
+static int fec_frame(JitterBuffer* jb, int16_t* samples, int frame_size) {
+    JitterSlot* next = &jb->slots[(jb->head + 1) % JITTER_BUFFER_SLOTS];
+    
+    if (next->state != JB_SLOT_FILLED || next->sequence != (uint16_t)(jb->next_seq + 1)) {
+        return -1;
+    }
+    
+    if (!jb->decode_func || !jb->decoder) {
+        return -1;
+    }
+    
+    int ret = jb->decode_func(jb->decoder, slot_payload(jb, next), next->payload_len,
+                              samples, frame_size, 1);
+    return ret > 0 ? ret : -1;
+}
+
+/**
+ * @brief 生成舒适噪声 (DTX 静音期代替 Opus PLC)
+ * 
+ * 白噪声, 幅度跟随最近一帧解码输出 (DTX 期间即发送端的舒适噪声更新帧),
+ * 每个采样只需一次 LCG 和一次乘法.
+ */
+static int cng_frame(JitterBuffer* jb, int16_t* samples, int frame_size) {
+    // 均匀分布 int16 噪声的 RMS 约为 18919, 换算为 Q16 增益
+    int32_t gain = jb->cn_level * 65536 / 18919;
+    uint32_t seed = jb->cn_seed;
+    
+    for (int i = 0; i < frame_size; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int32_t x = (int16_t)(seed >> 16);
+        samples[i] = (int16_t)((x * gain) >> 16);
+    }
+    
+    jb->cn_seed = seed;
+    jb->cn_samples += frame_size;
+    jb->stats.frames_comfort_noise++;
+    return frame_size;
+}
+
+/**
+ * @brief 记录解码帧的电平作为后续舒适噪声的幅度
+ */
+static void update_cn_level(JitterBuffer* jb, const int16_t* pcm, int n) {
+    int64_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += (int32_t)pcm[i] * pcm[i];
+    }
+    int rms = n > 0 ? (int)sqrt((double)sum / n) : 0;
+    jb->cn_level = MIN(rms, JB_CN_MAX_LEVEL);
+}
+
 /**
  * @brief PLC 补偿丢失帧
  */
@@ -163,45 +673,280 @@ static int plc_frame(JitterBuffer* jb, int16_t* samples, int frame_size) {
     return frame_size;
 }
 
-//=============================================================================
-// 公共接口实现
-//=============================================================================
+/**
+ * @brief 丢弃 head 帧以降低延迟 (仍然解码, 保持解码器状态连续)
+ */
+static void drop_head_frame(JitterBuffer* jb) {
+    JitterSlot* slot = &jb->slots[jb->head];
+    
+    if (slot->state != JB_SLOT_EMPTY) {
+        decode_slot(jb, slot, g_scratch, JB_MAX_FRAME_SAMPLES);
+        jb->play_ts = slot->timestamp + slot->samples;
+        jb->last_frame_samples = slot->samples;
+        slot->state = JB_SLOT_EMPTY;
+        jb->count--;
+    } else {
+        jb->play_ts += lost_frame_samples(jb, JB_MAX_FRAME_SAMPLES);
+    }
+    
+    jb->next_seq++;
+    jb->head = (jb->head + 1) % JITTER_BUFFER_SLOTS;
+    jb->stats.frames_dropped++;
+}
 
-JitterBuffer* JitterBuffer_Create(const JitterConfig* config) {
-    JitterBuffer* jb = (JitterBuffer*)calloc(1, sizeof(JitterBuffer));
-    if (!jb) return NULL;
+/**
+ * @brief 收缩控制: 远高于目标延迟 (时间伸缩来不及收敛) 时丢弃 head 帧
+ * 
+ * 在选择伸缩模式和输出位置之前调用. 丢帧后的 head 可能是更长的包,
+ * 调用者须按新的 head_samples 判断能否直接解码到其缓冲区.
+ */
+static void shrink_head(JitterBuffer* jb) {
+    if (jb->buffering || jb->count == 0) {
+        return;
+    }
     
-    // 默认配置
-    if (config) {
-        jb->config = *config;
+    // DTX 间隙由 pop_frame 以舒适噪声填充, 不在此丢帧
+    JitterSlot* slot = &jb->slots[jb->head];
+    if (slot->state == JB_SLOT_FILLED &&
+        (int32_t)(slot->timestamp - jb->play_ts) >= JB_MIN_FRAME_SAMPLES) {
+        return;
+    }
+    
+    if (JitterBuffer_GetLevel(jb) > (int)jb->target_delay_ms + JB_SHRINK_MARGIN_MS) {
+        if (++jb->over_target_count >= JB_SHRINK_HOLD) {
+            drop_head_frame(jb);
+            jb->over_target_count = 0;
+        }
     } else {
-        jb->config.min_delay_ms = JITTER_MIN_MS;
-        jb->config.max_delay_ms = JITTER_MAX_MS;
-        jb->config.target_delay_ms = JITTER_BUFFER_MS;
-        jb->config.adaptive = true;
+        jb->over_target_count = 0;
+    }
+}
+
+/**
+ * @brief 从 head 取出一帧 (解码 / PLC / 舒适噪声), 并执行预缓冲控制
+ * @param pcm 输出缓冲区
+ * @param max_samples 输出缓冲区最大采样数 (至少为 head_samples)
+ * @param decoded 输出: 是否为正常解码帧 (PLC 帧为 false)
+ * @return 采样数, 0 表示当前无可播放数据
+ */
+static int pop_frame(JitterBuffer* jb, int16_t* pcm, int max_samples, bool* decoded) {
+    int level_ms = JitterBuffer_GetLevel(jb);
+    int start_ms = (int)(jb->fast_start ? MIN(jb->config.min_delay_ms, jb->target_delay_ms)
+                                        : jb->target_delay_ms);
+    
+    *decoded = false;
+    
+    // 缓冲区空或预缓冲未达到开始延迟
+    if (jb->count == 0 || (jb->buffering && level_ms < start_ms)) {
+        // DTX 静音期: 发送端本来就不发包, 以舒适噪声填充, 不算欠载
+        if (jb->in_dtx && jb->cn_samples < JB_CN_MAX_MS * (AUDIO_SAMPLE_RATE / 1000)) {
+            int n = MIN(max_samples, jb->last_frame_samples);
+            if (jb->count == 0) {
+                jb->play_ts += n;  // 播放位置随舒适噪声推进, 下一个更新帧按时间戳衔接
+            }
+            return cng_frame(jb, pcm, n);
+        }
+        
+        // 欠载: 重新预缓冲到 (可能已增大的) 目标延迟
+        if (jb->count == 0 && !jb->buffering) {
+            jb->buffering = true;
+            jb->fast_start = false;
+            jb->stats.underruns++;
+        }
+        return 0;  // 等待更多数据
     }
     
-    MutexInit(&jb->mutex);
+    if (jb->buffering) {
+        jb->buffering = false;
+        jb->fast_start = false;
+        jb->over_target_count = 0;
+    }
     
-    LOG_INFO("JitterBuffer created: target=%dms, min=%dms, max=%dms",
-             jb->config.target_delay_ms, jb->config.min_delay_ms, jb->config.max_delay_ms);
+    JitterSlot* slot = &jb->slots[jb->head];
     
-    return jb;
+    // head 包序列号连续但时间戳跳过了一段: 发送端 DTX 未发送的帧, 不是丢包
+    if (slot->state == JB_SLOT_FILLED &&
+        (int32_t)(slot->timestamp - jb->play_ts) >= JB_MIN_FRAME_SAMPLES) {
+        int gap = (int32_t)(slot->timestamp - jb->play_ts);
+        int n = MIN(gap, MIN(max_samples, jb->last_frame_samples));
+        jb->in_dtx = true;
+        jb->play_ts += n;
+        return cng_frame(jb, pcm, n);
+    }
+    
+    if (slot->state == JB_SLOT_EMPTY) {
+        // 期望的包没有到达 - 优先用下一个包的 FEC 恢复, 否则 PLC
+        // (DTX 静音期丢失的是舒适噪声更新帧, 直接生成舒适噪声)
+        jb->stats.packets_lost++;
+        
+        int lost_samples = lost_frame_samples(jb, max_samples);
+        int plc_samples = jb->in_dtx ? -1 : fec_frame(jb, pcm, lost_samples);
+        if (plc_samples > 0) {
+            jb->stats.packets_recovered++;
+            *decoded = true;
+        } else if (jb->in_dtx) {
+            jb->stats.packets_concealed++;
+            plc_samples = cng_frame(jb, pcm, lost_samples);
+        } else {
+            jb->stats.packets_concealed++;
+            jb->conceal_run++;
+            plc_samples = plc_frame(jb, pcm, lost_samples);
+        }
+        
+        // 移动到下一个序列号
+        jb->play_ts += plc_samples;
+        jb->next_seq++;
+        jb->head = (jb->head + 1) % JITTER_BUFFER_SLOTS;
+        
+        // 更新丢包率
+        if (jb->stats.packets_received > 0) {
+            jb->stats.loss_rate = (float)jb->stats.packets_lost / 
+                                   (jb->stats.packets_received + jb->stats.packets_lost);
+        }
+        
+        return plc_samples;
+    }
+    
+    // 解码 (直接写入调用者指定的缓冲区)
+    int output_samples = decode_slot(jb, slot, pcm, max_samples);
+    if (output_samples < 0) {
+        // 解码失败 - PLC
+        output_samples = plc_frame(jb, pcm, MIN(slot->samples, max_samples));
+    } else {
+        *decoded = true;
+        update_cn_level(jb, pcm, output_samples);
+        hist_add(&jb->hist_delay, (uint32_t)MAX(level_ms, 0));
+    }
+    
+    // 一段连续丢包结束
+    if (jb->conceal_run > 0) {
+        hist_add(&jb->hist_conceal, (uint32_t)jb->conceal_run);
+        jb->conceal_run = 0;
+    }
+    
+    // 非语音帧 (DTX 舒适噪声更新) 之后发送端暂停发包
+    jb->in_dtx = !slot->vad;
+    jb->cn_samples = 0;
+    
+    // 推进播放位置
+    jb->play_ts = slot->timestamp + output_samples;
+    jb->last_frame_samples = slot->samples;
+    
+    // 清空槽
+    slot->state = JB_SLOT_EMPTY;
+    jb->next_seq++;
+    jb->head = (jb->head + 1) % JITTER_BUFFER_SLOTS;
+    jb->count--;
+    
+    return output_samples;
 }
 
-void JitterBuffer_Destroy(JitterBuffer* jb) {
-    if (!jb) return;
+/**
+ * @brief 根据缓冲级别选择下一帧的时间伸缩模式
+ * 
+ * 按取出下一帧后的剩余级别判断: 高于目标则加速, 低于目标则减速, 死区内不处理.
+ */
+static TsmMode choose_stretch_mode(JitterBuffer* jb) {
+    if (jb->buffering || jb->count == 0) {
+        return TSM_NORMAL;
+    }
     
-    MutexDestroy(&jb->mutex);
-    free(jb);
+    int head_ms = head_samples(jb) * 1000 / AUDIO_SAMPLE_RATE;
+    int level_ms = JitterBuffer_GetLevel(jb) - head_ms;
+    int target_ms = (int)jb->target_delay_ms;
     
-    LOG_INFO("JitterBuffer destroyed");
+    // 长包到达时级别按包长跳变, 死区至少取半个包长, 避免来回伸缩
+    int deadband_ms = MAX(JB_TSM_DEADBAND_MS, head_ms / 2);
+    
+    if (level_ms > target_ms + deadband_ms) {
+        return TSM_ACCELERATE;
+    }
+    if (level_ms + deadband_ms < target_ms) {
+        return TSM_DECELERATE;
+    }
+    return TSM_NORMAL;
 }
 
-void JitterBuffer_Reset(JitterBuffer* jb) {
-    if (!jb) return;
+/**
+ * @brief 对一帧做时间伸缩, 追加到输出缓冲
+ * 
+ * PLC 帧与 TSM_NORMAL 不做伸缩, 原样追加.
+ */
+static void stretch_frame(JitterBuffer* jb, TsmMode mode, const int16_t* in, int n, bool decoded) {
+    int16_t* out = jb->out_buf + jb->out_len;
+    int max_out = JB_OUT_BUF_SAMPLES - jb->out_len;
     
-    MutexLock(&jb->mutex);
+    if (!decoded || mode == TSM_NORMAL) {
+        n = MIN(n, max_out);
+        memcpy(out, in, n * sizeof(int16_t));
+        jb->out_len += n;
+        return;
+    }
+    
+    uint64_t t0 = GetTimeUs();
+    
+    int out_n = TimeStretch_Process(mode, in, n, out, max_out);
+    
+    float cost_us = (float)(GetTimeUs() - t0);
+    jb->stats.stretch_cost_us += (cost_us - jb->stats.stretch_cost_us) / 16.0f;
+    
+    if (out_n <= 0) {
+        n = MIN(n, max_out);
+        memcpy(out, in, n * sizeof(int16_t));
+        out_n = n;
+    } else if (out_n < n) {
+        jb->stats.frames_accelerated++;
+    } else if (out_n > n) {
+        jb->stats.frames_decelerated++;
+    }
+    
+    jb->out_len += out_n;
+}
+
+/**
+ * @brief 判断新包是否与当前播放序列失去连续性
+ */
+static bool need_resync(JitterBuffer* jb, const JitterIngress* pkt) {
+    if (!jb->seq_initialized) {
+        return false;
+    }
+    
+    // 发送端重启 / 换了来源
+    if (pkt->ssrc != jb->ssrc) {
+        return true;
+    }
+    
+    // 序列号跳出窗口 (既不是迟到包也放不进槽)
+    int distance = seq_distance(jb->next_seq, pkt->sequence);
+    if (distance >= JITTER_BUFFER_SLOTS || distance < -JITTER_BUFFER_SLOTS) {
+        return true;
+    }
+    
+    // 时间戳跳变 (长时间静音 / 重连)
+    int32_t ts_gap = (int32_t)(pkt->timestamp - jb->last_timestamp);
+    if (ts_gap > JB_RESYNC_GAP_MS * (AUDIO_SAMPLE_RATE / 1000) ||
+        ts_gap < -JB_RESYNC_GAP_MS * (AUDIO_SAMPLE_RATE / 1000)) {
+        return true;
+    }
+    
+    // 新讲话段开始且旧数据已播完
+    if (pkt->marker && jb->count == 0) {
+        return true;
+    }
+    
+    return false;
+}
+
+/**
+ * @brief 丢弃已缓冲的包, 以新包为起点重新开始
+ * 
+ * 输出缓冲中已解码的部分照常播放; 延迟直方图保留, 传输时延基准重新建立.
+ * 预缓冲只等到最小延迟, 目标延迟不变, 开始播放后由时间伸缩逐步收敛.
+ */
+static void resync(JitterBuffer* jb, const JitterIngress* pkt) {
+    if (pkt->ssrc != jb->ssrc) {
+        drift_reset(jb);    // 不同的发送端时钟
+    }
     
     for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
         jb->slots[i].state = JB_SLOT_EMPTY;
@@ -211,173 +956,461 @@ void JitterBuffer_Reset(JitterBuffer* jb) {
     jb->tail = 0;
     jb->count = 0;
     jb->seq_initialized = false;
-    jb->time_initialized = false;
-    jb->jitter = 0;
     jb->last_recv_time = 0;
-    jb->last_timestamp = 0;
-    
-    memset(&jb->stats, 0, sizeof(jb->stats));
-    
-    MutexUnlock(&jb->mutex);
+    jb->transit_count = 0;
+    jb->buffering = true;
+    jb->fast_start = true;
+    jb->over_target_count = 0;
+    jb->stats.resyncs++;
     
-    LOG_DEBUG("JitterBuffer reset");
+    LOG_DEBUG("JitterBuffer: resync (ssrc=%u, seq=%u, ts=%u)", pkt->ssrc, pkt->sequence, pkt->timestamp);
 }
 
-int JitterBuffer_Put(JitterBuffer* jb, const RtpHeader* rtp,
-                     const uint8_t* payload, uint16_t payload_len) {
-    if (!jb || !rtp || !payload || payload_len == 0) {
-        return -1;
-    }
-    
-    MutexLock(&jb->mutex);
+/**
+ * @brief 将一个包放入槽 (锁模式下持有锁, 无锁模式下由播放线程调用)
+ * @return 0 成功, -2 太旧, -3 溢出 (槽或负载池已满), -4 超过单包最大字节数
+ */
+static int insert_packet(JitterBuffer* jb, const JitterIngress* pkt, const uint8_t* payload) {
+    uint16_t sequence = pkt->sequence;
+    uint32_t timestamp = pkt->timestamp;
+    uint16_t payload_len = pkt->payload_len;
+    uint64_t now = pkt->recv_time;
     
-    uint64_t now = GetTickCount64Ms();
+    if (need_resync(jb, pkt)) {
+        resync(jb, pkt);
+    }
     
-    // 更新抖动
-    update_jitter(jb, rtp->timestamp, now);
+    // 更新延迟直方图 / 目标延迟, 然后更新抖动
+    update_delay_histogram(jb, timestamp, now);
+    update_jitter(jb, timestamp, now);
+    update_drift(jb, timestamp, now);
     
     // 初始化序列号
     if (!jb->seq_initialized) {
-        jb->next_seq = rtp->sequence;
+        jb->next_seq = sequence;
         jb->seq_initialized = true;
-        jb->base_timestamp = rtp->timestamp;
+        jb->ssrc = pkt->ssrc;
+        jb->base_timestamp = timestamp;
         jb->base_time = now;
         jb->time_initialized = true;
-        LOG_DEBUG("JitterBuffer: seq initialized to %u", rtp->sequence);
+        jb->play_ts = timestamp;
+        LOG_DEBUG("JitterBuffer: seq initialized to %u", sequence);
     }
     
     // 查找槽
-    int slot_idx = find_slot_for_seq(jb, rtp->sequence);
+    int slot_idx = find_slot_for_seq(jb, sequence);
     
     if (slot_idx == -1) {
         // 包太旧
         jb->stats.packets_late++;
-        MutexUnlock(&jb->mutex);
         return -2;  // 丢弃
     }
     
     if (slot_idx == -2) {
         // 缓冲区溢出
         jb->stats.overruns++;
-        MutexUnlock(&jb->mutex);
         return -3;
     }
     
     JitterSlot* slot = &jb->slots[slot_idx];
     
     // 检查是否重复
-    if (slot->state != JB_SLOT_EMPTY && slot->sequence == rtp->sequence) {
-        MutexUnlock(&jb->mutex);
+    if (slot->state != JB_SLOT_EMPTY && slot->sequence == sequence) {
         return 0;  // 重复包
     }
     
     // 检查乱序
-    if (seq_compare(rtp->sequence, jb->next_seq) != 0 && jb->count > 0) {
+    if (seq_compare(sequence, jb->next_seq) != 0 && jb->count > 0) {
         jb->stats.packets_reorder++;
     }
     
+    // 超过单包上限 (配置的 max_payload 过小)
+    if (payload_len > jb->max_payload) {
+        jb->stats.packets_oversize++;
+        return -4;
+    }
+    
+    int payload_off = pool_alloc(jb, payload_len);
+    if (payload_off < 0) {
+        jb->stats.overruns++;
+        return -3;
+    }
+    
+    // 包时长 (无法解析时沿用上一包时长)
+    int samples = jb->samples_func ? jb->samples_func(payload, payload_len) : AUDIO_FRAME_SAMPLES;
+    if (samples <= 0 || samples > JB_MAX_FRAME_SAMPLES) {
+        samples = jb->last_frame_samples;
+    }
+    
     // 填充槽
     slot->state = JB_SLOT_FILLED;
-    slot->sequence = rtp->sequence;
-    slot->timestamp = rtp->timestamp;
-    slot->ssrc = rtp->ssrc;
-    slot->payload_len = MIN(payload_len, OPUS_MAX_PACKET);
-    memcpy(slot->payload, payload, slot->payload_len);
-    slot->recv_time = now;
-    slot->decoded_samples = 0;
+    slot->sequence = sequence;
+    slot->timestamp = timestamp;
+    slot->payload_len = payload_len;
+    slot->payload_off = (uint16_t)payload_off;
+    slot->samples = (uint16_t)samples;
+    slot->vad = pkt->vad;
+    memcpy(slot_payload(jb, slot), payload, payload_len);
+    
+    // 更新已缓冲的最晚结束时间戳
+    uint32_t end_ts = timestamp + samples;
+    if (jb->count == 0 || (int32_t)(end_ts - jb->end_ts) > 0) {
+        jb->end_ts = end_ts;
+    }
     
     jb->count++;
     jb->stats.packets_received++;
     
-    MutexUnlock(&jb->mutex);
     return 0;
 }
 
-int JitterBuffer_Get(JitterBuffer* jb, int16_t* samples, int max_samples) {
-    if (!jb || !samples || max_samples < AUDIO_FRAME_SAMPLES) {
-        return -1;
+/**
+ * @brief 无锁模式: 在入队负载区分配 len 字节 (接收线程)
+ * 
+ * 入口队列先进先出, 负载区是普通环形缓冲: 空闲区间为写入位置到最早未取出项之间.
+ * 写入位置不追上最早项的起点 (严格小于), 避免满与空无法区分.
+ * @return 偏移, <0 表示空间不足
+ */
+static int ingress_alloc(JitterBuffer* jb, int32_t head, int32_t tail, int len) {
+    if (head == tail) {
+        // 队列空: 从头开始
+        return len <= jb->ingress_size ? 0 : -1;
+    }
+    
+    int pos = jb->ingress_write;
+    int oldest = jb->ingress[head & (JB_INGRESS_SLOTS - 1)].payload_off;
+    if (pos >= oldest) {
+        // 空闲: [pos, size) 与 [0, oldest)
+        if (pos + len <= jb->ingress_size) return pos;
+        return len < oldest ? 0 : -1;
+    }
+    
+    // 空闲: [pos, oldest)
+    return pos + len < oldest ? pos : -1;
+}
+
+/**
+ * @brief 无锁模式: 接收线程将包写入入口队列
+ * @return 0 成功, -3 队列满, -4 超过单包最大字节数
+ */
+static int ingress_push(JitterBuffer* jb, const RtpHeader* rtp,
+                        const uint8_t* payload, uint16_t payload_len, uint64_t now) {
+    if (payload_len > jb->max_payload) {
+        AtomicInc(&jb->ingress_oversize);
+        return -4;
+    }
+    
+    int32_t tail = jb->ingress_tail;                // 只有本线程写
+    int32_t head = AtomicRead(&jb->ingress_head);
+    int off = tail - head < JB_INGRESS_SLOTS ? ingress_alloc(jb, head, tail, payload_len) : -1;
+    if (off < 0) {
+        AtomicInc(&jb->ingress_drops);
+        return -3;  // 播放线程长时间未取数据
     }
     
+    int idx = tail & (JB_INGRESS_SLOTS - 1);
+    JitterIngress* e = &jb->ingress[idx];
+    e->sequence = rtp->sequence;
+    e->timestamp = rtp->timestamp;
+    e->payload_len = payload_len;
+    e->payload_off = (uint16_t)off;
+    e->recv_time = now;
+    e->ssrc = rtp->ssrc;
+    e->marker = RtpHeader_GetMarker(rtp);
+    e->vad = RtpHeader_GetVadActive(rtp);
+    memcpy(jb->ingress_pool + off, payload, payload_len);
+    jb->ingress_write = off + payload_len;
+    
+    // 发布 (Interlocked 为完整内存屏障, 保证上面的写入先可见)
+    AtomicSet(&jb->ingress_tail, tail + 1);
+    return 0;
+}
+
+/**
+ * @brief 无锁模式: 播放线程取出入口队列中的所有包 (持有锁)
+ */
+static void ingress_drain(JitterBuffer* jb) {
+    int32_t head = jb->ingress_head;                // 只有本线程写
+    int32_t tail = AtomicRead(&jb->ingress_tail);
+    
+    for (; head != tail; head++) {
+        int idx = head & (JB_INGRESS_SLOTS - 1);
+        JitterIngress* e = &jb->ingress[idx];
+        insert_packet(jb, e, jb->ingress_pool + e->payload_off);
+    }
+    
+    // 释放已取出的队列项
+    AtomicSet(&jb->ingress_head, head);
+}
+
+/**
+ * @brief 记录一次收包耗时
+ */
+static void record_put_cost(JitterBuffer* jb, uint64_t t0) {
+    float cost_us = (float)(GetTimeUs() - t0);
+    jb->put_cost_us += (cost_us - jb->put_cost_us) / 16.0f;
+    if (cost_us > jb->put_cost_max_us) {
+        jb->put_cost_max_us = cost_us;
+    }
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+void JitterBuffer_GetDefaultConfig(JitterConfig* config) {
+    if (!config) return;
+    
+    config->min_delay_ms = JITTER_MIN_MS;
+    config->max_delay_ms = JITTER_MAX_MS;
+    config->target_delay_ms = JITTER_BUFFER_MS;
+    config->adaptive = true;
+    config->late_loss_rate = JITTER_LATE_LOSS;
+    config->max_payload = JITTER_MAX_PAYLOAD;
+    config->pool_bytes = 0;     // JITTER_PAYLOAD_POOL
+    config->lock_free = true;
+    config->drift_compensation = true;
+}
+
+JitterBuffer* JitterBuffer_Create(const JitterConfig* config) {
+    JitterBuffer* jb = (JitterBuffer*)calloc(1, sizeof(JitterBuffer));
+    if (!jb) return NULL;
+    
+    // 默认配置
+    if (config) {
+        jb->config = *config;
+    } else {
+        JitterBuffer_GetDefaultConfig(&jb->config);
+    }
+    
+    // 自适应初始目标取配置值, 收到数据后由直方图调整
+    jb->target_delay_ms = CLAMP(jb->config.target_delay_ms,
+                                jb->config.min_delay_ms, jb->config.max_delay_ms);
+    jb->stats.target_delay_ms = jb->target_delay_ms;
+    jb->buffering = true;
+    jb->last_frame_samples = AUDIO_FRAME_SAMPLES;
+    jb->cn_seed = 22222;
+    hist_init(&jb->hist_delay, JB_QHIST_DELAY_MS);
+    hist_init(&jb->hist_jitter, JB_QHIST_JITTER_US);
+    hist_init(&jb->hist_conceal, 1);
+    drift_reset(jb);
+    publish_snapshot(jb);
+    
+    // 负载池按总字节数分配, 每包占实际长度; 至少能放下两个最大包.
+    // 无锁模式的入队负载区接在后面, 取负载池的一半 (播放线程每次 Get 都会取空队列)
+    jb->max_payload = jb->config.max_payload ? jb->config.max_payload : OPUS_MAX_PACKET;
+    jb->pool_size = jb->config.pool_bytes ? jb->config.pool_bytes : JITTER_PAYLOAD_POOL;
+    jb->pool_size = CLAMP(jb->pool_size, 2 * jb->max_payload, UINT16_MAX);
+    if (jb->config.lock_free) {
+        jb->ingress_size = MAX(jb->pool_size / 2, 2 * jb->max_payload + 1);
+    }
+    
+    jb->payload_pool = (uint8_t*)malloc((size_t)jb->pool_size + jb->ingress_size);
+    if (!jb->payload_pool) {
+        free(jb);
+        return NULL;
+    }
+    if (jb->config.lock_free) {
+        jb->ingress_pool = jb->payload_pool + jb->pool_size;
+    }
+    
+    MutexInit(&jb->mutex);
+    
+    LOG_INFO("JitterBuffer created: target=%dms, min=%dms, max=%dms, adaptive=%d, lock_free=%d, drift=%d",
+             jb->config.target_delay_ms, jb->config.min_delay_ms, jb->config.max_delay_ms,
+             jb->config.adaptive, jb->config.lock_free, jb->config.drift_compensation);
+    
+    return jb;
+}
+
+void JitterBuffer_Destroy(JitterBuffer* jb) {
+    if (!jb) return;
+    
+    MutexDestroy(&jb->mutex);
+    free(jb->payload_pool);
+    free(jb);
+    
+    LOG_INFO("JitterBuffer destroyed");
+}
+
+void JitterBuffer_Reset(JitterBuffer* jb) {
+    if (!jb) return;
+    
     MutexLock(&jb->mutex);
     
-    if (!jb->seq_initialized) {
-        // 还没有收到任何包
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        jb->slots[i].state = JB_SLOT_EMPTY;
+    }
+    
+    jb->head = 0;
+    jb->tail = 0;
+    jb->count = 0;
+    jb->pool_write = 0;
+    jb->seq_initialized = false;
+    jb->time_initialized = false;
+    jb->jitter = 0;
+    jb->last_recv_time = 0;
+    jb->last_timestamp = 0;
+    
+    memset(jb->delay_hist, 0, sizeof(jb->delay_hist));
+    jb->ext_timestamp = 0;
+    jb->transit_count = 0;
+    jb->target_delay_ms = CLAMP(jb->config.target_delay_ms,
+                                jb->config.min_delay_ms, jb->config.max_delay_ms);
+    jb->buffering = true;
+    jb->fast_start = false;
+    jb->over_target_count = 0;
+    jb->out_len = 0;
+    jb->out_pos = 0;
+    jb->last_frame_samples = AUDIO_FRAME_SAMPLES;
+    jb->in_dtx = false;
+    jb->cn_level = 0;
+    jb->cn_samples = 0;
+    hist_init(&jb->hist_delay, JB_QHIST_DELAY_MS);
+    hist_init(&jb->hist_jitter, JB_QHIST_JITTER_US);
+    hist_init(&jb->hist_conceal, 1);
+    jb->conceal_run = 0;
+    
+    memset(&jb->stats, 0, sizeof(jb->stats));
+    drift_reset(jb);
+    jb->stats.target_delay_ms = jb->target_delay_ms;
+    
+    // 入口队列 (须在收包线程停止时调用)
+    AtomicSet(&jb->ingress_head, 0);
+    AtomicSet(&jb->ingress_tail, 0);
+    jb->ingress_write = 0;
+    AtomicSet(&jb->ingress_drops, 0);
+    AtomicSet(&jb->ingress_oversize, 0);
+    jb->put_cost_us = 0;
+    jb->put_cost_max_us = 0;
+    
+    publish_snapshot(jb);
+    MutexUnlock(&jb->mutex);
+    
+    LOG_DEBUG("JitterBuffer reset");
+}
+
+int JitterBuffer_Put(JitterBuffer* jb, const RtpHeader* rtp, 
+                     const uint8_t* payload, uint16_t payload_len, uint64_t recv_time_us) {
+    if (!jb || !rtp || !payload || payload_len == 0) {
+        return -1;
+    }
+    
+    uint64_t t0 = GetTimeUs();
+    uint64_t now = recv_time_us;
+    if (now == 0) {
+        now = jb->clock_func ? jb->clock_func(jb->clock_ctx) : GetTimeUs();
+    }
+    int ret;
+    
+    if (jb->config.lock_free) {
+        // 无锁模式: 只入队, 排序与抖动估计由播放线程完成
+        ret = ingress_push(jb, rtp, payload, payload_len, now);
+    } else {
+        MutexLock(&jb->mutex);
+        JitterIngress pkt = { rtp->sequence, payload_len, rtp->timestamp, now, rtp->ssrc,
+                              RtpHeader_GetMarker(rtp), RtpHeader_GetVadActive(rtp), 0 };
+        ret = insert_packet(jb, &pkt, payload);
         MutexUnlock(&jb->mutex);
-        return 0;
     }
     
-    uint64_t now = GetTickCount64Ms();
+    record_put_cost(jb, t0);
+    return ret;
+}
+
+int JitterBuffer_Get(JitterBuffer* jb, int16_t* samples, int num_samples) {
+    if (!jb || !samples || num_samples <= 0) {
+        return -1;
+    }
     
-    // 计算目标延迟内应该播放的包
-    // 检查 head 位置的包是否应该播放
-    JitterSlot* slot = &jb->slots[jb->head];
+    MutexLock(&jb->mutex);
     
-    // 自适应: 检查缓冲级别
-    int level_ms = JitterBuffer_GetLevel(jb);
+    if (jb->config.lock_free) {
+        ingress_drain(jb);
+    }
     
-    // 缓冲区还没达到目标延迟, 继续等待
-    if (level_ms < (int)jb->config.target_delay_ms && jb->count < 3) {
+    if (!jb->seq_initialized) {
+        // 还没有收到任何包
+        publish_snapshot(jb);
         MutexUnlock(&jb->mutex);
-        return 0;  // 等待更多数据
+        return 0;
     }
     
-    // 检查当前槽
-    if (slot->state == JB_SLOT_EMPTY) {
-        // 期望的包没有到达 - PLC
-        jb->stats.packets_lost++;
-        jb->stats.underruns++;
+    int written = 0;
+    
+    while (written < num_samples) {
+        // 先输出上次解码剩余的部分
+        if (jb->out_pos < jb->out_len) {
+            int n = MIN(jb->out_len - jb->out_pos, num_samples - written);
+            memcpy(samples + written, jb->out_buf + jb->out_pos, n * sizeof(int16_t));
+            jb->out_pos += n;
+            written += n;
+            continue;
+        }
         
-        int plc_samples = plc_frame(jb, samples, AUDIO_FRAME_SAMPLES);
+        // 输出缓冲已取空, 取下一包 (先做收缩丢帧, 之后 head 不再变化)
+        jb->out_pos = 0;
+        jb->out_len = 0;
+        shrink_head(jb);
         
-        // 移动到下一个序列号
-        jb->next_seq++;
-        jb->head = (jb->head + 1) % JITTER_BUFFER_SLOTS;
+        TsmMode mode = choose_stretch_mode(jb);
+        bool decoded = false;
         
-        // 更新丢包率
-        if (jb->stats.packets_received > 0) {
-            jb->stats.loss_rate = (float)jb->stats.packets_lost / 
-                                   (jb->stats.packets_received + jb->stats.packets_lost);
+        if (jb->drift_active) {
+            // 漂移补偿: 每帧都经重采样 (保持连续), 再按需伸缩.
+            // 输出缓冲此时为空, 先借用它存放解码帧, 重采样到暂存帧后再伸缩回来
+            int n = pop_frame(jb, jb->out_buf, JB_MAX_FRAME_SAMPLES, &decoded);
+            if (n <= 0) break;
+            float ratio = 1.0f + jb->stats.drift_ppm * 1e-6f;
+            n = Resampler_Process(&jb->resampler, ratio, jb->out_buf, n,
+                                  g_scratch, JB_SCRATCH_SAMPLES);
+            if (n <= 0) continue;
+            stretch_frame(jb, mode, g_scratch, n, decoded);
+            continue;
         }
         
-        MutexUnlock(&jb->mutex);
-        return plc_samples;
-    }
-    
-    // 解码
-    if (slot->state == JB_SLOT_FILLED) {
-        if (decode_slot(jb, slot) < 0) {
-            // 解码失败 - PLC
-            int plc_samples = plc_frame(jb, samples, AUDIO_FRAME_SAMPLES);
-            
-            slot->state = JB_SLOT_EMPTY;
-            jb->next_seq++;
-            jb->head = (jb->head + 1) % JITTER_BUFFER_SLOTS;
-            jb->count--;
-            
-            MutexUnlock(&jb->mutex);
-            return plc_samples;
+        if (mode != TSM_NORMAL) {
+            // 需要伸缩: 先解码到暂存帧, 伸缩后写入输出缓冲
+            int n = pop_frame(jb, g_scratch, JB_MAX_FRAME_SAMPLES, &decoded);
+            if (n <= 0) break;
+            stretch_frame(jb, mode, g_scratch, n, decoded);
+            continue;
         }
+        
+        if (head_samples(jb) <= num_samples - written) {
+            // 整包放得下: 直接解码到调用者缓冲区
+            int n = pop_frame(jb, samples + written, num_samples - written, &decoded);
+            if (n <= 0) break;
+            written += n;
+            continue;
+        }
+        
+        // 放不下: 解码到输出缓冲, 剩余部分留给下次调用
+        int n = pop_frame(jb, jb->out_buf, JB_OUT_BUF_SAMPLES, &decoded);
+        if (n <= 0) break;
+        jb->out_len = n;
     }
     
-    // 输出解码数据
-    int output_samples = MIN(slot->decoded_samples, max_samples);
-    memcpy(samples, slot->decoded, output_samples * sizeof(int16_t));
+    publish_snapshot(jb);
+    MutexUnlock(&jb->mutex);
     
-    // 清空槽
-    slot->state = JB_SLOT_EMPTY;
-    jb->next_seq++;
-    jb->head = (jb->head + 1) % JITTER_BUFFER_SLOTS;
-    jb->count--;
+    if (written == 0) {
+        return 0;
+    }
     
-    MutexUnlock(&jb->mutex);
-    return output_samples;
+    // 欠载时剩余部分补零
+    if (written < num_samples) {
+        memset(samples + written, 0, (num_samples - written) * sizeof(int16_t));
+    }
+    
+    return num_samples;
 }
 
 int JitterBuffer_GetLevel(JitterBuffer* jb) {
     if (!jb) return 0;
     
-    // 简单计算: 包数 * 帧长
-    return jb->count * AUDIO_FRAME_MS;
+    // 已缓冲包覆盖的时长 + 输出缓冲中尚未播放的部分
+    return (buffered_samples(jb) + jb->out_len - jb->out_pos) * 1000 / AUDIO_SAMPLE_RATE;
 }
 
 void JitterBuffer_GetStats(JitterBuffer* jb, JitterStats* stats) {
@@ -386,6 +1419,51 @@ void JitterBuffer_GetStats(JitterBuffer* jb, JitterStats* stats) {
     MutexLock(&jb->mutex);
     *stats = jb->stats;
     MutexUnlock(&jb->mutex);
+    
+    // 接收线程维护的计数
+    stats->overruns += (uint32_t)AtomicRead(&jb->ingress_drops);
+    stats->packets_oversize += (uint32_t)AtomicRead(&jb->ingress_oversize);
+    stats->put_cost_us = jb->put_cost_us;
+    stats->put_cost_max_us = jb->put_cost_max_us;
+}
+
+bool JitterBuffer_GetSnapshot(JitterBuffer* jb, JitterSnapshot* snap) {
+    if (!jb || !snap) return false;
+    
+    for (int i = 0; i < JB_SNAPSHOT_RETRIES; i++) {
+        int32_t seq = AtomicRead(&jb->snapshot_seq);
+        if (seq & 1) {
+            continue;  // 播放线程正在写入
+        }
+        
+        memcpy(snap, &jb->snapshot, sizeof(*snap));
+        
+        // 复制期间没有新的写入, 快照一致
+        AtomicFence();
+        if (AtomicRead(&jb->snapshot_seq) == seq) {
+            snap->stats.overruns += (uint32_t)AtomicRead(&jb->ingress_drops);
+            snap->stats.packets_oversize += (uint32_t)AtomicRead(&jb->ingress_oversize);
+            snap->stats.put_cost_us = jb->put_cost_us;
+            snap->stats.put_cost_max_us = jb->put_cost_max_us;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+uint32_t JitterHistogram_Percentile(const JitterHistogram* hist, float percentile) {
+    if (!hist || hist->count == 0) return 0;
+    
+    uint32_t threshold = (uint32_t)ceilf(hist->count * CLAMP(percentile, 0.0f, 1.0f));
+    uint32_t cumulative = 0;
+    for (int i = 0; i < JB_QHIST_BINS; i++) {
+        cumulative += hist->bins[i];
+        if (cumulative >= MAX(threshold, 1)) {
+            return (uint32_t)(i + 1) * hist->bin_width - 1;
+        }
+    }
+    return JB_QHIST_BINS * hist->bin_width - 1;
 }
 
 void JitterBuffer_SetDecoder(JitterBuffer* jb, void* decoder, OpusDecodeFunc decode_func) {
@@ -404,3 +1482,20 @@ void JitterBuffer_SetPlc(JitterBuffer* jb, PlcFunc plc_func) {
     jb->plc_func = plc_func;
     MutexUnlock(&jb->mutex);
 }
+
+void JitterBuffer_SetClock(JitterBuffer* jb, JitterClockFunc clock_func, void* ctx) {
+    if (!jb) return;
+    
+    MutexLock(&jb->mutex);
+    jb->clock_func = clock_func;
+    jb->clock_ctx = ctx;
+    MutexUnlock(&jb->mutex);
+}
+
+void JitterBuffer_SetPacketSamples(JitterBuffer* jb, PacketSamplesFunc samples_func) {
+    if (!jb) return;
+    
+    MutexLock(&jb->mutex);
+    jb->samples_func = samples_func;
+    MutexUnlock(&jb->mutex);
+}
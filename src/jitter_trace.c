@@ -0,0 +1,133 @@
+/**
+ * @file jitter_trace.c
+ * @brief 抖动缓冲到达轨迹实现
+ *
+ * 只依赖标准 C 文件 I/O, 录制端 (Windows 客户端) 与回放端 (可在 Linux 上编译)
+ * 共用同一份代码.
+ */
+
+#include "jitter_trace.h"
+
+//=============================================================================
+// 内部结构
+//=============================================================================
+struct JitterTrace {
+    FILE*   file;
+    bool    writing;
+};
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+JitterTrace* JitterTrace_Create(const char* path) {
+    if (!path) return NULL;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        LOG_ERROR("JitterTrace: cannot create %s", path);
+        return NULL;
+    }
+
+    JitterTraceFileHeader hdr = {0};
+    hdr.magic = JITTER_TRACE_MAGIC;
+    hdr.version = JITTER_TRACE_VERSION;
+    hdr.sample_rate = AUDIO_SAMPLE_RATE;
+
+    if (fwrite(&hdr, sizeof(hdr), 1, file) != 1) {
+        fclose(file);
+        return NULL;
+    }
+
+    JitterTrace* trace = (JitterTrace*)calloc(1, sizeof(JitterTrace));
+    if (!trace) {
+        fclose(file);
+        return NULL;
+    }
+
+    trace->file = file;
+    trace->writing = true;
+
+    LOG_INFO("JitterTrace: recording to %s", path);
+    return trace;
+}
+
+JitterTrace* JitterTrace_Open(const char* path) {
+    if (!path) return NULL;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        LOG_ERROR("JitterTrace: cannot open %s", path);
+        return NULL;
+    }
+
+    JitterTraceFileHeader hdr;
+    if (fread(&hdr, sizeof(hdr), 1, file) != 1 ||
+        hdr.magic != JITTER_TRACE_MAGIC || hdr.version != JITTER_TRACE_VERSION) {
+        LOG_ERROR("JitterTrace: %s is not a trace file", path);
+        fclose(file);
+        return NULL;
+    }
+
+    JitterTrace* trace = (JitterTrace*)calloc(1, sizeof(JitterTrace));
+    if (!trace) {
+        fclose(file);
+        return NULL;
+    }
+
+    trace->file = file;
+    trace->writing = false;
+    return trace;
+}
+
+void JitterTrace_Close(JitterTrace* trace) {
+    if (!trace) return;
+
+    fclose(trace->file);
+    free(trace);
+}
+
+bool JitterTrace_Write(JitterTrace* trace, const RtpHeader* rtp,
+                       const uint8_t* payload, uint16_t payload_len,
+                       int samples, uint64_t recv_time_us) {
+    if (!trace || !trace->writing || !rtp) return false;
+
+    JitterTraceRecord rec = {0};
+    rec.recv_time_us = recv_time_us;
+    rec.ssrc = rtp->ssrc;
+    rec.timestamp = rtp->timestamp;
+    rec.sequence = rtp->sequence;
+    rec.flags = rtp->flags;
+    rec.payload_len = payload ? payload_len : 0;
+    rec.samples = (uint16_t)CLAMP(samples, 0, UINT16_MAX);
+
+    if (fwrite(&rec, sizeof(rec), 1, trace->file) != 1) {
+        return false;
+    }
+    if (rec.payload_len > 0 && fwrite(payload, rec.payload_len, 1, trace->file) != 1) {
+        return false;
+    }
+    return true;
+}
+
+bool JitterTrace_Read(JitterTrace* trace, JitterTraceRecord* record,
+                      uint8_t* payload, uint16_t max_payload) {
+    if (!trace || trace->writing || !record) return false;
+
+    if (fread(record, sizeof(*record), 1, trace->file) != 1) {
+        return false;
+    }
+
+    uint16_t keep = payload ? MIN(record->payload_len, max_payload) : 0;
+    if (keep > 0 && fread(payload, keep, 1, trace->file) != 1) {
+        return false;
+    }
+
+    // 跳过截断的部分
+    if (record->payload_len > keep) {
+        fseek(trace->file, record->payload_len - keep, SEEK_CUR);
+    }
+
+    record->payload_len = keep;
+    return true;
+}
@@ -16,21 +16,37 @@ static bool g_isServerMode = false;
 static bool g_running = true;
 static OpusCodec* g_opusEncoder = NULL;
 static uint32_t g_rtpTimestamp = 0;
+static char g_roomName[MAX_NAME_LEN] = "";     // --room: 加入会话后进入的房间 (空为大厅)
 
 static void OnAudioCapture(const int16_t* samples, int count, void* userdata) {
     if (!g_opusEncoder) return;
     uint8_t opus_data[OPUS_MAX_PACKET];
     int opus_len = OpusCodec_Encode(g_opusEncoder, samples, count, opus_data, sizeof(opus_data));
     if (opus_len > 0) {
+        // DTX 帧 (<= OPUS_DTX_MAX_BYTES) 由发送函数丢弃, 时间戳照常推进
+        bool voice = !OpusCodec_IsInDtx(g_opusEncoder);
+        uint8_t level = Audio_ComputeLevel(samples, count);
         if (g_isServerMode) {
-            Server_SendOpusAudio(opus_data, opus_len, g_rtpTimestamp);
+            Server_SendOpusAudio(opus_data, opus_len, g_rtpTimestamp, voice, level);
         } else {
-            Client_SendOpusAudio(opus_data, opus_len, g_rtpTimestamp);
+            Client_SendOpusAudio(opus_data, opus_len, g_rtpTimestamp, voice, level);
         }
         g_rtpTimestamp += count;
     }
 }
 
+/**
+ * @brief 刷新界面用户列表 (服务器模式为所有连接, 客户端模式为当前房间; 最多 MAX_SESSIONS 项, 不放在栈上)
+ */
+static void RefreshPeerList(void) {
+    PeerInfo* peers = (PeerInfo*)malloc(MAX_SESSIONS * sizeof(PeerInfo));
+    if (!peers) return;
+    int count = g_isServerMode ? Server_GetClients(peers, MAX_SESSIONS)
+                               : Client_GetPeers(peers, MAX_SESSIONS);
+    Gui_UpdatePeerList(peers, count);
+    free(peers);
+}
+
 static void OnServerStarted(void* userdata) {
     Gui_SetServerRunning(true);
     Gui_AddLog("Server started");
@@ -45,16 +61,12 @@ static void OnClientJoined(uint32_t client_id, const char* name, void* userdata)
     char msg[128];
     snprintf(msg, sizeof(msg), "User joined: %s", name);
     Gui_AddLog(msg);
-    PeerInfo peers[MAX_CLIENTS];
-    int count = Server_GetClients(peers, MAX_CLIENTS);
-    Gui_UpdatePeerList(peers, count);
+    RefreshPeerList();
 }
 
 static void OnClientLeft(uint32_t client_id, void* userdata) {
     Gui_AddLog("User left");
-    PeerInfo peers[MAX_CLIENTS];
-    int count = Server_GetClients(peers, MAX_CLIENTS);
-    Gui_UpdatePeerList(peers, count);
+    RefreshPeerList();
 }
 
 static void OnServerError(const char* msg, void* userdata) {
@@ -90,20 +102,23 @@ static void OnPeerJoined(const PeerInfo* peer, void* userdata) {
     char msg[128];
     snprintf(msg, sizeof(msg), "User joined: %s", peer->name);
     Gui_AddLog(msg);
-    PeerInfo peers[MAX_CLIENTS];
-    int count = Client_GetPeers(peers, MAX_CLIENTS);
-    Gui_UpdatePeerList(peers, count);
+    RefreshPeerList();
 }
 
 static void OnPeerLeft(uint32_t client_id, void* userdata) {
     Gui_AddLog("User left");
-    PeerInfo peers[MAX_CLIENTS];
-    int count = Client_GetPeers(peers, MAX_CLIENTS);
-    Gui_UpdatePeerList(peers, count);
+    RefreshPeerList();
 }
 
 static void OnPeerListReceived(const PeerInfo* peers, int count, void* userdata) {
-    Gui_UpdatePeerList(peers, count);
+    // 列表可能分成多个包, 显示累计后的完整列表
+    RefreshPeerList();
+}
+
+static void OnRoomJoined(uint32_t room_id, const char* room_name, void* userdata) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Room: %s", room_name);
+    Gui_AddLog(msg);
 }
 
 static void OnClientError(const char* msg, void* userdata) {
@@ -195,6 +210,10 @@ static void OnGuiConnect(const char* ip, uint16_t tcp_port, uint16_t udp_port, v
         return;
     }
     
+    if (g_roomName[0]) {
+        Client_JoinRoom(g_roomName);
+    }
+    
     g_rtpTimestamp = 0;
     Audio_StartCapture(OnAudioCapture, NULL);
     Audio_StartPlayback();
@@ -230,6 +249,31 @@ static void OnGuiVolumeChanged(int input, int output, void* userdata) {
     Audio_SetPlaybackVolume(output / 100.0f);
 }
 
+/**
+ * @brief 输出每个接收流的播放质量分位数
+ */
+static void LogStreamQuality(void) {
+    PeerInfo* peers = (PeerInfo*)malloc(MAX_SESSIONS * sizeof(PeerInfo));
+    if (!peers) return;
+    int count = Client_GetPeers(peers, MAX_SESSIONS);
+
+    for (int i = 0; i < count; i++) {
+        JitterSnapshot snap;
+        if (!Client_GetStreamSnapshot(peers[i].ssrc, &snap)) continue;
+
+        LOG_DEBUG("Quality %s: delay p50/p95/p99 %u/%u/%u ms, jitter p95 %u us, "
+                  "conceal run p99 %u, level %d ms, loss %.1f%%, drift %.1f ppm",
+                  peers[i].name,
+                  JitterHistogram_Percentile(&snap.delay_ms, 0.50f),
+                  JitterHistogram_Percentile(&snap.delay_ms, 0.95f),
+                  JitterHistogram_Percentile(&snap.delay_ms, 0.99f),
+                  JitterHistogram_Percentile(&snap.jitter_us, 0.95f),
+                  JitterHistogram_Percentile(&snap.conceal_run, 0.99f),
+                  snap.level_ms, snap.stats.loss_rate * 100.0f, snap.stats.drift_ppm);
+    }
+    free(peers);
+}
+
 static VOID CALLBACK UpdateTimerProc(HWND hwnd, UINT msg, UINT_PTR id, DWORD time) {
     float inputLevel = Audio_GetCaptureLevel();
     float outputLevel = Audio_GetPlaybackLevel();
@@ -239,6 +283,48 @@ static VOID CALLBACK UpdateTimerProc(HWND hwnd, UINT msg, UINT_PTR id, DWORD tim
         float jitter_ms, loss_rate;
         int buffer_level;
         Client_GetJitterStats(&jitter_ms, &loss_rate, &buffer_level);
+
+        static DWORD lastQuality = 0;
+        if (time - lastQuality > 5000) {
+            lastQuality = time;
+            LogStreamQuality();
+        }
+    }
+    
+    if (g_isServerMode) {
+        static DWORD lastMcu = 0;
+        McuStats mcu;
+        if (time - lastMcu > 5000 && Server_GetMcuStats(&mcu)) {
+            lastMcu = time;
+            LOG_DEBUG("MCU: %d sources -> %d listeners, tick %.0f us (max %.0f), %.0f us/listener, "
+                      "%u encoded, %u idle, %u skipped ticks",
+                      mcu.sources, mcu.listeners, mcu.tick_cost_us, mcu.tick_cost_max_us,
+                      mcu.listener_cost_us, mcu.frames_encoded, mcu.frames_idle, mcu.ticks_skipped);
+        }
+        
+        static DWORD lastPipeline = 0;
+        ServerPipelineStats pipe;
+        if (time - lastPipeline > 5000 && Server_GetPipelineStats(&pipe)) {
+            lastPipeline = time;
+            char workers[16 * SERVER_MAX_AUDIO_WORKERS] = "";
+            for (int i = 0, n = 0; i < pipe.audio_workers; i++) {
+                n += snprintf(workers + n, sizeof(workers) - n, i ? "/%u" : "%u", pipe.worker_packets[i]);
+            }
+            LOG_DEBUG("Forward: %u received by %d workers (%s), %u forwarded "
+                      "(%u below top speakers, rejected %u unknown, %u spoofed), "
+                      "latency %.0f us (max %.0f), "
+                      "%.2f syscalls/datagram (%s); "
+                      "decode: %u/%u, %u dropped, queue %d (max %d), %.0f us/packet, %.0f us queued",
+                      pipe.packets_received, pipe.audio_workers, workers,
+                      pipe.packets_forwarded, pipe.packets_suppressed,
+                      pipe.packets_unknown, pipe.packets_spoofed,
+                      pipe.forward_latency_us, pipe.forward_latency_max_us,
+                      pipe.fanout.datagrams ? (float)pipe.fanout.syscalls / pipe.fanout.datagrams : 0.0f,
+                      pipe.fanout.rio ? "RIO" : "sendto",
+                      pipe.decode.decoded, pipe.decode.submitted, pipe.decode.dropped,
+                      pipe.decode.queue_depth, pipe.decode.queue_max,
+                      pipe.decode.decode_cost_us, pipe.decode.queue_delay_us);
+        }
     }
     
     static DWORD lastRefresh = 0;
@@ -255,7 +341,6 @@ static VOID CALLBACK UpdateTimerProc(HWND hwnd, UINT msg, UINT_PTR id, DWORD tim
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine, int nCmdShow) {
     (void)hPrevInstance;
-    (void)lpCmdLine;
     (void)nCmdShow;
     
     // 初始化Opus动态加载 (从嵌入资源中提取DLL)
@@ -301,10 +386,43 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         .onPeerJoined = OnPeerJoined,
         .onPeerLeft = OnPeerLeft,
         .onPeerListReceived = OnPeerListReceived,
+        .onRoomJoined = OnRoomJoined,
         .onError = OnClientError
     };
     Client_SetCallbacks(&clientCb);
     
+    // --jitter-trace <文件>: 录制接收包到达轨迹
+    const char* trace_arg = lpCmdLine ? strstr(lpCmdLine, "--jitter-trace ") : NULL;
+    if (trace_arg) {
+        char trace_path[MAX_PATH];
+        if (sscanf(trace_arg + strlen("--jitter-trace "), "%259s", trace_path) == 1) {
+            Client_StartJitterTrace(trace_path);
+        }
+    }
+    
+    // --room <名称>: 连接后进入指定房间 (只与同房间的用户通话)
+    const char* room_arg = lpCmdLine ? strstr(lpCmdLine, "--room ") : NULL;
+    if (room_arg) {
+        sscanf(room_arg + strlen("--room "), "%31s", g_roomName);
+    }
+    
+    // --mcu: 服务器混音, 每个客户端只收到一路 mix-minus 流
+    if (lpCmdLine && strstr(lpCmdLine, "--mcu")) {
+        Server_SetMcuMode(true);
+    }
+    
+    // --audio-workers <N>: UDP 音频接收/转发线程数 (占用 N 个连续的音频端口)
+    const char* workers_arg = lpCmdLine ? strstr(lpCmdLine, "--audio-workers ") : NULL;
+    if (workers_arg) {
+        Server_SetAudioWorkers(atoi(workers_arg + strlen("--audio-workers ")));
+    }
+    
+    // --speakers <N>: 转发模式下每个房间只转发最响的 N 路 (0 为全部转发)
+    const char* speakers_arg = lpCmdLine ? strstr(lpCmdLine, "--speakers ") : NULL;
+    if (speakers_arg) {
+        Server_SetMaxSpeakers(atoi(speakers_arg + strlen("--speakers ")));
+    }
+    
     GuiCallbacks guiCb = {
         .onStartServer = OnGuiStartServer,
         .onStopServer = OnGuiStopServer,
@@ -0,0 +1,450 @@
+/**
+ * @file mcu.c
+ * @brief 服务器混音 (MCU) 实现
+ *
+ * 工作原理:
+ * 1. UDP 接收线程 -> Mcu_Put -> StreamMixer_Put (按 SSRC 分流, 各自抖动缓冲)
+ * 2. 混音线程每 MCU_TICK_MS -> StreamMixer_GetFrames 取各路一帧及 32 位总和
+ * 3. 对每个收听者: 总和 - 自身一路 -> 限幅 -> 该收听者的编码器 -> RTP 发送
+ *
+ * mix-minus 由总和减去自身得到, 每周期混音代价为 O(发送者 + 收听者) 而不是 O(N^2).
+ * 编码器有状态, 不能在收听者之间共享; 没有其他人说话且编码器已进入 DTX 时
+ * 跳过编码 (接收端按时间戳间隙生成舒适噪声), 空闲房间几乎不占 CPU.
+ *
+ * 收听者的编码器只在混音线程中创建/销毁, 按每周期获取的收听者列表增删.
+ */
+
+#include "mcu.h"
+#include "network.h"
+#include "opus_codec.h"
+#include "stream_mixer.h"
+
+//=============================================================================
+// 内部结构
+//=============================================================================
+
+/**
+ * @brief 单个收听者的输出流
+ */
+typedef struct {
+    bool        active;
+    bool        seen;           // 本周期仍在收听者列表中
+    bool        marker;         // 下一个语音包置 marker (新讲话段)
+    bool        idle;           // 无人说话且编码器已进入 DTX
+    uint32_t    ssrc;
+    uint32_t    room;
+    SOCKADDR_IN addr;
+    SOCKET      sock;
+    OpusCodec*  encoder;
+    uint16_t    sequence;
+} McuOutput;
+
+struct Mcu {
+    uint32_t         ssrc;
+    McuListenersFunc listeners_func;
+    McuSourceRoomsFunc rooms_func;
+    void*            ctx;
+
+    // 每个发送者独立的抖动缓冲 + 解码器
+    StreamMixer*     mixer;
+
+    // 每个收听者独立的编码器 (仅混音线程访问)
+    McuOutput        outputs[MCU_MAX_LISTENERS];
+    uint32_t         timestamp;
+
+    // 混音暂存 (仅混音线程访问), 每个房间一路求和 (发送者各在不同房间时最多 MIXER_MAX_STREAMS 个)
+    int32_t          total[AUDIO_FRAME_SAMPLES];
+    int32_t          room_total[MIXER_MAX_STREAMS][AUDIO_FRAME_SAMPLES];
+    uint32_t         room_ids[MIXER_MAX_STREAMS];
+    int              room_sources[MIXER_MAX_STREAMS];
+    uint32_t         source_rooms[MIXER_MAX_STREAMS];
+    int16_t          mix[AUDIO_FRAME_SAMPLES];
+
+    // 统计
+    McuStats         stats;
+    Mutex            stats_mutex;
+
+    // 混音线程
+    Thread           thread;
+    Event            stop_event;
+    volatile bool    running;
+};
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 为收听者创建编码器
+ */
+static bool open_output(McuOutput* out, const McuListener* listener) {
+    OpusEncoderConfig config;
+    OpusCodec_GetDefaultEncoderConfig(&config);
+    config.complexity = MCU_ENCODER_COMPLEXITY;
+
+    out->encoder = OpusCodec_Create(&config, NULL);
+    if (!out->encoder) {
+        return false;
+    }
+
+    out->active = true;
+    out->seen = true;
+    out->marker = true;
+    out->idle = false;
+    out->ssrc = listener->ssrc;
+    out->room = listener->room;
+    out->addr = listener->addr;
+    out->sock = listener->sock;
+    out->sequence = (uint16_t)rand();
+
+    LOG_INFO("MCU: listener added (ssrc=%u)", listener->ssrc);
+    return true;
+}
+
+static void close_output(McuOutput* out) {
+    if (!out->active) return;
+
+    OpusCodec_Destroy(out->encoder);
+    LOG_INFO("MCU: listener removed (ssrc=%u)", out->ssrc);
+    memset(out, 0, sizeof(*out));
+}
+
+/**
+ * @brief 按当前收听者列表增删输出流
+ * @return 活动收听者数
+ */
+static int sync_outputs(Mcu* mcu, const McuListener* listeners, int count) {
+    for (int i = 0; i < MCU_MAX_LISTENERS; i++) {
+        mcu->outputs[i].seen = false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        McuOutput* out = NULL;
+        McuOutput* free_slot = NULL;
+        for (int j = 0; j < MCU_MAX_LISTENERS; j++) {
+            McuOutput* o = &mcu->outputs[j];
+            if (o->active && o->ssrc == listeners[i].ssrc) {
+                out = o;
+                break;
+            }
+            if (!o->active && !free_slot) {
+                free_slot = o;
+            }
+        }
+
+        if (out) {
+            out->seen = true;
+            out->addr = listeners[i].addr;     // 客户端重新加入时端口可能变化
+            out->sock = listeners[i].sock;
+            out->room = listeners[i].room;
+        } else if (free_slot) {
+            open_output(free_slot, &listeners[i]);
+        }
+    }
+
+    int active = 0;
+    for (int i = 0; i < MCU_MAX_LISTENERS; i++) {
+        McuOutput* o = &mcu->outputs[i];
+        if (o->active && !o->seen) {
+            close_output(o);
+        }
+        if (o->active) active++;
+    }
+    return active;
+}
+
+/**
+ * @brief mix-minus: out = clamp(total - own)
+ */
+static void mix_minus(const int32_t* total, const int16_t* own, int16_t* out, int n) {
+    if (own) {
+        for (int i = 0; i < n; i++) {
+            int32_t v = total[i] - own[i];
+            out[i] = (int16_t)CLAMP(v, -32768, 32767);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            out[i] = (int16_t)CLAMP(total[i], -32768, 32767);
+        }
+    }
+}
+
+/**
+ * @brief 查找房间在本周期求和表中的下标
+ * @param add 不存在时添加 (清零)
+ * @return 下标, 不存在且未添加返回 -1
+ */
+static int room_slot(Mcu* mcu, int* room_count, uint32_t room, bool add) {
+    for (int r = 0; r < *room_count; r++) {
+        if (mcu->room_ids[r] == room) return r;
+    }
+    if (!add || *room_count >= (int)ARRAY_SIZE(mcu->room_ids)) return -1;
+
+    int r = (*room_count)++;
+    mcu->room_ids[r] = room;
+    mcu->room_sources[r] = 0;
+    memset(mcu->room_total[r], 0, sizeof(mcu->room_total[r]));
+    return r;
+}
+
+/**
+ * @brief 按房间对各发送者求和
+ *
+ * 发送者的房间取自服务器路由 (rooms_func), 不依赖收听者列表; 只有服务器本地语音
+ * 归入 MCU_DEFAULT_ROOM, 已离开的发送者不混入任何房间.
+ * @return 本周期有发送者的房间数
+ */
+static int sum_rooms(Mcu* mcu, const uint32_t* ssrcs, const int16_t* const* pcm, int sources) {
+    // 没有房间查询时所有发送者在同一房间
+    for (int k = 0; k < sources; k++) {
+        mcu->source_rooms[k] = mcu->rooms_func ? MCU_NO_ROOM : MCU_DEFAULT_ROOM;
+    }
+    if (mcu->rooms_func && sources > 0) {
+        mcu->rooms_func(ssrcs, sources, mcu->source_rooms, mcu->ctx);
+    }
+
+    int room_count = 0;
+    for (int k = 0; k < sources; k++) {
+        uint32_t room = ssrcs[k] == mcu->ssrc ? MCU_DEFAULT_ROOM : mcu->source_rooms[k];
+        if (room == MCU_NO_ROOM) continue;
+
+        int r = room_slot(mcu, &room_count, room, true);
+        if (r < 0) continue;
+        int32_t* total = mcu->room_total[r];
+        for (int i = 0; i < AUDIO_FRAME_SAMPLES; i++) {
+            total[i] += pcm[k][i];
+        }
+        mcu->room_sources[r]++;
+    }
+    return room_count;
+}
+
+/**
+ * @brief 为一个收听者编码并发送本周期的混音
+ * @param total 收听者所在房间的求和
+ * @param own 收听者自身一路 (不在发送者中时为 NULL)
+ * @param others 除收听者外有数据的发送者数
+ * @param counts 累计本周期的编码/跳过/发送计数
+ */
+static void send_output(Mcu* mcu, McuOutput* out, const int32_t* total, const int16_t* own,
+                        int others, uint32_t timestamp, McuStats* counts) {
+    if (others == 0 && out->idle) {
+        counts->frames_idle++;
+        return;
+    }
+
+    mix_minus(total, own, mcu->mix, AUDIO_FRAME_SAMPLES);
+
+    uint8_t opus_data[OPUS_MAX_PACKET];
+    int opus_len = OpusCodec_Encode(out->encoder, mcu->mix, AUDIO_FRAME_SAMPLES,
+                                    opus_data, sizeof(opus_data));
+    counts->frames_encoded++;
+    if (opus_len <= 0) return;
+
+    bool voice = !OpusCodec_IsInDtx(out->encoder);
+    out->idle = others == 0 && !voice;
+
+    // DTX 帧不发送, 之后的语音包标记为新讲话段 (与 Server_SendOpusAudio 相同)
+    if (opus_len <= OPUS_DTX_MAX_BYTES) {
+        out->marker = true;
+        return;
+    }
+
+    RtpHeader rtp;
+    RtpHeader_Init(&rtp, mcu->ssrc, PAYLOAD_OPUS);
+    rtp.sequence = out->sequence++;
+    rtp.timestamp = timestamp;
+    rtp.payload_len = (uint16_t)opus_len;
+    RtpHeader_SetVadActive(&rtp, voice);
+    RtpHeader_SetMarker(&rtp, voice && out->marker);
+    out->marker = !voice;
+
+    if (Network_SendRtpPacket(out->sock, &rtp, opus_data, opus_len, &out->addr) > 0) {
+        counts->packets_sent++;
+    }
+}
+
+static DWORD WINAPI McuThreadProc(LPVOID param) {
+    Mcu* mcu = (Mcu*)param;
+    LOG_DEBUG("MCU thread started");
+
+    // 默认 15.6ms 的定时器粒度会让 tick 成批到达
+    timeBeginPeriod(1);
+
+    const uint64_t tick_us = MCU_TICK_MS * 1000;
+    uint64_t next = GetTimeUs();
+
+    while (mcu->running) {
+        next += tick_us;
+        uint64_t now = GetTimeUs();
+
+        if (next > now) {
+            DWORD wait_ms = (DWORD)((next - now + 999) / 1000);
+            if (EventWait(mcu->stop_event, wait_ms) == WAIT_OBJECT_0) break;
+        } else if (now - next > MCU_MAX_LAG_TICKS * tick_us) {
+            // 落后过多 (系统挂起 / 调试): 放弃追赶, 接收端按时间戳间隙处理
+            uint32_t skipped = (uint32_t)((now - next) / tick_us);
+            MutexLock(&mcu->stats_mutex);
+            mcu->stats.ticks_skipped += skipped;
+            MutexUnlock(&mcu->stats_mutex);
+            mcu->timestamp += skipped * AUDIO_FRAME_SAMPLES;
+            next = now;
+        }
+
+        Mcu_Tick(mcu);
+    }
+
+    timeEndPeriod(1);
+    LOG_DEBUG("MCU thread stopped");
+    return 0;
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+Mcu* Mcu_Create(uint32_t ssrc, McuListenersFunc listeners_func,
+                McuSourceRoomsFunc rooms_func, void* ctx) {
+    Mcu* mcu = (Mcu*)calloc(1, sizeof(Mcu));
+    if (!mcu) return NULL;
+
+    mcu->mixer = StreamMixer_Create(NULL);
+    if (!mcu->mixer) {
+        free(mcu);
+        return NULL;
+    }
+
+    mcu->ssrc = ssrc;
+    mcu->listeners_func = listeners_func;
+    mcu->rooms_func = rooms_func;
+    mcu->ctx = ctx;
+    mcu->timestamp = (uint32_t)rand() * AUDIO_FRAME_SAMPLES;
+    MutexInit(&mcu->stats_mutex);
+
+    LOG_INFO("MCU created: tick=%dms, encoder complexity=%d", MCU_TICK_MS, MCU_ENCODER_COMPLEXITY);
+    return mcu;
+}
+
+void Mcu_Destroy(Mcu* mcu) {
+    if (!mcu) return;
+
+    Mcu_Stop(mcu);
+
+    for (int i = 0; i < MCU_MAX_LISTENERS; i++) {
+        close_output(&mcu->outputs[i]);
+    }
+    StreamMixer_Destroy(mcu->mixer);
+    MutexDestroy(&mcu->stats_mutex);
+    free(mcu);
+
+    LOG_INFO("MCU destroyed");
+}
+
+bool Mcu_Start(Mcu* mcu) {
+    if (!mcu || mcu->running) return false;
+
+    mcu->stop_event = EventCreate();
+    mcu->running = true;
+    ThreadCreate(&mcu->thread, McuThreadProc, mcu);
+    return true;
+}
+
+void Mcu_Stop(Mcu* mcu) {
+    if (!mcu || !mcu->running) return;
+
+    mcu->running = false;
+    EventSet(mcu->stop_event);
+    ThreadJoin(mcu->thread);
+    ThreadClose(mcu->thread);
+    EventDestroy(mcu->stop_event);
+}
+
+int Mcu_Put(Mcu* mcu, const RtpHeader* rtp, const uint8_t* payload,
+            uint16_t payload_len, uint64_t recv_time_us) {
+    if (!mcu) return -1;
+    return StreamMixer_Put(mcu->mixer, rtp, payload, payload_len, recv_time_us);
+}
+
+void Mcu_RemoveSource(Mcu* mcu, uint32_t ssrc) {
+    if (!mcu) return;
+    StreamMixer_RemoveStream(mcu->mixer, ssrc);
+}
+
+void Mcu_Tick(Mcu* mcu) {
+    if (!mcu) return;
+
+    uint64_t t0 = GetTimeUs();
+
+    // 各发送者取一帧 (含抖动缓冲与解码) 并求和
+    uint32_t ssrcs[MIXER_MAX_STREAMS];
+    const int16_t* pcm[MIXER_MAX_STREAMS];
+    int sources = StreamMixer_GetFrames(mcu->mixer, AUDIO_FRAME_SAMPLES, ssrcs, pcm, mcu->total);
+    if (sources < 0) sources = 0;
+
+    McuListener listeners[MCU_MAX_LISTENERS];
+    int count = mcu->listeners_func ?
+                mcu->listeners_func(listeners, MCU_MAX_LISTENERS, mcu->ctx) : 0;
+    int active = sync_outputs(mcu, listeners, MIN(count, MCU_MAX_LISTENERS));
+
+    int room_count = sum_rooms(mcu, ssrcs, pcm, sources);
+
+    uint32_t timestamp = mcu->timestamp;
+    mcu->timestamp += AUDIO_FRAME_SAMPLES;
+
+    McuStats counts = {0};
+    for (int i = 0; i < MCU_MAX_LISTENERS; i++) {
+        McuOutput* out = &mcu->outputs[i];
+        if (!out->active) continue;
+
+        // 所在房间本周期无人发言时混音为静音
+        int r = room_slot(mcu, &room_count, out->room, false);
+        const int32_t* total = r >= 0 ? mcu->room_total[r] : NULL;
+        int room_sources = r >= 0 ? mcu->room_sources[r] : 0;
+
+        // 收听者列表与发送者房间取自两次路由查询, 其间换了房间的收听者自身一路
+        // 不在本房间的求和中, 不能减去
+        const int16_t* own = NULL;
+        for (int k = 0; total && k < sources; k++) {
+            if (ssrcs[k] == out->ssrc) {
+                if (mcu->source_rooms[k] == out->room) own = pcm[k];
+                break;
+            }
+        }
+
+        if (!total) {
+            memset(mcu->total, 0, sizeof(mcu->total));
+            total = mcu->total;
+        }
+        send_output(mcu, out, total, own, room_sources - (own ? 1 : 0), timestamp, &counts);
+    }
+
+    float cost_us = (float)(GetTimeUs() - t0);
+
+    MutexLock(&mcu->stats_mutex);
+    McuStats* st = &mcu->stats;
+    st->ticks++;
+    st->frames_encoded += counts.frames_encoded;
+    st->frames_idle += counts.frames_idle;
+    st->packets_sent += counts.packets_sent;
+    st->sources = sources;
+    st->listeners = active;
+    st->tick_cost_us += (cost_us - st->tick_cost_us) / 16.0f;
+    if (cost_us > st->tick_cost_max_us) {
+        st->tick_cost_max_us = cost_us;
+    }
+    if (active > 0) {
+        st->listener_cost_us += (cost_us / active - st->listener_cost_us) / 16.0f;
+    }
+
+    MutexUnlock(&mcu->stats_mutex);
+}
+
+void Mcu_GetStats(Mcu* mcu, McuStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!mcu) return;
+
+    MutexLock(&mcu->stats_mutex);
+    *stats = mcu->stats;
+    MutexUnlock(&mcu->stats_mutex);
+}
@@ -4,9 +4,130 @@
  */
 
 #include "network.h"
+#include <mswsock.h>
+#include <mstcpip.h>
+#include <stddef.h>
+
+// 内核收包时间戳 (SIO_TIMESTAMPING, Windows 10 起支持)
+#if defined(SIO_TIMESTAMPING) && defined(SO_TIMESTAMP)
+    #define NETWORK_RX_TIMESTAMPS
+#endif
+
+// Registered I/O (Windows 8 起支持), 一对多转发时批量提交发送
+#ifdef WSAID_MULTIPLE_RIO
+    #define NETWORK_RIO
+#endif
 
 static bool g_wsa_initialized = false;
 
+#ifdef NETWORK_RX_TIMESTAMPS
+static LPFN_WSARECVMSG g_wsa_recvmsg = NULL;    // 取时间戳控制消息需要 WSARecvMsg
+#endif
+
+#ifdef NETWORK_RIO
+static RIO_EXTENSION_FUNCTION_TABLE g_rio;
+static bool g_rio_loaded = false;
+
+/**
+ * @brief 批次槽: 数据报只写一次, 每个目标一个地址 (整体注册为 RIO 缓冲区)
+ */
+typedef struct {
+    uint8_t         packet[sizeof(RtpHeader) + OPUS_MAX_PACKET];
+    SOCKADDR_INET   addrs[NETWORK_BATCH_MAX];
+} BatchSlot;
+#endif
+
+struct UdpBatch {
+    SOCKET          sock;
+    Mutex           mutex;
+    UdpBatchStats   stats;
+#ifdef NETWORK_RIO
+    BatchSlot*      slots;                          // NETWORK_BATCH_DEPTH 个
+    RIO_BUFFERID    buffer_id;
+    RIO_CQ          cq;
+    RIO_RQ          rq;                             // RIO_INVALID_RQ 表示不可用
+    int             next;                           // 下一个使用的槽
+    int             outstanding[NETWORK_BATCH_DEPTH]; // 各槽在途发送数
+#endif
+};
+
+/**
+ * @brief 开启内核收包时间戳
+ * 
+ * 时间戳由协议栈在收到数据报时记录, 时间基准为 QPC (与 GetTimeUs 一致),
+ * 不受接收线程调度延迟影响. 系统不支持时 Network_RecvRtpPacket
+ * 退回到 recvfrom 返回后读取 GetTimeUs.
+ */
+static void enable_rx_timestamps(SOCKET sock) {
+#ifdef NETWORK_RX_TIMESTAMPS
+    DWORD bytes = 0;
+    TIMESTAMPING_CONFIG config = {0};
+    config.Flags = TIMESTAMPING_FLAG_RX;
+    if (WSAIoctl(sock, SIO_TIMESTAMPING, &config, sizeof(config),
+                 NULL, 0, &bytes, NULL, NULL) == SOCKET_ERROR) {
+        LOG_DEBUG("SIO_TIMESTAMPING not supported: %d", WSAGetLastError());
+        return;
+    }
+    
+    if (!g_wsa_recvmsg) {
+        GUID guid = WSAID_WSARECVMSG;
+        LPFN_WSARECVMSG fn = NULL;
+        if (WSAIoctl(sock, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid),
+                     &fn, sizeof(fn), &bytes, NULL, NULL) == SOCKET_ERROR) {
+            return;
+        }
+        g_wsa_recvmsg = fn;
+    }
+    
+    LOG_INFO("UDP audio: kernel receive timestamps enabled");
+#else
+    (void)sock;
+#endif
+}
+
+/**
+ * @brief 接收数据报并取得收包时间 (微秒, GetTimeUs 时间基准)
+ */
+static int recv_timestamped(SOCKET sock, uint8_t* buf, int len, SOCKADDR_IN* from,
+                            uint64_t* recv_time_us) {
+#ifdef NETWORK_RX_TIMESTAMPS
+    if (g_wsa_recvmsg) {
+        UINT64 control[(WSA_CMSG_SPACE(sizeof(UINT64)) + sizeof(UINT64) - 1) / sizeof(UINT64)];
+        WSABUF data = { (ULONG)len, (CHAR*)buf };
+        WSAMSG msg = {0};
+        msg.name = (LPSOCKADDR)from;
+        msg.namelen = sizeof(SOCKADDR_IN);
+        msg.lpBuffers = &data;
+        msg.dwBufferCount = 1;
+        msg.Control.buf = (CHAR*)control;
+        msg.Control.len = sizeof(control);
+        
+        DWORD n = 0;
+        if (g_wsa_recvmsg(sock, &msg, &n, NULL, NULL) == SOCKET_ERROR) {
+            return SOCKET_ERROR;
+        }
+        
+        *recv_time_us = 0;
+        for (WSACMSGHDR* cmsg = WSA_CMSG_FIRSTHDR(&msg); cmsg; cmsg = WSA_CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMP) {
+                UINT64 qpc;
+                memcpy(&qpc, WSA_CMSG_DATA(cmsg), sizeof(qpc));
+                *recv_time_us = QpcToUs(qpc);
+            }
+        }
+        if (*recv_time_us == 0) {
+            *recv_time_us = GetTimeUs();   // 该包没有时间戳 (如未开启的套接字)
+        }
+        return (int)n;
+    }
+#endif
+    
+    int fromLen = sizeof(SOCKADDR_IN);
+    int n = recvfrom(sock, (char*)buf, len, 0, (SOCKADDR*)from, &fromLen);
+    *recv_time_us = GetTimeUs();
+    return n;
+}
+
 bool Network_Init(void) {
     if (g_wsa_initialized) return true;
     
@@ -59,8 +180,23 @@ SOCKET Network_CreateUdpBroadcast(uint16_t port, bool bind_port) {
     return sock;
 }
 
-SOCKET Network_CreateUdpAudio(uint16_t port, uint16_t* out_port) {
-    SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+/**
+ * @brief 创建并绑定 UDP 音频 socket
+ * @param registered_io 支持时以 WSA_FLAG_REGISTERED_IO 创建 (供 RIO 批量发送), 普通调用不受影响
+ */
+static SOCKET create_udp_audio(uint16_t port, uint16_t* out_port, bool registered_io) {
+    SOCKET sock = INVALID_SOCKET;
+#ifdef NETWORK_RIO
+    if (registered_io) {
+        sock = WSASocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0,
+                         WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO);
+    }
+#else
+    (void)registered_io;
+#endif
+    if (sock == INVALID_SOCKET) {
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    }
     if (sock == INVALID_SOCKET) {
         LOG_ERROR("Failed to create UDP audio socket: %d", WSAGetLastError());
         return INVALID_SOCKET;
@@ -78,6 +214,9 @@ SOCKET Network_CreateUdpAudio(uint16_t port, uint16_t* out_port) {
     int sndbuf = 128 * 1024;  // 128KB
     setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char*)&sndbuf, sizeof(sndbuf));
     
+    // 收包时间戳 (抖动估计用)
+    enable_rx_timestamps(sock);
+    
     SOCKADDR_IN addr = {0};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
@@ -100,6 +239,14 @@ SOCKET Network_CreateUdpAudio(uint16_t port, uint16_t* out_port) {
     return sock;
 }
 
+SOCKET Network_CreateUdpAudio(uint16_t port, uint16_t* out_port) {
+    return create_udp_audio(port, out_port, false);
+}
+
+SOCKET Network_CreateUdpFanout(uint16_t port, uint16_t* out_port) {
+    return create_udp_audio(port, out_port, true);
+}
+
 SOCKET Network_CreateTcpListener(uint16_t port) {
     SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (sock == INVALID_SOCKET) {
@@ -134,6 +281,44 @@ SOCKET Network_CreateTcpListener(uint16_t port) {
     return sock;
 }
 
+SOCKET Network_CreateWakeup(void) {
+    SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == INVALID_SOCKET) {
+        LOG_ERROR("Failed to create wakeup socket: %d", WSAGetLastError());
+        return INVALID_SOCKET;
+    }
+    
+    SOCKADDR_IN addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    
+    if (bind(sock, (SOCKADDR*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        !Network_SetNonBlocking(sock, true)) {
+        LOG_ERROR("Failed to bind wakeup socket: %d", WSAGetLastError());
+        closesocket(sock);
+        return INVALID_SOCKET;
+    }
+    return sock;
+}
+
+void Network_Wakeup(SOCKET wakeup) {
+    if (wakeup == INVALID_SOCKET) return;
+    
+    SOCKADDR_IN addr;
+    int addrlen = sizeof(addr);
+    if (getsockname(wakeup, (SOCKADDR*)&addr, &addrlen) == 0) {
+        char byte = 0;
+        sendto(wakeup, &byte, 1, 0, (SOCKADDR*)&addr, sizeof(addr));
+    }
+}
+
+void Network_DrainWakeup(SOCKET wakeup) {
+    char buf[16];
+    while (recv(wakeup, buf, sizeof(buf), 0) > 0) {
+    }
+}
+
 SOCKET Network_TcpConnect(const char* ip, uint16_t port) {
     SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (sock == INVALID_SOCKET) {
@@ -290,11 +475,12 @@ void Network_MakeAddr(SOCKADDR_IN* addr, const char* ip, uint16_t port) {
 // RTP 音频包收发
 //=============================================================================
 
-int Network_SendRtpPacket(SOCKET sock, const RtpHeader* rtp, const uint8_t* payload,
-                           uint16_t payload_len, const SOCKADDR_IN* addr) {
-    // 构造完整 RTP 包
-    uint8_t packet[sizeof(RtpHeader) + OPUS_MAX_PACKET];
-    
+/**
+ * @brief 构造完整 RTP 包 (头部 + 负载)
+ * @return 数据报长度
+ */
+static int build_rtp_packet(uint8_t* packet, const RtpHeader* rtp, const uint8_t* payload,
+                            uint16_t payload_len) {
     // 复制头部
     memcpy(packet, rtp, sizeof(RtpHeader));
     
@@ -303,17 +489,26 @@ int Network_SendRtpPacket(SOCKET sock, const RtpHeader* rtp, const uint8_t* payl
         memcpy(packet + sizeof(RtpHeader), payload, payload_len);
     }
     
-    int total = sizeof(RtpHeader) + payload_len;
+    return sizeof(RtpHeader) + payload_len;
+}
+
+int Network_SendRtpPacket(SOCKET sock, const RtpHeader* rtp, const uint8_t* payload,
+                           uint16_t payload_len, const SOCKADDR_IN* addr) {
+    uint8_t packet[sizeof(RtpHeader) + OPUS_MAX_PACKET];
+    int total = build_rtp_packet(packet, rtp, payload, payload_len);
     
     return sendto(sock, (const char*)packet, total, 0, (const SOCKADDR*)addr, sizeof(*addr));
 }
 
 int Network_RecvRtpPacket(SOCKET sock, RtpHeader* rtp, uint8_t* payload,
-                           uint16_t max_len, SOCKADDR_IN* from) {
+                           uint16_t max_len, SOCKADDR_IN* from, uint64_t* recv_time_us) {
     uint8_t packet[sizeof(RtpHeader) + OPUS_MAX_PACKET];
-    int fromLen = sizeof(SOCKADDR_IN);
+    uint64_t recv_us;
     
-    int n = recvfrom(sock, (char*)packet, sizeof(packet), 0, (SOCKADDR*)from, &fromLen);
+    int n = recv_timestamped(sock, packet, sizeof(packet), from, &recv_us);
+    if (recv_time_us) {
+        *recv_time_us = recv_us;
+    }
     if (n < (int)sizeof(RtpHeader)) {
         return -1;  // 包太小
     }
@@ -334,3 +529,223 @@ int Network_RecvRtpPacket(SOCKET sock, RtpHeader* rtp, uint8_t* payload,
     
     return payload_len;
 }
+
+//=============================================================================
+// 一对多批量发送
+//=============================================================================
+
+#ifdef NETWORK_RIO
+/**
+ * @brief 初始化 RIO 请求队列 (失败时保持 rq = RIO_INVALID_RQ, 使用逐个 sendto)
+ */
+static void rio_open(UdpBatch* batch) {
+    batch->rq = RIO_INVALID_RQ;
+    batch->cq = RIO_INVALID_CQ;
+    batch->buffer_id = RIO_INVALID_BUFFERID;
+    
+    if (!g_rio_loaded) {
+        GUID guid = WSAID_MULTIPLE_RIO;
+        DWORD bytes = 0;
+        if (WSAIoctl(batch->sock, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid),
+                     &g_rio, sizeof(g_rio), &bytes, NULL, NULL) == SOCKET_ERROR) {
+            LOG_DEBUG("RIO not supported: %d", WSAGetLastError());
+            return;
+        }
+        g_rio_loaded = true;
+    }
+    
+    DWORD size = sizeof(BatchSlot) * NETWORK_BATCH_DEPTH;
+    batch->slots = (BatchSlot*)VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!batch->slots) return;
+    
+    batch->buffer_id = g_rio.RIORegisterBuffer((PCHAR)batch->slots, size);
+    if (batch->buffer_id == RIO_INVALID_BUFFERID) {
+        LOG_DEBUG("RIORegisterBuffer failed: %d", WSAGetLastError());
+        return;
+    }
+    
+    // 只发送, 但接收队列参数须为非零
+    const ULONG max_sends = NETWORK_BATCH_MAX * NETWORK_BATCH_DEPTH;
+    batch->cq = g_rio.RIOCreateCompletionQueue(max_sends + 1, NULL);
+    if (batch->cq == RIO_INVALID_CQ) {
+        LOG_DEBUG("RIOCreateCompletionQueue failed: %d", WSAGetLastError());
+        return;
+    }
+    
+    // socket 未以 WSA_FLAG_REGISTERED_IO 创建时在此失败
+    batch->rq = g_rio.RIOCreateRequestQueue(batch->sock, 1, 1, max_sends, 1,
+                                            batch->cq, batch->cq, NULL);
+    if (batch->rq == RIO_INVALID_RQ) {
+        LOG_DEBUG("RIOCreateRequestQueue failed: %d", WSAGetLastError());
+    }
+}
+
+static void rio_close(UdpBatch* batch) {
+    if (batch->cq != RIO_INVALID_CQ) {
+        g_rio.RIOCloseCompletionQueue(batch->cq);
+    }
+    if (batch->buffer_id != RIO_INVALID_BUFFERID) {
+        g_rio.RIODeregisterBuffer(batch->buffer_id);
+    }
+    if (batch->slots) {
+        VirtualFree(batch->slots, 0, MEM_RELEASE);
+    }
+}
+
+/**
+ * @brief 回收已完成的发送 (非阻塞, 用户态轮询完成队列)
+ */
+static void rio_reap(UdpBatch* batch) {
+    RIORESULT results[64];
+    ULONG n;
+    while ((n = g_rio.RIODequeueCompletion(batch->cq, results, (ULONG)ARRAY_SIZE(results))) > 0 &&
+           n != RIO_CORRUPT_CQ) {
+        for (ULONG i = 0; i < n; i++) {
+            batch->outstanding[results[i].RequestContext]--;
+        }
+    }
+}
+
+/**
+ * @brief 通过 RIO 提交一批 (所有目标 RIO_MSG_DEFER 排队, 最后一次提交)
+ * @return 提交的目标数, <0 表示槽仍在途, 需要退回逐个发送
+ */
+static int rio_send(UdpBatch* batch, const RtpHeader* rtp, const uint8_t* payload,
+                    uint16_t payload_len, const SOCKADDR_IN* addrs, int count) {
+    rio_reap(batch);
+    
+    int index = batch->next;
+    if (batch->outstanding[index] > 0) {
+        return -1;  // 发送速度超过协议栈处理速度, 不等待
+    }
+    batch->next = (index + 1) % NETWORK_BATCH_DEPTH;
+    
+    BatchSlot* slot = &batch->slots[index];
+    ULONG base = (ULONG)(index * sizeof(BatchSlot));
+    
+    RIO_BUF data;
+    data.BufferId = batch->buffer_id;
+    data.Offset = base + (ULONG)offsetof(BatchSlot, packet);
+    data.Length = (ULONG)build_rtp_packet(slot->packet, rtp, payload, payload_len);
+    
+    int queued = 0;
+    for (int i = 0; i < count; i++) {
+        memset(&slot->addrs[i], 0, sizeof(SOCKADDR_INET));
+        slot->addrs[i].Ipv4 = addrs[i];
+        
+        RIO_BUF remote;
+        remote.BufferId = batch->buffer_id;
+        remote.Offset = base + (ULONG)(offsetof(BatchSlot, addrs) + i * sizeof(SOCKADDR_INET));
+        remote.Length = sizeof(SOCKADDR_INET);
+        
+        if (!g_rio.RIOSendEx(batch->rq, &data, 1, NULL, &remote, NULL, NULL,
+                             RIO_MSG_DEFER, (PVOID)(intptr_t)index)) {
+            LOG_DEBUG("RIOSendEx failed: %d", WSAGetLastError());
+            break;
+        }
+        queued++;
+    }
+    
+    batch->outstanding[index] = queued;
+    if (queued > 0) {
+        g_rio.RIOSendEx(batch->rq, NULL, 0, NULL, NULL, NULL, NULL, RIO_MSG_COMMIT_ONLY, NULL);
+        batch->stats.syscalls++;
+    }
+    return queued;
+}
+#endif
+
+UdpBatch* Network_CreateUdpBatch(SOCKET sock) {
+    UdpBatch* batch = (UdpBatch*)calloc(1, sizeof(UdpBatch));
+    if (!batch) return NULL;
+    
+    batch->sock = sock;
+    MutexInit(&batch->mutex);
+    
+#ifdef NETWORK_RIO
+    rio_open(batch);
+    batch->stats.rio = batch->rq != RIO_INVALID_RQ;
+#endif
+    
+    LOG_INFO("UDP fan-out: %s", batch->stats.rio ? "RIO batched sends" : "sendto per recipient");
+    return batch;
+}
+
+void Network_DestroyUdpBatch(UdpBatch* batch) {
+    if (!batch) return;
+    
+#ifdef NETWORK_RIO
+    rio_close(batch);
+#endif
+    MutexDestroy(&batch->mutex);
+    free(batch);
+}
+
+int Network_SendRtpBatch(UdpBatch* batch, const RtpHeader* rtp, const uint8_t* payload,
+                         uint16_t payload_len, const SOCKADDR_IN* addrs, int count) {
+    if (!batch || !rtp || !addrs || count <= 0) return 0;
+    
+    uint8_t packet[sizeof(RtpHeader) + OPUS_MAX_PACKET];
+    int packet_len = 0;
+    int sent = 0;
+    
+    MutexLock(&batch->mutex);
+    for (int base = 0; base < count; base += NETWORK_BATCH_MAX) {
+        int n = MIN(count - base, NETWORK_BATCH_MAX);
+        
+#ifdef NETWORK_RIO
+        if (batch->stats.rio) {
+            int queued = rio_send(batch, rtp, payload, payload_len, addrs + base, n);
+            if (queued >= 0) {
+                batch->stats.datagrams += queued;
+                sent += queued;
+                continue;
+            }
+            batch->stats.fallbacks++;
+        }
+#endif
+        
+        // 逐个 sendto, 数据报只构造一次
+        if (packet_len == 0) {
+            packet_len = build_rtp_packet(packet, rtp, payload, payload_len);
+        }
+        for (int i = 0; i < n; i++) {
+            const SOCKADDR_IN* addr = &addrs[base + i];
+            if (sendto(batch->sock, (const char*)packet, packet_len, 0,
+                       (const SOCKADDR*)addr, sizeof(*addr)) > 0) {
+                sent++;
+                batch->stats.datagrams++;
+            }
+            batch->stats.syscalls++;
+        }
+    }
+    MutexUnlock(&batch->mutex);
+    
+    return sent;
+}
+
+int Network_SendRtpMulti(SOCKET sock, const RtpHeader* rtp, const uint8_t* payload,
+                         uint16_t payload_len, const SOCKADDR_IN* addrs, int count) {
+    if (!rtp || !addrs || count <= 0) return 0;
+    
+    uint8_t packet[sizeof(RtpHeader) + OPUS_MAX_PACKET];
+    int packet_len = build_rtp_packet(packet, rtp, payload, payload_len);
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        if (sendto(sock, (const char*)packet, packet_len, 0,
+                   (const SOCKADDR*)&addrs[i], sizeof(addrs[i])) > 0) {
+            sent++;
+        }
+    }
+    return sent;
+}
+
+void Network_GetUdpBatchStats(UdpBatch* batch, UdpBatchStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!batch) return;
+    
+    MutexLock(&batch->mutex);
+    *stats = batch->stats;
+    MutexUnlock(&batch->mutex);
+}
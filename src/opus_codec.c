@@ -36,7 +36,7 @@ void OpusCodec_GetDefaultEncoderConfig(OpusEncoderConfig* config) {
     config->frame_ms = AUDIO_FRAME_MS;
     config->vbr = true;
     config->fec = true;      // 启用前向纠错
-    config->dtx = false;     // 关闭 DTX (工业场景不需要)
+    config->dtx = true;      // 启用 DTX (静音期间只发送舒适噪声更新帧, 接收端生成舒适噪声)
 }
 
 void OpusCodec_GetDefaultDecoderConfig(OpusDecoderConfig* config) {
@@ -190,6 +190,12 @@ int OpusCodec_Plc(OpusCodec* codec, int16_t* pcm, int frame_size) {
     return decoded;
 }
 
+void OpusCodec_ResetDecoder(OpusCodec* codec) {
+    if (!codec || !codec->has_decoder) return;
+    
+    p_opus_decoder_ctl(codec->decoder, OPUS_RESET_STATE);
+}
+
 int OpusCodec_SetBitrate(OpusCodec* codec, int bitrate) {
     if (!codec || !codec->has_encoder) return -1;
     
@@ -209,6 +215,16 @@ int OpusCodec_GetBitrate(OpusCodec* codec) {
     return bitrate;
 }
 
+bool OpusCodec_IsInDtx(OpusCodec* codec) {
+    if (!codec || !codec->has_encoder) return false;
+    
+    opus_int32 in_dtx = 0;
+    if (p_opus_encoder_ctl(codec->encoder, OPUS_GET_IN_DTX(&in_dtx)) != OPUS_OK) {
+        return false;  // 旧版本 opus.dll
+    }
+    return in_dtx != 0;
+}
+
 int OpusCodec_SetComplexity(OpusCodec* codec, int complexity) {
     if (!codec || !codec->has_encoder) return -1;
     
@@ -236,6 +252,43 @@ int OpusCodec_JitterDecode(void* decoder, const uint8_t* data, int len,
     return p_opus_decode(dec, data, len, pcm, frame_size, decode_fec);
 }
 
+int OpusCodec_GetPacketSamples(const uint8_t* data, int len) {
+    if (!data || len < 1) return -1;
+    
+    // TOC: config (5 bit) | s (1 bit) | c (2 bit), 见 RFC 6716 3.1
+    int config = data[0] >> 3;
+    int frame_samples;
+    
+    if (config < 12) {
+        // SILK: 10/20/40/60 ms
+        static const int silk_ms[4] = { 10, 20, 40, 60 };
+        frame_samples = AUDIO_SAMPLE_RATE / 1000 * silk_ms[config & 3];
+    } else if (config < 16) {
+        // Hybrid: 10/20 ms
+        frame_samples = AUDIO_SAMPLE_RATE / 100 << (config & 1);
+    } else {
+        // CELT: 2.5/5/10/20 ms
+        frame_samples = AUDIO_SAMPLE_RATE / 400 << (config & 3);
+    }
+    
+    int frames;
+    switch (data[0] & 3) {
+        case 0:  frames = 1; break;
+        case 1:
+        case 2:  frames = 2; break;
+        default:
+            if (len < 2) return -1;
+            frames = data[1] & 0x3F;
+            break;
+    }
+    
+    int samples = frames * frame_samples;
+    if (frames == 0 || samples > AUDIO_SAMPLE_RATE * 120 / 1000) {
+        return -1;  // 单包最长 120ms
+    }
+    return samples;
+}
+
 int OpusCodec_JitterPlc(void* decoder, int16_t* pcm, int frame_size) {
     if (!decoder || !pcm) return -1;
     
@@ -15,6 +15,7 @@ opus_encoder_ctl_fn          p_opus_encoder_ctl = NULL;
 opus_decoder_create_fn       p_opus_decoder_create = NULL;
 opus_decoder_destroy_fn      p_opus_decoder_destroy = NULL;
 opus_decode_fn               p_opus_decode = NULL;
+opus_decoder_ctl_fn          p_opus_decoder_ctl = NULL;
 opus_strerror_fn             p_opus_strerror = NULL;
 opus_get_version_string_fn   p_opus_get_version_string = NULL;
 
@@ -51,13 +52,15 @@ int opus_dynamic_init(void) {
     p_opus_decoder_create = (opus_decoder_create_fn)GetProcAddress(hModule, "opus_decoder_create");
     p_opus_decoder_destroy = (opus_decoder_destroy_fn)GetProcAddress(hModule, "opus_decoder_destroy");
     p_opus_decode = (opus_decode_fn)GetProcAddress(hModule, "opus_decode");
+    p_opus_decoder_ctl = (opus_decoder_ctl_fn)GetProcAddress(hModule, "opus_decoder_ctl");
     p_opus_strerror = (opus_strerror_fn)GetProcAddress(hModule, "opus_strerror");
     p_opus_get_version_string = (opus_get_version_string_fn)GetProcAddress(hModule, "opus_get_version_string");
     
     // 检查必要的函数是否都加载成功
     if (!p_opus_encoder_create || !p_opus_encoder_destroy || 
         !p_opus_encode || !p_opus_encoder_ctl ||
-        !p_opus_decoder_create || !p_opus_decoder_destroy || !p_opus_decode) {
+        !p_opus_decoder_create || !p_opus_decoder_destroy || !p_opus_decode ||
+        !p_opus_decoder_ctl) {
         fprintf(stderr, "Failed to load required opus functions\n");
         cleanup_opus_dll();
         return 0;
@@ -88,6 +91,7 @@ void opus_dynamic_cleanup(void) {
         p_opus_decoder_create = NULL;
         p_opus_decoder_destroy = NULL;
         p_opus_decode = NULL;
+        p_opus_decoder_ctl = NULL;
         p_opus_strerror = NULL;
         p_opus_get_version_string = NULL;
         
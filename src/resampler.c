@@ -0,0 +1,94 @@
+/**
+ * @file resampler.c
+ * @brief 微调重采样实现
+ *
+ * 把 history + in 看作连续序列 c, 输出位置 p = pos + frac / 2^32 在 c 上以
+ * step = 1 / ratio 前进, 每个输出取 c[pos - 1 .. pos + 2] 做三次插值.
+ * 输入用完后把 c 的最后 RESAMPLER_HISTORY 个采样留作下一块的 history, pos 回退 in_len.
+ *
+ * ratio = 1 且 frac = 0 时输出与输入逐点相同 (仅延迟 2 个采样).
+ */
+
+#include "resampler.h"
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 取连续序列 c 中的采样
+ */
+static inline int32_t sample_at(const Resampler* rs, const int16_t* in, int32_t idx) {
+    return idx < RESAMPLER_HISTORY ? rs->history[idx] : in[idx - RESAMPLER_HISTORY];
+}
+
+/**
+ * @brief Catmull-Rom 三次插值 (y1 与 y2 之间, t 为 Q15)
+ */
+static inline int16_t cubic(int32_t y0, int32_t y1, int32_t y2, int32_t y3, int32_t t) {
+    // 系数均乘 2, 避免 0.5 的小数
+    int64_t a = -y0 + 3 * y1 - 3 * y2 + y3;
+    int64_t b = 2 * y0 - 5 * y1 + 4 * y2 - y3;
+    int64_t c = y2 - y0;
+
+    int64_t v = ((a * t) >> 15) + b;
+    v = ((v * t) >> 15) + c;
+    v = ((v * t) >> 15) + 2 * y1;
+
+    return (int16_t)CLAMP(v / 2, -32768, 32767);
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+void Resampler_Init(Resampler* rs) {
+    if (!rs) return;
+
+    memset(rs->history, 0, sizeof(rs->history));
+    rs->pos = 1;
+    rs->frac = 0;
+}
+
+int Resampler_Process(Resampler* rs, float ratio, const int16_t* in, int in_len,
+                      int16_t* out, int max_out) {
+    if (!rs || !in || !out || in_len <= 0 || max_out <= 0) {
+        return -1;
+    }
+
+    ratio = CLAMP(ratio, RESAMPLER_MIN_RATIO, RESAMPLER_MAX_RATIO);
+
+    // 步长 (Q32): 每个输出采样前进 1 / ratio 个输入采样
+    uint64_t step = (uint64_t)((double)(1ULL << 32) / ratio);
+    uint32_t step_int = (uint32_t)(step >> 32);
+    uint32_t step_frac = (uint32_t)step;
+
+    int32_t end = in_len + RESAMPLER_HISTORY;     // c 的长度
+    int32_t pos = rs->pos;
+    uint32_t frac = rs->frac;
+    int n = 0;
+
+    while (pos + 2 < end) {
+        int16_t v = cubic(sample_at(rs, in, pos - 1), sample_at(rs, in, pos),
+                          sample_at(rs, in, pos + 1), sample_at(rs, in, pos + 2),
+                          (int32_t)(frac >> 17));
+        if (n < max_out) {
+            out[n++] = v;
+        }
+
+        uint32_t prev = frac;
+        frac += step_frac;
+        pos += (int32_t)step_int + (frac < prev ? 1 : 0);
+    }
+
+    // 保留 c 的末尾作为下一块的 history (in_len 很小时部分来自旧 history)
+    int16_t tail[RESAMPLER_HISTORY];
+    for (int i = 0; i < RESAMPLER_HISTORY; i++) {
+        tail[i] = (int16_t)sample_at(rs, in, end - RESAMPLER_HISTORY + i);
+    }
+    memcpy(rs->history, tail, sizeof(tail));
+    rs->pos = pos - in_len;
+    rs->frac = frac;
+
+    return n;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file rooms.c
+ * @brief 服务器房间表实现
+ *
+ * 房间数很少 (最多 ROOM_MAX_ROOMS), 按名称查找直接线性比较;
+ * 成员列表为按需增长的句柄数组, 移除时末项移入空位.
+ */
+
+#include "rooms.h"
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+static bool is_lobby_name(const char* name) {
+    return !name || name[0] == '\0' || strcmp(name, ROOM_LOBBY_NAME) == 0;
+}
+
+static Room* create_room(RoomRegistry* registry, const char* name) {
+    if (registry->count >= ROOM_MAX_ROOMS) return NULL;
+
+    Room* room = (Room*)calloc(1, sizeof(Room));
+    if (!room) return NULL;
+
+    room->id = registry->next_id++;
+    strncpy(room->name, name, MAX_NAME_LEN - 1);
+    registry->rooms[registry->count++] = room;
+
+    LOG_INFO("Room created: %s (id=%u)", room->name, room->id);
+    return room;
+}
+
+static void delete_room(RoomRegistry* registry, int index) {
+    Room* room = registry->rooms[index];
+    LOG_INFO("Room deleted: %s (id=%u)", room->name, room->id);
+
+    registry->rooms[index] = registry->rooms[--registry->count];
+    registry->rooms[registry->count] = NULL;
+    free(room->members);
+    free(room);
+}
+
+static bool add_member(Room* room, SessionHandle member) {
+    if (room->member_count == room->member_capacity) {
+        int capacity = MAX(room->member_capacity * 2, 8);
+        SessionHandle* members = (SessionHandle*)realloc(room->members,
+                                                         capacity * sizeof(SessionHandle));
+        if (!members) return false;
+        room->members = members;
+        room->member_capacity = capacity;
+    }
+    room->members[room->member_count++] = member;
+    return true;
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+bool RoomRegistry_Init(RoomRegistry* registry) {
+    memset(registry, 0, sizeof(*registry));
+    registry->next_id = ROOM_LOBBY_ID;
+    return create_room(registry, ROOM_LOBBY_NAME) != NULL;
+}
+
+void RoomRegistry_Destroy(RoomRegistry* registry) {
+    for (int i = 0; i < registry->count; i++) {
+        free(registry->rooms[i]->members);
+        free(registry->rooms[i]);
+        registry->rooms[i] = NULL;
+    }
+    registry->count = 0;
+}
+
+Room* RoomRegistry_Get(RoomRegistry* registry, uint32_t room_id) {
+    for (int i = 0; i < registry->count; i++) {
+        if (registry->rooms[i]->id == room_id) {
+            return registry->rooms[i];
+        }
+    }
+    return NULL;
+}
+
+Room* RoomRegistry_Find(RoomRegistry* registry, const char* name) {
+    if (is_lobby_name(name)) {
+        return RoomRegistry_Get(registry, ROOM_LOBBY_ID);
+    }
+
+    for (int i = 0; i < registry->count; i++) {
+        if (strncmp(registry->rooms[i]->name, name, MAX_NAME_LEN) == 0) {
+            return registry->rooms[i];
+        }
+    }
+    return NULL;
+}
+
+Room* RoomRegistry_Join(RoomRegistry* registry, const char* name, SessionHandle member) {
+    Room* room = RoomRegistry_Find(registry, name);
+    if (!room) {
+        room = create_room(registry, name);
+    }
+    if (!room) return NULL;
+
+    if (!add_member(room, member)) {
+        if (room->member_count == 0 && room->id != ROOM_LOBBY_ID) {
+            RoomRegistry_Leave(registry, room->id, member);
+        }
+        return NULL;
+    }
+    return room;
+}
+
+void RoomRegistry_Leave(RoomRegistry* registry, uint32_t room_id, SessionHandle member) {
+    for (int i = 0; i < registry->count; i++) {
+        Room* room = registry->rooms[i];
+        if (room->id != room_id) continue;
+
+        for (int j = 0; j < room->member_count; j++) {
+            if (room->members[j] == member) {
+                room->members[j] = room->members[--room->member_count];
+                break;
+            }
+        }
+
+        if (room->member_count == 0 && room->id != ROOM_LOBBY_ID) {
+            delete_room(registry, i);
+        }
+        return;
+    }
+}
+
+int RoomRegistry_List(const RoomRegistry* registry, RoomInfo* rooms, int max_count) {
+    int count = MIN(registry->count, max_count);
+    for (int i = 0; i < count; i++) {
+        const Room* room = registry->rooms[i];
+        memset(&rooms[i], 0, sizeof(RoomInfo));
+        rooms[i].room_id = room->id;
+        rooms[i].members = (uint16_t)MIN(room->member_count, 0xFFFF);
+        strncpy(rooms[i].name, room->name, MAX_NAME_LEN - 1);
+    }
+    return count;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file route_table.c
+ * @brief 音频转发路由表实现
+ *
+ * 宽限期: 写者替换指针后翻转纪元两次, 每次等待翻转前纪元奇偶的读者计数归零.
+ * 只翻转一次不够: 读者可能在上一个写者翻转前读到纪元, 之后才计数并取到指针,
+ * 它被计在另一奇偶下; 两次翻转覆盖两种奇偶, 任何可能持有旧表的读者都已退出.
+ * 翻转后新进入的读者只会取到新表, 因此等待总会结束.
+ *
+ * 哈希索引为线性探测, 桶数至少为容量的两倍 (装载因子 <= 0.5), 由写者在发布前建立;
+ * 排序在建立索引之前, 索引中记录的是排序后的下标.
+ */
+
+#include "route_table.h"
+
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+static void yield_cpu(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static int* ssrc_index(const RouteTable* table) {
+    return (int*)&table->entries[table->capacity];
+}
+
+static int* addr_index(const RouteTable* table) {
+    return ssrc_index(table) + table->buckets;
+}
+
+static uint32_t hash_ssrc(uint32_t ssrc) {
+    return ssrc * 2654435761u;
+}
+
+static uint32_t hash_addr(const SOCKADDR_IN* addr) {
+    uint32_t h = (uint32_t)addr->sin_addr.s_addr * 2654435761u;
+    return (h ^ (h >> 15) ^ addr->sin_port) * 2246822519u;
+}
+
+static bool addr_equal(const SOCKADDR_IN* a, const SOCKADDR_IN* b) {
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+static void index_insert(int* index, int buckets, uint32_t hash, int entry) {
+    uint32_t mask = (uint32_t)buckets - 1;
+    uint32_t pos = hash & mask;
+    while (index[pos] >= 0) {
+        pos = (pos + 1) & mask;
+    }
+    index[pos] = entry;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const RouteEntry* x = (const RouteEntry*)a;
+    const RouteEntry* y = (const RouteEntry*)b;
+    if (x->room != y->room) return x->room < y->room ? -1 : 1;
+    if (x->ssrc != y->ssrc) return x->ssrc < y->ssrc ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief 第一个房间号不小于 room 的路由项下标 (entries 已排序)
+ */
+static int lower_bound_room(const RouteTable* table, uint32_t room) {
+    int lo = 0, hi = table->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (table->entries[mid].room < room) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief 建立 SSRC 与源地址索引 (SSRC 重复时保留第一个)
+ */
+static void build_index(RouteTable* table) {
+    int* by_ssrc = ssrc_index(table);
+    int* by_addr = addr_index(table);
+    for (int i = 0; i < table->buckets; i++) {
+        by_ssrc[i] = -1;
+        by_addr[i] = -1;
+    }
+
+    for (int i = 0; i < table->count; i++) {
+        const RouteEntry* e = &table->entries[i];
+        if (RouteTable_Find(table, e->ssrc)) continue;
+        index_insert(by_ssrc, table->buckets, hash_ssrc(e->ssrc), i);
+        if (e->receiving && !RouteTable_FindByAddr(table, &e->addr)) {
+            index_insert(by_addr, table->buckets, hash_addr(&e->addr), i);
+        }
+    }
+}
+
+/**
+ * @brief 等待所有可能持有旧快照的读者退出
+ */
+static void wait_grace_period(Routing* routing) {
+    for (int phase = 0; phase < 2; phase++) {
+        int old = (AtomicInc(&routing->epoch) - 1) & 1;
+        while (AtomicRead(&routing->readers[old]) != 0) {
+            yield_cpu();
+        }
+    }
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+void Routing_Init(Routing* routing) {
+    memset(routing, 0, sizeof(*routing));
+    MutexInit(&routing->write_mutex);
+    routing->current = RouteTable_Create(0);
+}
+
+void Routing_Destroy(Routing* routing) {
+    free(routing->current);
+    routing->current = NULL;
+    MutexDestroy(&routing->write_mutex);
+}
+
+RouteTable* RouteTable_Create(int capacity) {
+    capacity = MAX(capacity, 0);
+    int buckets = 2;
+    while (buckets < capacity * 2) {
+        buckets <<= 1;
+    }
+
+    size_t size = sizeof(RouteTable) + capacity * sizeof(RouteEntry) + 2 * buckets * sizeof(int);
+    RouteTable* table = (RouteTable*)calloc(1, size);
+    if (table) {
+        table->capacity = capacity;
+        table->buckets = buckets;
+        memset(ssrc_index(table), 0xFF, 2 * buckets * sizeof(int));
+    }
+    return table;
+}
+
+void Routing_Publish(Routing* routing, RouteTable* table) {
+    if (!table) return;
+
+    qsort(table->entries, table->count, sizeof(RouteEntry), compare_entries);
+    build_index(table);
+
+    MutexLock(&routing->write_mutex);
+    table->version = ++routing->version;
+    RouteTable* old = (RouteTable*)AtomicSetPtr(&routing->current, table);
+    wait_grace_period(routing);
+    MutexUnlock(&routing->write_mutex);
+
+    free(old);
+}
+
+const RouteTable* Routing_Acquire(Routing* routing, int* token) {
+    int parity = AtomicRead(&routing->epoch) & 1;
+    AtomicInc(&routing->readers[parity]);
+    *token = parity;
+    return (const RouteTable*)AtomicReadPtr(&routing->current);
+}
+
+void Routing_Release(Routing* routing, int token) {
+    AtomicDec(&routing->readers[token]);
+}
+
+const RouteEntry* RouteTable_Find(const RouteTable* table, uint32_t ssrc) {
+    if (!table) return NULL;
+
+    const int* index = ssrc_index(table);
+    uint32_t mask = (uint32_t)table->buckets - 1;
+    for (uint32_t pos = hash_ssrc(ssrc) & mask; index[pos] >= 0; pos = (pos + 1) & mask) {
+        const RouteEntry* e = &table->entries[index[pos]];
+        if (e->ssrc == ssrc) return e;
+    }
+    return NULL;
+}
+
+const RouteEntry* RouteTable_FindByAddr(const RouteTable* table, const SOCKADDR_IN* addr) {
+    if (!table || !addr) return NULL;
+
+    const int* index = addr_index(table);
+    uint32_t mask = (uint32_t)table->buckets - 1;
+    for (uint32_t pos = hash_addr(addr) & mask; index[pos] >= 0; pos = (pos + 1) & mask) {
+        const RouteEntry* e = &table->entries[index[pos]];
+        if (addr_equal(&e->addr, addr)) return e;
+    }
+    return NULL;
+}
+
+int RouteTable_RoomRange(const RouteTable* table, uint32_t room, int* first) {
+    *first = 0;
+    if (!table) return 0;
+
+    int begin = lower_bound_room(table, room);
+    int end = room == UINT32_MAX ? table->count : lower_bound_room(table, room + 1);
+    *first = begin;
+    return end - begin;
+}
@@ -3,20 +3,45 @@
  * @brief 服务器模块实现 (TCP控制 + UDP音频)
  * 
  * 架构:
+ * - 会话表 sessions 与房间表 rooms 由 clients_mutex 保护, 只有控制面 (TCP 线程) 修改;
+ *   音频面读取控制面在变化时发布的路由快照 (route_table.h), 从不等待控制面
+ * - 房间: 连接后位于大厅, 转发、用户列表与加入/离开通知都只在房间内进行;
+ *   服务器本地语音属于大厅
  * - UDP 发现线程: 响应局域网发现请求
- * - TCP 控制线程: 会话管理、心跳、音频控制
- * - UDP 音频线程: 接收/转发 RTP 音频包
+ * - TCP 控制线程: 事件驱动, WSAPoll 等待监听 socket、唤醒 socket 与所有连接, 接受连接、
+ *   会话管理、心跳、音频控制; 轮询集合只在连接建立/断开时增删, 不受 FD_SETSIZE 限制.
+ *   没有事件时一直等到最早的心跳超时时刻 (无连接时无限等待), 停止时由唤醒 socket 叫醒;
+ *   每个连接一个环形缓冲分帧 (tcp_framer.h), 报文原地处理;
+ *   连接为非阻塞 socket, 发不完的数据进入该连接的发送队列, 可写 (POLLWRNORM) 时再发,
+ *   积压超过 TCP_SEND_QUEUE_LIMIT 的连接被断开, 持有 clients_mutex 时从不阻塞在 send 上;
+ *   会话按最近活动时间串成链表, 超时检查只看表头, 不遍历所有会话
+ * - 会话表按需分页增长 (session_table.h), 上限 SERVER_MAX_SESSIONS
+ * - UDP 音频工作线程 (1 ~ SERVER_MAX_AUDIO_WORKERS 个): 各自绑定一个音频端口 (连续端口),
+ *   接收/转发 RTP 音频包, 转发后再把需要解码的包交给解码工作池;
+ *   HELLO_ACK 按 SSRC 给每个客户端指定一个端口, 同一发送者的包总由同一线程按序处理;
+ *   发给客户端的音频 (转发、本地语音、MCU 混音) 也总从该端口发出, 只放行所联系端口回包的
+ *   防火墙 / NAT 不会丢弃;
+ *   每个房间只转发电平最高的 K 路 (speaker_selector.h), 其余发送者的包不转发
+ * - 解码工作池 (可选): 仅注册 onAudioReceived 时创建, 按 SSRC 分线程解码并回调
+ * - MCU 线程 (可选): 解码各发送者, 每 20ms 为每个收听者编码一路 mix-minus,
+ *   此时 UDP 音频线程只把包交给 MCU, 不再转发
  */
 
 #include "server.h"
 #include "network.h"
 #include "opus_codec.h"
 #include "jitter_buffer.h"
+#include "route_table.h"
+#include "session_table.h"
+#include "rooms.h"
+#include "speaker_selector.h"
+#include "tcp_framer.h"
 
 //=============================================================================
 // 客户端会话 (TCP 控制)
 //=============================================================================
 typedef struct {
+    SessionHandle handle;           // 会话句柄 (路由快照中引用)
     uint32_t    client_id;
     uint32_t    ssrc;               // RTP SSRC
     char        name[MAX_NAME_LEN];
@@ -24,17 +49,68 @@ typedef struct {
     SOCKADDR_IN tcp_addr;           // TCP 地址
     SOCKADDR_IN udp_addr;           // UDP 音频地址
     uint16_t    udp_port;           // 客户端 UDP 端口
-    uint64_t    last_heartbeat;
-    bool        active;
-    bool        audio_active;       // 音频会话是否激活
-    bool        is_talking;
+    uint64_t    last_heartbeat;     // 最近一次收到数据的时间
+    SessionHandle idle_prev;        // 活动链表 (按 last_heartbeat 从旧到新)
+    SessionHandle idle_next;
+    int         poll_index;         // 在轮询集合中的下标
+    uint32_t    room_id;            // 所在房间
+    bool        audio_active;       // 音频会话是否激活 (讲话状态由音频工作线程维护, 见 IsTalking)
     bool        is_muted;
+    bool        closing;            // 发送失败或积压过多, 等控制线程断开
     
-    // TCP 接收缓冲
-    uint8_t     recv_buf[MAX_PACKET_SIZE];
-    int         recv_len;
+    // TCP 接收环形缓冲 (连接建立时分配) 与发送队列 (第一次积压时分配)
+    TcpFramer   framer;
+    TcpSendQueue send_queue;
 } ClientSession;
 
+/**
+ * @brief TCP 控制线程的轮询集合 (WSAPoll)
+ *
+ * 0 号为监听 socket, 1 号为唤醒 socket, 之后每个连接一项.
+ */
+#define POLL_LISTENER       0
+#define POLL_WAKEUP         1
+#define POLL_FIRST_CLIENT   2
+
+typedef struct {
+    WSAPOLLFD*      fds;
+    SessionHandle*  owners;             // fds[i] 所属会话 (0 号为监听 socket)
+    int             count;
+    int             capacity;
+} PollSet;
+
+/**
+ * @brief 发送者的平滑电平与讲话状态 (工作线程私有, 按 SSRC 开放寻址)
+ */
+typedef struct {
+    uint32_t        ssrc;
+    uint8_t         level;              // 平滑电平 (用于发言者选择)
+    bool            talking;            // 最近一包 VAD 有效且未静音
+    uint64_t        last_ms;            // 最近一包的时间 (0 为空槽)
+} SpeechState;
+
+#define SPEECH_TABLE_SIZE   (SERVER_MAX_SESSIONS * 2)   // 2 的幂
+#define SPEECH_TABLE_PROBE  8           // 探测范围 (满时复用其中最久没有包的槽)
+#define SPEECH_HOLD_MS      300         // 超过此时间没有包的发送者不再算在讲话
+#define WORKER_PUBLISH_MS   100         // 工作线程发布统计与讲话列表的间隔
+
+/**
+ * @brief UDP 音频工作线程 (每个绑定一个音频端口)
+ */
+typedef struct {
+    int             index;
+    SOCKET          sock;
+    uint16_t        port;
+    UdpBatch*       fanout;             // 一对多批量转发 (只由本线程使用)
+    Thread          thread;
+    
+    // 线程私有计数与讲话状态每 WORKER_PUBLISH_MS 发布一次, 收包路径不加锁; 读取时汇总
+    ServerPipelineStats stats;
+    Mutex           stats_mutex;
+    uint32_t        talking[SERVER_MAX_SESSIONS];  // 本线程正在讲话的发送者 (talking_mutex 保护)
+    int             talking_count;
+} AudioWorker;
+
 //=============================================================================
 // 服务器状态
 //=============================================================================
@@ -43,7 +119,7 @@ typedef struct {
     bool            initialized;
     char            name[MAX_NAME_LEN];
     uint16_t        tcp_port;           // TCP 控制端口
-    uint16_t        udp_audio_port;     // UDP 音频端口
+    uint16_t        udp_audio_port;     // UDP 音频端口 (0 号工作线程, 发现响应中公布)
     uint16_t        discovery_port;     // UDP 发现端口
     uint32_t        server_id;
     uint32_t        ssrc;               // 服务器 SSRC
@@ -51,29 +127,53 @@ typedef struct {
     // 网络
     SOCKET          udp_discovery;      // UDP 发现
     SOCKET          tcp_control;        // TCP 控制监听
-    SOCKET          udp_audio;          // UDP 音频
+    SOCKET          tcp_wakeup;         // 唤醒 TCP 控制线程 (相当于 eventfd)
+    AudioWorker     workers[SERVER_MAX_AUDIO_WORKERS];     // UDP 音频 (0 号兼用于 MCU 与本地语音发送)
+    int             worker_count;
+    int             audio_workers;      // 下次启动时的工作线程数
     
     // 线程
     Thread          discovery_thread;
-    Thread          tcp_accept_thread;
-    Thread          tcp_recv_thread;
-    Thread          udp_audio_thread;
+    Thread          tcp_control_thread;
     Event           stop_event;
     
-    // 客户端管理
-    ClientSession   clients[MAX_CLIENTS];
-    int             client_count;
+    // 客户端管理 (sessions, poll_set, rooms, 活动链表由 clients_mutex 保护)
+    SessionTable    sessions;
+    int             max_sessions;       // SERVER_MAX_SESSIONS, MCU 模式为 MCU_MAX_LISTENERS
+    PollSet         poll_set;
+    SessionHandle   idle_head;          // 最久没有数据的会话 (心跳超时只需检查表头)
+    SessionHandle   idle_tail;
+    int             closing_count;      // 等待断开的会话数 (closing 已置位)
+    RoomRegistry    rooms;
     Mutex           clients_mutex;
     
+    // 音频面路由快照 (控制面持有 clients_mutex 时发布)
+    Routing         routing;
+    
+    // 各工作线程讲话列表的合并 (有序, 每次发布时重建); talking_mutex 是叶子锁, 持有时不取其他锁
+    Mutex           talking_mutex;
+    uint32_t        talking[SERVER_MAX_SESSIONS];
+    int             talking_count;
+    
     // RTP 序列号
     uint16_t        rtp_sequence;
     uint32_t        rtp_timestamp;
+    bool            rtp_marker;         // 下一个包置 marker (新讲话段)
+    uint8_t         speech_level;       // 服务器本地语音的平滑电平
     
     // 回调
     ServerCallbacks callbacks;
     
-    // Opus 解码器 (用于接收音频)
-    OpusCodec*      opus_decoder;
+    // 解码工作池 (仅注册 onAudioReceived 时创建, 转发不等待解码)
+    DecodePool*     decode_pool;
+    
+    // 服务器混音 (NULL 为转发模式)
+    bool            mcu_mode;           // 下次启动时使用 MCU
+    Mcu*            mcu;
+    
+    // 活跃发言者选择 (转发模式; NULL 为全部转发)
+    int             max_speakers;       // 每个房间转发的发言者数, 下次启动时生效
+    SpeakerSelector* speakers;
 } ServerState;
 
 static ServerState g_server = {0};
@@ -82,17 +182,43 @@ static ServerState g_server = {0};
 // 内部函数声明
 //=============================================================================
 static DWORD WINAPI DiscoveryThreadProc(LPVOID param);
-static DWORD WINAPI TcpAcceptThreadProc(LPVOID param);
-static DWORD WINAPI TcpRecvThreadProc(LPVOID param);
+static DWORD WINAPI TcpControlThreadProc(LPVOID param);
 static DWORD WINAPI UdpAudioThreadProc(LPVOID param);
 static void HandleTcpPacket(ClientSession* client, const uint8_t* data, int len);
 static void BroadcastTcpMessage(const void* data, int len, uint32_t exclude_id);
-static void BroadcastUdpAudio(const RtpHeader* rtp, const uint8_t* payload, 
-                               uint16_t payload_len, uint32_t exclude_ssrc);
-static void NotifyPeerJoin(const PeerInfo* peer);
-static void NotifyPeerLeave(uint32_t client_id);
-static void RemoveClient(int index);
-static ClientSession* FindClientBySSRC(uint32_t ssrc);
+static void BroadcastUdpAudio(AudioWorker* self, UdpBatchStats* direct, const RtpHeader* rtp,
+                              const uint8_t* payload, uint16_t payload_len,
+                              const SOCKADDR_IN* addrs, const int* counts);
+static AudioWorker* WorkerForSsrc(uint32_t ssrc);
+static SpeechState* SpeechState_Get(SpeechState* table, uint32_t ssrc);
+static void PublishWorkerState(AudioWorker* worker, const ServerPipelineStats* local,
+                               const SpeechState* speech, uint64_t now_ms);
+static int CopyTalking(uint32_t* ssrcs);
+static bool IsTalking(const uint32_t* talking, int count, uint32_t ssrc);
+static bool StartAudioWorkers(uint16_t udp_port);
+static void CloseAudioWorkers(void);
+static void NotifyClientLeft(uint32_t room_id, uint32_t client_id);
+static void SendToClient(ClientSession* client, const void* data, int len);
+static void BroadcastToRoom(uint32_t room_id, const void* data, int len, uint32_t exclude_id);
+static void NotifyPeerJoin(uint32_t room_id, const PeerInfo* peer);
+static void NotifyPeerLeave(uint32_t room_id, uint32_t client_id);
+static void SendPeerList(ClientSession* client);
+static void MoveToRoom(ClientSession* client, const char* room_name);
+static void SendRoomList(ClientSession* client);
+static int PollSet_Add(PollSet* set, SOCKET sock, SessionHandle owner);
+static void PollSet_Remove(PollSet* set, int index);
+static void PollSet_Free(PollSet* set);
+static void IdleList_Append(ClientSession* client);
+static void IdleList_Unlink(ClientSession* client);
+static int ExpireIdleClients(void);
+static void RemoveClient(ClientSession* client);
+static void PublishRoutes(void);
+static int CollectRecipients(const RouteTable* routes, uint32_t room, uint32_t exclude_ssrc,
+                             SOCKADDR_IN* addrs, int* counts);
+static int GetMcuListeners(McuListener* listeners, int max_count, void* ctx);
+static void GetMcuSourceRooms(const uint32_t* ssrcs, int count, uint32_t* rooms, void* ctx);
+static void UpdateForwardStats(ServerPipelineStats* st, uint64_t recv_time_us);
+static void CountRejected(ServerPipelineStats* st, bool spoofed, uint32_t ssrc, const SOCKADDR_IN* from);
 
 //=============================================================================
 // 公共接口
@@ -103,8 +229,22 @@ bool Server_Init(void) {
     
     memset(&g_server, 0, sizeof(g_server));
     MutexInit(&g_server.clients_mutex);
+    MutexInit(&g_server.talking_mutex);
+    for (int i = 0; i < SERVER_MAX_AUDIO_WORKERS; i++) {
+        g_server.workers[i].index = i;
+        g_server.workers[i].sock = INVALID_SOCKET;
+        MutexInit(&g_server.workers[i].stats_mutex);
+    }
+    SessionTable_Init(&g_server.sessions, sizeof(ClientSession), SERVER_MAX_SESSIONS);
+    if (!RoomRegistry_Init(&g_server.rooms)) {
+        LOG_ERROR("Failed to create lobby");
+        return false;
+    }
+    Routing_Init(&g_server.routing);
     g_server.server_id = (uint32_t)time(NULL) ^ GetCurrentProcessId();
     g_server.ssrc = g_server.server_id;  // 服务器 SSRC
+    g_server.max_speakers = SPEAKER_DEFAULT_FORWARD;
+    g_server.audio_workers = SERVER_DEFAULT_AUDIO_WORKERS;
     g_server.initialized = true;
     
     LOG_INFO("Server module initialized");
@@ -117,6 +257,13 @@ void Server_Shutdown(void) {
     Server_Stop();
     
     MutexDestroy(&g_server.clients_mutex);
+    MutexDestroy(&g_server.talking_mutex);
+    for (int i = 0; i < SERVER_MAX_AUDIO_WORKERS; i++) {
+        MutexDestroy(&g_server.workers[i].stats_mutex);
+    }
+    Routing_Destroy(&g_server.routing);
+    SessionTable_Destroy(&g_server.sessions);
+    RoomRegistry_Destroy(&g_server.rooms);
     g_server.initialized = false;
     
     LOG_INFO("Server module shutdown");
@@ -149,19 +296,44 @@ bool Server_Start(const char* name, uint16_t tcp_port, uint16_t udp_port,
         return false;
     }
     
-    // 创建 UDP 音频 socket
-    g_server.udp_audio = Network_CreateUdpAudio(udp_port, &g_server.udp_audio_port);
-    if (g_server.udp_audio == INVALID_SOCKET) {
+    g_server.tcp_wakeup = Network_CreateWakeup();
+    if (g_server.tcp_wakeup == INVALID_SOCKET) {
         Network_CloseSocket(g_server.udp_discovery);
         Network_CloseSocket(g_server.tcp_control);
+        return false;
+    }
+    
+    // 创建 UDP 音频 socket (每个工作线程一个)
+    if (!StartAudioWorkers(udp_port)) {
+        Network_CloseSocket(g_server.udp_discovery);
+        Network_CloseSocket(g_server.tcp_control);
+        Network_CloseSocket(g_server.tcp_wakeup);
         LOG_ERROR("Failed to create UDP audio socket");
         return false;
     }
     
-    // 创建 Opus 解码器
-    OpusDecoderConfig dec_config;
-    OpusCodec_GetDefaultDecoderConfig(&dec_config);
-    g_server.opus_decoder = OpusCodec_Create(NULL, &dec_config);
+    // 解码工作池 (仅在有人消费解码后的音频时创建)
+    if (g_server.callbacks.onAudioReceived) {
+        g_server.decode_pool = DecodePool_Create(SERVER_DECODE_WORKERS,
+                                                 g_server.callbacks.onAudioReceived,
+                                                 g_server.callbacks.userdata);
+    }
+    // 服务器混音
+    if (g_server.mcu_mode) {
+        g_server.mcu = Mcu_Create(g_server.ssrc, GetMcuListeners, GetMcuSourceRooms, NULL);
+        if (!g_server.mcu) {
+            LOG_WARN("MCU unavailable, falling back to forwarding");
+        }
+    }
+    
+    // MCU 每个会话一个编码器与一路混音输入, 会话数受混音器容量限制
+    g_server.max_sessions = g_server.mcu ? MCU_MAX_LISTENERS : SERVER_MAX_SESSIONS;
+    
+    // 转发模式下每个房间只转发最响的几路 (MCU 已把下行限制为一路)
+    if (!g_server.mcu && g_server.max_speakers > 0) {
+        g_server.speakers = SpeakerSelector_Create(g_server.max_speakers);
+    }
+    g_server.speech_level = 0;
     
     // 创建停止事件
     g_server.stop_event = EventCreate();
@@ -169,15 +341,20 @@ bool Server_Start(const char* name, uint16_t tcp_port, uint16_t udp_port,
     g_server.running = true;
     g_server.rtp_sequence = 0;
     g_server.rtp_timestamp = 0;
+    g_server.rtp_marker = true;
     
     // 启动线程
     ThreadCreate(&g_server.discovery_thread, DiscoveryThreadProc, NULL);
-    ThreadCreate(&g_server.tcp_accept_thread, TcpAcceptThreadProc, NULL);
-    ThreadCreate(&g_server.tcp_recv_thread, TcpRecvThreadProc, NULL);
-    ThreadCreate(&g_server.udp_audio_thread, UdpAudioThreadProc, NULL);
+    ThreadCreate(&g_server.tcp_control_thread, TcpControlThreadProc, NULL);
+    for (int i = 0; i < g_server.worker_count; i++) {
+        ThreadCreate(&g_server.workers[i].thread, UdpAudioThreadProc, &g_server.workers[i]);
+    }
+    Mcu_Start(g_server.mcu);
     
-    LOG_INFO("Server started: %s (TCP:%d, UDP Audio:%d, Discovery:%d)", 
-             name, tcp_port, g_server.udp_audio_port, g_server.discovery_port);
+    LOG_INFO("Server started: %s (TCP:%d, UDP Audio:%d-%d, Discovery:%d, %s)", 
+             name, tcp_port, g_server.udp_audio_port,
+             g_server.workers[g_server.worker_count - 1].port, g_server.discovery_port,
+             g_server.mcu ? "MCU" : "forwarding");
     
     if (g_server.callbacks.onStarted) {
         g_server.callbacks.onStarted(g_server.callbacks.userdata);
@@ -191,45 +368,64 @@ void Server_Stop(void) {
     
     g_server.running = false;
     EventSet(g_server.stop_event);
+    Mcu_Stop(g_server.mcu);
     
-    // 关闭 socket 使阻塞的线程退出
+    // 唤醒 TCP 控制线程, 关闭 socket 使阻塞的线程退出
+    Network_Wakeup(g_server.tcp_wakeup);
     Network_CloseSocket(g_server.udp_discovery);
+    for (int i = 0; i < g_server.worker_count; i++) {
+        Network_CloseSocket(g_server.workers[i].sock);
+    }
+    
+    // 等待线程结束
+    ThreadJoin(g_server.discovery_thread);
+    ThreadJoin(g_server.tcp_control_thread);
+    for (int i = 0; i < g_server.worker_count; i++) {
+        ThreadJoin(g_server.workers[i].thread);
+        ThreadClose(g_server.workers[i].thread);
+    }
+    
+    ThreadClose(g_server.discovery_thread);
+    ThreadClose(g_server.tcp_control_thread);
     Network_CloseSocket(g_server.tcp_control);
-    Network_CloseSocket(g_server.udp_audio);
+    Network_CloseSocket(g_server.tcp_wakeup);
     
-    // 关闭所有客户端连接
+    // 关闭所有客户端连接 (控制线程已退出)
     MutexLock(&g_server.clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (g_server.clients[i].active) {
-            Network_CloseSocket(g_server.clients[i].tcp_socket);
-            g_server.clients[i].active = false;
+    for (int i = 0; i < g_server.sessions.limit; i++) {
+        ClientSession* client = (ClientSession*)SessionTable_At(&g_server.sessions, i, NULL);
+        if (client) {
+            Network_CloseSocket(client->tcp_socket);
+            TcpFramer_Free(&client->framer);
+            TcpSendQueue_Free(&client->send_queue);
+            RoomRegistry_Leave(&g_server.rooms, client->room_id, client->handle);
+            SessionTable_Free(&g_server.sessions, client->handle);
         }
     }
-    g_server.client_count = 0;
+    PollSet_Free(&g_server.poll_set);
+    g_server.idle_head = g_server.idle_tail = SESSION_HANDLE_INVALID;
+    g_server.closing_count = 0;
+    PublishRoutes();
     MutexUnlock(&g_server.clients_mutex);
     
-    // 等待线程结束
-    ThreadJoin(g_server.discovery_thread);
-    ThreadJoin(g_server.tcp_accept_thread);
-    ThreadJoin(g_server.tcp_recv_thread);
-    ThreadJoin(g_server.udp_audio_thread);
+    EventDestroy(g_server.stop_event);
     
-    ThreadClose(g_server.discovery_thread);
-    ThreadClose(g_server.tcp_accept_thread);
-    ThreadClose(g_server.tcp_recv_thread);
-    ThreadClose(g_server.udp_audio_thread);
+    // socket 已关闭, 在途的批量发送已取消
+    CloseAudioWorkers();
     
-    EventDestroy(g_server.stop_event);
+    // 停止解码工作池
+    DecodePool_Destroy(g_server.decode_pool);
+    g_server.decode_pool = NULL;
     
-    // 销毁 Opus 解码器
-    if (g_server.opus_decoder) {
-        OpusCodec_Destroy(g_server.opus_decoder);
-        g_server.opus_decoder = NULL;
-    }
+    Mcu_Destroy(g_server.mcu);
+    g_server.mcu = NULL;
+    
+    SpeakerSelector_Destroy(g_server.speakers);
+    g_server.speakers = NULL;
     
     g_server.udp_discovery = INVALID_SOCKET;
     g_server.tcp_control = INVALID_SOCKET;
-    g_server.udp_audio = INVALID_SOCKET;
+    g_server.tcp_wakeup = INVALID_SOCKET;
     
     LOG_INFO("Server stopped");
     
@@ -238,6 +434,61 @@ void Server_Stop(void) {
     }
 }
 
+void Server_SetMcuMode(bool enabled) {
+    g_server.mcu_mode = enabled;
+}
+
+void Server_SetAudioWorkers(int count) {
+    g_server.audio_workers = CLAMP(count, 1, SERVER_MAX_AUDIO_WORKERS);
+}
+
+void Server_SetMaxSpeakers(int count) {
+    g_server.max_speakers = count > 0 ? MIN(count, SPEAKER_MAX_FORWARD) : 0;
+}
+
+bool Server_GetMcuStats(McuStats* stats) {
+    Mcu_GetStats(g_server.mcu, stats);
+    return g_server.mcu != NULL;
+}
+
+bool Server_GetPipelineStats(ServerPipelineStats* stats) {
+    if (!stats) return false;
+    
+    memset(stats, 0, sizeof(*stats));
+    float latency_sum = 0.0f;
+    for (int i = 0; i < g_server.worker_count; i++) {
+        AudioWorker* worker = &g_server.workers[i];
+        MutexLock(&worker->stats_mutex);
+        const ServerPipelineStats* w = &worker->stats;
+        stats->packets_received += w->packets_received;
+        stats->packets_forwarded += w->packets_forwarded;
+        stats->packets_unknown += w->packets_unknown;
+        stats->packets_spoofed += w->packets_spoofed;
+        stats->packets_suppressed += w->packets_suppressed;
+        stats->worker_packets[i] = w->packets_received;
+        latency_sum += w->forward_latency_us * w->packets_forwarded;
+        stats->forward_latency_max_us = MAX(stats->forward_latency_max_us, w->forward_latency_max_us);
+        // 从其他工作线程端口直接发出的部分
+        stats->fanout.datagrams += w->fanout.datagrams;
+        stats->fanout.syscalls += w->fanout.syscalls;
+        MutexUnlock(&worker->stats_mutex);
+        
+        UdpBatchStats fanout;
+        Network_GetUdpBatchStats(worker->fanout, &fanout);
+        stats->fanout.datagrams += fanout.datagrams;
+        stats->fanout.syscalls += fanout.syscalls;
+        stats->fanout.fallbacks += fanout.fallbacks;
+        stats->fanout.rio = fanout.rio;
+    }
+    stats->audio_workers = g_server.worker_count;
+    if (stats->packets_forwarded > 0) {
+        stats->forward_latency_us = latency_sum / stats->packets_forwarded;
+    }
+    
+    DecodePool_GetStats(g_server.decode_pool, &stats->decode);
+    return g_server.running;
+}
+
 bool Server_IsRunning(void) {
     return g_server.running;
 }
@@ -255,25 +506,28 @@ uint16_t Server_GetUdpPort(void) {
 }
 
 int Server_GetClientCount(void) {
-    return g_server.client_count;
+    return g_server.sessions.count;
 }
 
 int Server_GetClients(PeerInfo* peers, int max_count) {
+    uint32_t talking[SERVER_MAX_SESSIONS];
+    int talking_count = CopyTalking(talking);
     int count = 0;
     MutexLock(&g_server.clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS && count < max_count; i++) {
-        if (g_server.clients[i].active) {
-            peers[count].client_id = g_server.clients[i].client_id;
-            peers[count].ssrc = g_server.clients[i].ssrc;
-            strncpy(peers[count].name, g_server.clients[i].name, MAX_NAME_LEN);
+    for (int i = 0; i < g_server.sessions.limit && count < max_count; i++) {
+        ClientSession* client = (ClientSession*)SessionTable_At(&g_server.sessions, i, NULL);
+        if (client) {
+            peers[count].client_id = client->client_id;
+            peers[count].ssrc = client->ssrc;
+            strncpy(peers[count].name, client->name, MAX_NAME_LEN);
             // 填充 IP 地址
-            strncpy(peers[count].ip, inet_ntoa(g_server.clients[i].tcp_addr.sin_addr), 15);
+            strncpy(peers[count].ip, inet_ntoa(client->tcp_addr.sin_addr), 15);
             peers[count].ip[15] = '\0';
             // 填充 UDP 端口
-            peers[count].udp_port = g_server.clients[i].udp_port;
-            peers[count].is_talking = g_server.clients[i].is_talking;
-            peers[count].is_muted = g_server.clients[i].is_muted;
-            peers[count].audio_active = g_server.clients[i].audio_active;
+            peers[count].udp_port = client->udp_port;
+            peers[count].is_talking = IsTalking(talking, talking_count, client->ssrc);
+            peers[count].is_muted = client->is_muted;
+            peers[count].audio_active = client->audio_active;
             count++;
         }
     }
@@ -281,26 +535,53 @@ int Server_GetClients(PeerInfo* peers, int max_count) {
     return count;
 }
 
-void Server_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp) {
+void Server_SendOpusAudio(const uint8_t* opus_data, int opus_len, uint32_t timestamp, bool voice,
+                          uint8_t level) {
     if (!g_server.running || !opus_data || opus_len <= 0) return;
     
+    // DTX 帧不发送 (接收端按时间戳间隙生成舒适噪声), 之后的语音包标记为新讲话段
+    if (opus_len <= OPUS_DTX_MAX_BYTES) {
+        g_server.rtp_marker = true;
+        return;
+    }
+    
     // 构建 RTP 包头
     RtpHeader rtp;
     RtpHeader_Init(&rtp, g_server.ssrc, PAYLOAD_OPUS);
     rtp.sequence = g_server.rtp_sequence++;
     rtp.timestamp = timestamp;
     rtp.payload_len = opus_len;
-    RtpHeader_SetVadActive(&rtp, true);
+    RtpHeader_SetVadActive(&rtp, voice);
+    RtpHeader_SetLevel(&rtp, level);
+    RtpHeader_SetMarker(&rtp, voice && g_server.rtp_marker);
+    g_server.rtp_marker = !voice;
     
-    // 发送给所有客户端
-    MutexLock(&g_server.clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (g_server.clients[i].active && g_server.clients[i].audio_active) {
-            Network_SendRtpPacket(g_server.udp_audio, &rtp, opus_data, opus_len,
-                                   &g_server.clients[i].udp_addr);
+    // MCU 模式: 服务器本地语音作为一路发送者混入每个收听者的输出
+    if (g_server.mcu) {
+        Mcu_Put(g_server.mcu, &rtp, opus_data, (uint16_t)opus_len, 0);
+        return;
+    }
+    
+    // 与客户端一样参与大厅的发言者选择
+    if (g_server.speakers) {
+        bool promoted;
+        g_server.speech_level = SpeakerSelector_Smooth(g_server.speech_level, &rtp);
+        if (!SpeakerSelector_Admit(g_server.speakers, ROOM_LOBBY_ID, g_server.ssrc,
+                                   g_server.speech_level, GetTickCount64Ms(), &promoted)) {
+            return;
         }
+        if (promoted) RtpHeader_SetMarker(&rtp, true);
     }
-    MutexUnlock(&g_server.clients_mutex);
+    
+    // 发送给所有客户端
+    SOCKADDR_IN addrs[SERVER_MAX_SESSIONS];
+    int counts[SERVER_MAX_AUDIO_WORKERS];
+    int token;
+    const RouteTable* routes = Routing_Acquire(&g_server.routing, &token);
+    CollectRecipients(routes, ROOM_LOBBY_ID, g_server.ssrc, addrs, counts);
+    Routing_Release(&g_server.routing, token);
+    
+    BroadcastUdpAudio(NULL, NULL, &rtp, opus_data, (uint16_t)opus_len, addrs, counts);
 }
 
 void Server_BroadcastAudioControl(uint8_t action, uint8_t muted) {
@@ -311,7 +592,9 @@ void Server_BroadcastAudioControl(uint8_t action, uint8_t muted) {
     pkt.action = action;
     pkt.muted = muted;
     
+    MutexLock(&g_server.clients_mutex);
     BroadcastTcpMessage(&pkt, sizeof(pkt), 0);
+    MutexUnlock(&g_server.clients_mutex);
 }
 
 //=============================================================================
@@ -340,9 +623,9 @@ static DWORD WINAPI DiscoveryThreadProc(LPVOID param) {
             resp.server_id = g_server.server_id;
             resp.tcp_port = g_server.tcp_port;
             resp.audio_udp_port = g_server.udp_audio_port;
-            resp.capability_flags = CAP_OPUS | CAP_VAD | CAP_JITTER;
-            resp.current_peers = (uint8_t)g_server.client_count;
-            resp.max_peers = MAX_CLIENTS;
+            resp.capability_flags = CAP_OPUS | CAP_VAD | CAP_JITTER | (g_server.mcu ? CAP_MCU : 0);
+            resp.current_peers = (uint8_t)MIN(g_server.sessions.count, 255);
+            resp.max_peers = (uint8_t)MIN(g_server.max_sessions, 255);
             strncpy(resp.server_name, g_server.name, MAX_NAME_LEN);
             strncpy(resp.version_str, APP_VERSION, sizeof(resp.version_str));
             
@@ -357,202 +640,433 @@ static DWORD WINAPI DiscoveryThreadProc(LPVOID param) {
     return 0;
 }
 
-static DWORD WINAPI TcpAcceptThreadProc(LPVOID param) {
-    LOG_DEBUG("TCP accept thread started");
+/**
+ * @brief 把 socket 加入轮询集合
+ * @return 在集合中的下标, 失败返回 -1
+ */
+static int PollSet_Add(PollSet* set, SOCKET sock, SessionHandle owner) {
+    if (set->count == set->capacity) {
+        int capacity = MAX(set->capacity * 2, SESSION_TABLE_PAGE_SIZE);
+        WSAPOLLFD* fds = (WSAPOLLFD*)realloc(set->fds, capacity * sizeof(WSAPOLLFD));
+        if (!fds) return -1;
+        set->fds = fds;
+        SessionHandle* owners = (SessionHandle*)realloc(set->owners, capacity * sizeof(SessionHandle));
+        if (!owners) return -1;
+        set->owners = owners;
+        set->capacity = capacity;
+    }
     
-    while (g_server.running) {
-        SOCKADDR_IN client_addr;
-        int addr_len = sizeof(client_addr);
-        
-        SOCKET client_socket = accept(g_server.tcp_control, (SOCKADDR*)&client_addr, &addr_len);
-        if (client_socket == INVALID_SOCKET) {
-            if (g_server.running) {
-                LOG_WARN("Accept failed: %d", WSAGetLastError());
-            }
-            continue;
-        }
-        
-        // 禁用 Nagle
-        BOOL nodelay = TRUE;
-        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&nodelay, sizeof(nodelay));
-        
-        // 查找空闲槽位
-        MutexLock(&g_server.clients_mutex);
-        int slot = -1;
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (!g_server.clients[i].active) {
-                slot = i;
-                break;
-            }
+    int index = set->count++;
+    set->fds[index].fd = sock;
+    set->fds[index].events = POLLRDNORM;
+    set->fds[index].revents = 0;
+    set->owners[index] = owner;
+    return index;
+}
+
+/**
+ * @brief 从轮询集合移除 (末项移入空位, 并更新其会话记录的下标)
+ */
+static void PollSet_Remove(PollSet* set, int index) {
+    if (index < POLL_FIRST_CLIENT || index >= set->count) return;
+    
+    int last = --set->count;
+    if (index != last) {
+        set->fds[index] = set->fds[last];
+        set->owners[index] = set->owners[last];
+        ClientSession* moved = (ClientSession*)SessionTable_Get(&g_server.sessions, set->owners[index]);
+        if (moved) moved->poll_index = index;
+    }
+}
+
+static void PollSet_Free(PollSet* set) {
+    free(set->fds);
+    free(set->owners);
+    memset(set, 0, sizeof(*set));
+}
+
+/**
+ * @brief 把会话放到活动链表末尾 (最近活动)
+ */
+static void IdleList_Append(ClientSession* client) {
+    client->idle_prev = g_server.idle_tail;
+    client->idle_next = SESSION_HANDLE_INVALID;
+    ClientSession* tail = (ClientSession*)SessionTable_Get(&g_server.sessions, g_server.idle_tail);
+    if (tail) {
+        tail->idle_next = client->handle;
+    } else {
+        g_server.idle_head = client->handle;
+    }
+    g_server.idle_tail = client->handle;
+}
+
+static void IdleList_Unlink(ClientSession* client) {
+    ClientSession* prev = (ClientSession*)SessionTable_Get(&g_server.sessions, client->idle_prev);
+    ClientSession* next = (ClientSession*)SessionTable_Get(&g_server.sessions, client->idle_next);
+    if (prev) prev->idle_next = client->idle_next;
+    else g_server.idle_head = client->idle_next;
+    if (next) next->idle_prev = client->idle_prev;
+    else g_server.idle_tail = client->idle_prev;
+    client->idle_prev = client->idle_next = SESSION_HANDLE_INVALID;
+}
+
+/**
+ * @brief 移除心跳超时的会话 (从活动链表表头开始, 遇到未超时的即停止)
+ * @return 到下一个会话超时的毫秒数, 没有会话时返回 -1 (无限等待)
+ */
+static int ExpireIdleClients(void) {
+    MutexLock(&g_server.clients_mutex);
+    for (;;) {
+        ClientSession* client = (ClientSession*)SessionTable_Get(&g_server.sessions, g_server.idle_head);
+        if (!client) {
+            MutexUnlock(&g_server.clients_mutex);
+            return -1;
         }
         
-        if (slot < 0) {
+        uint64_t now = GetTickCount64Ms();
+        uint64_t deadline = client->last_heartbeat + HEARTBEAT_TIMEOUT;
+        if (now <= deadline) {
             MutexUnlock(&g_server.clients_mutex);
-            LOG_WARN("Server full, rejecting connection");
-            Network_CloseSocket(client_socket);
-            continue;
+            return (int)(deadline - now) + 1;
         }
         
-        // 初始化客户端会话
-        ClientSession* session = &g_server.clients[slot];
-        memset(session, 0, sizeof(ClientSession));
-        session->tcp_socket = client_socket;
-        session->tcp_addr = client_addr;
-        session->last_heartbeat = GetTickCount64Ms();
-        session->active = true;
-        g_server.client_count++;
-        
+        LOG_WARN("Client %u timeout", client->client_id);
+        uint32_t client_id = client->client_id;
+        uint32_t room_id = client->room_id;
+        RemoveClient(client);
         MutexUnlock(&g_server.clients_mutex);
         
-        LOG_INFO("TCP connection from %s:%d (slot %d)",
-                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), slot);
+        NotifyClientLeft(room_id, client_id);
+        
+        MutexLock(&g_server.clients_mutex);
     }
+}
+
+/**
+ * @brief 接受一个新连接并分配会话 (调用者持有 clients_mutex)
+ */
+static void AcceptClient(void) {
+    SOCKADDR_IN client_addr;
+    int addr_len = sizeof(client_addr);
     
-    LOG_DEBUG("TCP accept thread stopped");
-    return 0;
+    SOCKET client_socket = accept(g_server.tcp_control, (SOCKADDR*)&client_addr, &addr_len);
+    if (client_socket == INVALID_SOCKET) {
+        if (g_server.running) {
+            LOG_WARN("Accept failed: %d", WSAGetLastError());
+        }
+        return;
+    }
+    
+    // 禁用 Nagle; 非阻塞, 发不完的数据进入发送队列
+    BOOL nodelay = TRUE;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, (char*)&nodelay, sizeof(nodelay));
+    if (!Network_SetNonBlocking(client_socket, true)) {
+        LOG_WARN("Failed to make client socket non-blocking: %d", WSAGetLastError());
+        Network_CloseSocket(client_socket);
+        return;
+    }
+    
+    if (g_server.sessions.count >= g_server.max_sessions) {
+        LOG_WARN("Server full (%d sessions%s), rejecting connection",
+                 g_server.sessions.count, g_server.mcu ? ", MCU limit" : "");
+        Network_CloseSocket(client_socket);
+        return;
+    }
+    
+    SessionHandle handle;
+    ClientSession* session = (ClientSession*)SessionTable_Alloc(&g_server.sessions, &handle);
+    bool framer = session && TcpFramer_Init(&session->framer);
+    Room* lobby = framer ? RoomRegistry_Join(&g_server.rooms, ROOM_LOBBY_NAME, handle) : NULL;
+    int poll_index = lobby ? PollSet_Add(&g_server.poll_set, client_socket, handle) : -1;
+    if (poll_index < 0) {
+        if (lobby) RoomRegistry_Leave(&g_server.rooms, ROOM_LOBBY_ID, handle);
+        if (framer) TcpFramer_Free(&session->framer);
+        SessionTable_Free(&g_server.sessions, handle);
+        LOG_WARN("Server full (%d sessions), rejecting connection", g_server.sessions.count);
+        Network_CloseSocket(client_socket);
+        return;
+    }
+    
+    // 初始化客户端会话
+    session->handle = handle;
+    session->tcp_socket = client_socket;
+    session->tcp_addr = client_addr;
+    session->poll_index = poll_index;
+    session->room_id = ROOM_LOBBY_ID;
+    session->last_heartbeat = GetTickCount64Ms();
+    IdleList_Append(session);
+    
+    LOG_INFO("TCP connection from %s:%d (session %08X, %d connected)",
+             inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), handle,
+             g_server.sessions.count);
 }
 
-static DWORD WINAPI TcpRecvThreadProc(LPVOID param) {
-    LOG_DEBUG("TCP recv thread started");
+/**
+ * @brief 读取一个连接的数据并处理完整数据包 (调用者持有 clients_mutex)
+ * @return false 连接已断开 (调用者负责移除会话并通知)
+ */
+static bool ReadClient(ClientSession* client) {
+    int received = TcpFramer_Recv(&client->framer, client->tcp_socket);
+    if (received == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+    
+    // 有数据即视为存活: 移到活动链表末尾
+    client->last_heartbeat = GetTickCount64Ms();
+    IdleList_Unlink(client);
+    IdleList_Append(client);
     
+    // 处理完整数据包 (原地, 跨越缓冲末尾的才复制到 scratch)
+    static uint8_t scratch[MAX_PACKET_SIZE];
+    const uint8_t* frame;
+    int len;
+    while ((len = TcpFramer_Next(&client->framer, &frame, scratch)) != 0) {
+        if (len < 0) {
+            LOG_WARN("Client %u: invalid packet header, discarding buffered data", client->client_id);
+            break;
+        }
+        HandleTcpPacket(client, frame, len);
+    }
+    return true;
+}
+
+/**
+ * @brief 发送队列状态变化时更新该连接的轮询事件 (调用者持有 clients_mutex)
+ */
+static void WatchWritable(ClientSession* client, bool writable) {
+    WSAPOLLFD* pfd = &g_server.poll_set.fds[client->poll_index];
+    short events = writable ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM;
+    if (pfd->events != events) {
+        pfd->events = events;
+        // 控制线程可能正在等待旧的事件集合, 叫醒它重新轮询
+        if (writable) Network_Wakeup(g_server.tcp_wakeup);
+    }
+}
+
+/**
+ * @brief 标记连接待断开 (对端不再接收或连接出错), 由控制线程移除 (调用者持有 clients_mutex)
+ */
+static void CloseClientLater(ClientSession* client) {
+    if (client->closing) return;
+    client->closing = true;
+    g_server.closing_count++;
+    Network_Wakeup(g_server.tcp_wakeup);
+}
+
+/**
+ * @brief 向客户端发送一个报文, 不阻塞 (调用者持有 clients_mutex)
+ *
+ * 发不完的部分进入发送队列, 等 socket 可写时由控制线程发出;
+ * 积压超过 TCP_SEND_QUEUE_LIMIT 的连接被断开.
+ */
+static void SendToClient(ClientSession* client, const void* data, int len) {
+    if (client->closing) return;
+    
+    int queued = TcpSendQueue_Send(&client->send_queue, client->tcp_socket, data, len);
+    if (queued < 0) {
+        LOG_WARN("Client %u: send failed or backlog over %d bytes, dropping connection",
+                 client->client_id, TCP_SEND_QUEUE_LIMIT);
+        CloseClientLater(client);
+        return;
+    }
+    WatchWritable(client, queued > 0);
+}
+
+/**
+ * @brief socket 可写时发出排队的数据 (调用者持有 clients_mutex)
+ * @return false 连接出错
+ */
+static bool FlushClient(ClientSession* client) {
+    int queued = TcpSendQueue_Flush(&client->send_queue, client->tcp_socket);
+    if (queued < 0) return false;
+    WatchWritable(client, queued > 0);
+    return true;
+}
+
+/**
+ * @brief 处理一个连接的轮询事件 (调用者持有 clients_mutex)
+ * @return false 连接应断开 (调用者负责移除会话并通知)
+ */
+static bool ServiceClient(ClientSession* client, short revents) {
+    if (client->closing) return false;
+    if ((revents & POLLWRNORM) && !FlushClient(client)) return false;
+    if ((revents & ~POLLWRNORM) && !ReadClient(client)) return false;
+    return !client->closing;
+}
+
+/**
+ * @brief 通知其他客户端与上层某个客户端已离开 (不持有 clients_mutex)
+ */
+static void NotifyClientLeft(uint32_t room_id, uint32_t client_id) {
+    MutexLock(&g_server.clients_mutex);
+    NotifyPeerLeave(room_id, client_id);
+    MutexUnlock(&g_server.clients_mutex);
+    if (g_server.callbacks.onClientLeft) {
+        g_server.callbacks.onClientLeft(client_id, g_server.callbacks.userdata);
+    }
+}
+
+static DWORD WINAPI TcpControlThreadProc(LPVOID param) {
+    LOG_DEBUG("TCP control thread started");
+    
+    // 轮询集合由本线程独占: 监听 socket, 唤醒 socket, 之后每个连接一项, 只在连接建立/断开时增删
+    MutexLock(&g_server.clients_mutex);
+    PollSet_Add(&g_server.poll_set, g_server.tcp_control, SESSION_HANDLE_INVALID);
+    PollSet_Add(&g_server.poll_set, g_server.tcp_wakeup, SESSION_HANDLE_INVALID);
+    MutexUnlock(&g_server.clients_mutex);
+    
+    int timeout = -1;
     while (g_server.running) {
-        fd_set read_fds;
-        FD_ZERO(&read_fds);
-        
-        SOCKET max_fd = 0;
+        // 没有事件时睡到最早的心跳超时时刻 (无连接时无限等待), 停止时由唤醒 socket 叫醒
+        int ret = WSAPoll(g_server.poll_set.fds, g_server.poll_set.count, timeout);
+        if (!g_server.running) break;
         
-        MutexLock(&g_server.clients_mutex);
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (g_server.clients[i].active) {
-                FD_SET(g_server.clients[i].tcp_socket, &read_fds);
-                if (g_server.clients[i].tcp_socket > max_fd) {
-                    max_fd = g_server.clients[i].tcp_socket;
-                }
+        if (ret > 0) {
+            MutexLock(&g_server.clients_mutex);
+            
+            if (g_server.poll_set.fds[POLL_WAKEUP].revents) {
+                g_server.poll_set.fds[POLL_WAKEUP].revents = 0;
+                Network_DrainWakeup(g_server.tcp_wakeup);
             }
-        }
-        MutexUnlock(&g_server.clients_mutex);
-        
-        if (max_fd == 0) {
-            Sleep(10);
-            continue;
-        }
-        
-        struct timeval tv = { 0, 100000 };  // 100ms
-        int ret = select((int)max_fd + 1, &read_fds, NULL, NULL, &tv);
-        
-        if (ret <= 0) continue;
-        
-        MutexLock(&g_server.clients_mutex);
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            ClientSession* client = &g_server.clients[i];
-            if (!client->active) continue;
             
-            if (FD_ISSET(client->tcp_socket, &read_fds)) {
-                int len = recv(client->tcp_socket, 
-                               (char*)client->recv_buf + client->recv_len,
-                               MAX_PACKET_SIZE - client->recv_len, 0);
-                
-                if (len <= 0) {
-                    uint32_t client_id = client->client_id;
-                    RemoveClient(i);
-                    MutexUnlock(&g_server.clients_mutex);
-                    
-                    NotifyPeerLeave(client_id);
-                    if (g_server.callbacks.onClientLeft) {
-                        g_server.callbacks.onClientLeft(client_id, g_server.callbacks.userdata);
-                    }
-                    
-                    MutexLock(&g_server.clients_mutex);
-                    continue;
-                }
+            // 倒序处理: 移除时移入空位的末项已经处理过;
+            // 有待断开的会话时 (发送积压或出错) 也检查没有事件的连接
+            for (int k = g_server.poll_set.count - 1; k >= POLL_FIRST_CLIENT; k--) {
+                short revents = g_server.poll_set.fds[k].revents;
+                if (!revents && !g_server.closing_count) continue;
+                g_server.poll_set.fds[k].revents = 0;
                 
-                client->recv_len += len;
-                client->last_heartbeat = GetTickCount64Ms();
+                ClientSession* client = (ClientSession*)SessionTable_Get(&g_server.sessions,
+                                                                         g_server.poll_set.owners[k]);
+                if (!client || (!revents && !client->closing)) continue;
                 
-                // 处理完整数据包
-                while (client->recv_len >= (int)sizeof(PacketHeader)) {
-                    PacketHeader* hdr = (PacketHeader*)client->recv_buf;
-                    if (!PacketHeader_Validate(hdr)) {
-                        client->recv_len = 0;
-                        break;
-                    }
-                    
-                    int pkt_len = sizeof(PacketHeader) + hdr->payload_len;
-                    if (client->recv_len < pkt_len) break;
-                    
-                    HandleTcpPacket(client, client->recv_buf, pkt_len);
-                    
-                    memmove(client->recv_buf, client->recv_buf + pkt_len, client->recv_len - pkt_len);
-                    client->recv_len -= pkt_len;
-                }
-            }
-        }
-        MutexUnlock(&g_server.clients_mutex);
-        
-        // 心跳超时检查
-        uint64_t now = GetTickCount64Ms();
-        MutexLock(&g_server.clients_mutex);
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (g_server.clients[i].active) {
-                if (now - g_server.clients[i].last_heartbeat > HEARTBEAT_TIMEOUT) {
-                    LOG_WARN("Client %u timeout", g_server.clients[i].client_id);
-                    uint32_t client_id = g_server.clients[i].client_id;
-                    RemoveClient(i);
+                uint32_t client_id = client->client_id;
+                uint32_t room_id = client->room_id;
+                if (!ServiceClient(client, revents)) {
+                    RemoveClient(client);
                     MutexUnlock(&g_server.clients_mutex);
-                    
-                    NotifyPeerLeave(client_id);
-                    if (g_server.callbacks.onClientLeft) {
-                        g_server.callbacks.onClientLeft(client_id, g_server.callbacks.userdata);
-                    }
-                    
+                    NotifyClientLeft(room_id, client_id);
                     MutexLock(&g_server.clients_mutex);
                 }
             }
+            
+            if (g_server.poll_set.fds[POLL_LISTENER].revents & POLLRDNORM) {
+                AcceptClient();
+            }
+            g_server.poll_set.fds[POLL_LISTENER].revents = 0;
+            
+            MutexUnlock(&g_server.clients_mutex);
+        } else if (ret < 0) {
+            LOG_WARN("WSAPoll failed: %d", WSAGetLastError());
+            Sleep(10);
         }
-        MutexUnlock(&g_server.clients_mutex);
+        
+        // 心跳超时检查 (只看活动链表表头), 并得到下一次等待时间
+        timeout = ExpireIdleClients();
     }
     
-    LOG_DEBUG("TCP recv thread stopped");
+    LOG_DEBUG("TCP control thread stopped");
     return 0;
 }
 
 static DWORD WINAPI UdpAudioThreadProc(LPVOID param) {
-    LOG_DEBUG("UDP audio thread started");
+    AudioWorker* worker = (AudioWorker*)param;
+    LOG_DEBUG("UDP audio thread %d started (port %u)", worker->index, worker->port);
     
     uint8_t payload[OPUS_MAX_PACKET];
     RtpHeader rtp;
-    int16_t pcm[AUDIO_FRAME_SAMPLES];
+    int counts[SERVER_MAX_AUDIO_WORKERS];
+    SOCKADDR_IN* addrs = (SOCKADDR_IN*)malloc(SERVER_MAX_SESSIONS * sizeof(SOCKADDR_IN));
+    SpeechState* speech = (SpeechState*)calloc(SPEECH_TABLE_SIZE, sizeof(SpeechState));
+    if (!addrs || !speech) {
+        free(addrs);
+        free(speech);
+        LOG_ERROR("UDP audio thread: out of memory");
+        return 1;
+    }
     
-    Network_SetRecvTimeout(g_server.udp_audio, 100);
+    // 本线程的计数 (定期发布到 worker->stats)
+    ServerPipelineStats local;
+    memset(&local, 0, sizeof(local));
+    uint64_t published_ms = GetTickCount64Ms();
+    
+    Network_SetRecvTimeout(worker->sock, 100);
     
     while (g_server.running) {
         SOCKADDR_IN from;
-        int payload_len = Network_RecvRtpPacket(g_server.udp_audio, &rtp, payload, 
-                                                 sizeof(payload), &from);
+        uint64_t recv_time_us = 0;
+        int payload_len = Network_RecvRtpPacket(worker->sock, &rtp, payload, 
+                                                 sizeof(payload), &from, &recv_time_us);
+        
+        uint64_t now_ms = GetTickCount64Ms();
+        if (now_ms - published_ms >= WORKER_PUBLISH_MS) {
+            PublishWorkerState(worker, &local, speech, now_ms);
+            published_ms = now_ms;
+        }
         
         if (payload_len < 0) continue;
         
-        // 查找发送者
-        ClientSession* sender = FindClientBySSRC(rtp.ssrc);
-        if (sender) {
-            sender->is_talking = RtpHeader_GetVadActive(&rtp);
+        local.packets_received++;
+        
+        // 从路由快照中查找发送者并收集收听者 (不触碰 clients_mutex)
+        // 源地址必须是已加入会话的客户端, 且 SSRC 与该会话一致, 否则丢弃
+        int token;
+        const RouteTable* routes = Routing_Acquire(&g_server.routing, &token);
+        const RouteEntry* sender = RouteTable_FindByAddr(routes, &from);
+        if (!sender || sender->ssrc != rtp.ssrc) {
+            bool spoofed = sender || RouteTable_Find(routes, rtp.ssrc);
+            Routing_Release(&g_server.routing, token);
+            CountRejected(&local, spoofed, rtp.ssrc, &from);
+            continue;
         }
         
-        // 解码 (用于本地监听或回调)
-        if (g_server.opus_decoder && g_server.callbacks.onAudioReceived) {
-            int samples = OpusCodec_Decode(g_server.opus_decoder, payload, payload_len,
-                                            pcm, AUDIO_FRAME_SAMPLES, 0);
-            if (samples > 0 && sender) {
-                g_server.callbacks.onAudioReceived(sender->client_id, pcm, samples,
-                                                    g_server.callbacks.userdata);
-            }
+        bool muted = sender->muted;
+        uint32_t sender_id = sender->client_id;
+        uint32_t room = sender->room;
+        Routing_Release(&g_server.routing, token);
+        
+        // 电平与讲话状态只存在本线程的表中, 不写会话 (会话由控制面持锁修改)
+        SpeechState* state = SpeechState_Get(speech, rtp.ssrc);
+        state->talking = RtpHeader_GetVadActive(&rtp) && !muted;
+        state->level = SpeakerSelector_Smooth(state->level, &rtp);
+        state->last_ms = now_ms;
+        
+        if (muted) continue;
+        
+        // 只转发房间内占据发言席位的发送者; 刚获得席位的包置 marker, 收听端从新讲话段开始缓冲.
+        // 发言者选择会加锁, 所以在快照读侧之外进行 (读者从不阻塞, 见 route_table.h)
+        bool promoted = false;
+        if (g_server.mcu) {
+            // 交给 MCU 混音
+            Mcu_Put(g_server.mcu, &rtp, payload, (uint16_t)payload_len, recv_time_us);
+        } else if (!g_server.speakers ||
+                   SpeakerSelector_Admit(g_server.speakers, room, rtp.ssrc, state->level,
+                                         now_ms, &promoted)) {
+            // 先转发给其他客户端, 转发延迟不受解码负载影响
+            routes = Routing_Acquire(&g_server.routing, &token);
+            CollectRecipients(routes, room, rtp.ssrc, addrs, counts);
+            Routing_Release(&g_server.routing, token);
+            if (promoted) RtpHeader_SetMarker(&rtp, true);
+            BroadcastUdpAudio(worker, &local.fanout, &rtp, payload, (uint16_t)payload_len, addrs, counts);
+            UpdateForwardStats(&local, recv_time_us);
+        } else {
+            local.packets_suppressed++;
         }
         
-        // 转发给其他客户端
-        BroadcastUdpAudio(&rtp, payload, payload_len, rtp.ssrc);
+        // 再交给解码工作池 (用于本地监听或回调)
+        if (g_server.decode_pool) {
+            DecodePool_Submit(g_server.decode_pool, rtp.ssrc, sender_id,
+                              payload, payload_len);
+        }
     }
     
-    LOG_DEBUG("UDP audio thread stopped");
+    PublishWorkerState(worker, &local, speech, GetTickCount64Ms());
+    free(speech);
+    free(addrs);
+    LOG_DEBUG("UDP audio thread %d stopped", worker->index);
     return 0;
 }
 
@@ -566,15 +1080,16 @@ static void HandleTcpPacket(ClientSession* client, const uint8_t* data, int len)
                             (uint32_t)time(NULL) ^ (uint32_t)(intptr_t)client;
         client->ssrc = client->client_id;  // SSRC = client_id
         strncpy(client->name, req->client_name, MAX_NAME_LEN - 1);
+        PublishRoutes();
         
         // 发送 HELLO_ACK
         HelloAck ack;
         PacketHeader_Init(&ack.header, MSG_HELLO_ACK, sizeof(HelloAck) - sizeof(PacketHeader));
         ack.result = 0;
         ack.assigned_id = client->client_id;
-        ack.audio_udp_port = g_server.udp_audio_port;
+        ack.audio_udp_port = WorkerForSsrc(client->ssrc)->port;    // 按 SSRC 固定到一个工作线程
         ack.server_time = GetTickCount64Ms();
-        Network_TcpSend(client->tcp_socket, &ack, sizeof(ack));
+        SendToClient(client, &ack, sizeof(ack));
         
         LOG_INFO("Client HELLO: %s (id=%u, ssrc=%u)", client->name, client->client_id, client->ssrc);
         break;
@@ -588,6 +1103,7 @@ static void HandleTcpPacket(ClientSession* client, const uint8_t* data, int len)
         client->udp_addr = client->tcp_addr;
         client->udp_addr.sin_port = htons(client->udp_port);
         client->audio_active = true;
+        PublishRoutes();
         
         // 发送 JOIN_SESSION_ACK
         JoinSessionAck ack;
@@ -595,40 +1111,20 @@ static void HandleTcpPacket(ClientSession* client, const uint8_t* data, int len)
         ack.result = 0;
         ack.ssrc = client->ssrc;
         ack.base_timestamp = GetTickCount64Ms() * (AUDIO_SAMPLE_RATE / 1000);
-        Network_TcpSend(client->tcp_socket, &ack, sizeof(ack));
-        
-        // 发送用户列表
-        uint8_t list_buf[MAX_PACKET_SIZE];
-        PeerListPacket* list = (PeerListPacket*)list_buf;
-        PeerInfo* peers = (PeerInfo*)(list_buf + sizeof(PeerListPacket));
-        int count = 0;
-        
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (g_server.clients[i].active && g_server.clients[i].client_id != client->client_id) {
-                peers[count].client_id = g_server.clients[i].client_id;
-                peers[count].ssrc = g_server.clients[i].ssrc;
-                strncpy(peers[count].name, g_server.clients[i].name, MAX_NAME_LEN);
-                peers[count].is_talking = g_server.clients[i].is_talking;
-                peers[count].is_muted = g_server.clients[i].is_muted;
-                peers[count].audio_active = g_server.clients[i].audio_active;
-                count++;
-            }
-        }
+        SendToClient(client, &ack, sizeof(ack));
         
-        PacketHeader_Init(&list->header, MSG_PEER_LIST,
-                          sizeof(PeerListPacket) - sizeof(PacketHeader) + count * sizeof(PeerInfo));
-        list->peer_count = count;
-        Network_TcpSend(client->tcp_socket, list_buf, sizeof(PeerListPacket) + count * sizeof(PeerInfo));
+        // 发送所在房间的用户列表
+        SendPeerList(client);
         
         LOG_INFO("Client joined session: %s (UDP port %d)", client->name, client->udp_port);
         
-        // 通知其他客户端
+        // 通知同房间的其他客户端
         PeerInfo peer = {0};
         peer.client_id = client->client_id;
         peer.ssrc = client->ssrc;
         strncpy(peer.name, client->name, MAX_NAME_LEN);
         peer.audio_active = true;
-        NotifyPeerJoin(&peer);
+        NotifyPeerJoin(client->room_id, &peer);
         
         if (g_server.callbacks.onClientJoined) {
             g_server.callbacks.onClientJoined(client->client_id, client->name, g_server.callbacks.userdata);
@@ -638,6 +1134,7 @@ static void HandleTcpPacket(ClientSession* client, const uint8_t* data, int len)
     
     case MSG_LEAVE_SESSION:
         client->audio_active = false;
+        PublishRoutes();
         LOG_INFO("Client left session: %s", client->name);
         break;
     
@@ -647,80 +1144,519 @@ static void HandleTcpPacket(ClientSession* client, const uint8_t* data, int len)
         PacketHeader_Init(&resp.header, MSG_HEARTBEAT, sizeof(HeartbeatPacket) - sizeof(PacketHeader));
         resp.client_id = client->client_id;
         resp.local_time = GetTickCount64Ms();
-        Network_TcpSend(client->tcp_socket, &resp, sizeof(resp));
+        SendToClient(client, &resp, sizeof(resp));
         break;
     }
     
     case MSG_AUDIO_START:
         client->audio_active = true;
+        PublishRoutes();
         LOG_DEBUG("Client %s audio started", client->name);
         break;
     
     case MSG_AUDIO_STOP:
         client->audio_active = false;
-        client->is_talking = false;
+        PublishRoutes();
         LOG_DEBUG("Client %s audio stopped", client->name);
         break;
     
     case MSG_AUDIO_MUTE:
         client->is_muted = true;
+        PublishRoutes();
         break;
     
     case MSG_AUDIO_UNMUTE:
         client->is_muted = false;
+        PublishRoutes();
+        break;
+    
+    case MSG_ROOM_JOIN: {
+        if (len < (int)sizeof(RoomJoinRequest)) break;
+        RoomJoinRequest* req = (RoomJoinRequest*)data;
+        char room_name[MAX_NAME_LEN];
+        memcpy(room_name, req->room_name, MAX_NAME_LEN);
+        room_name[MAX_NAME_LEN - 1] = '\0';
+        MoveToRoom(client, room_name);
+        break;
+    }
+    
+    case MSG_ROOM_LEAVE:
+        MoveToRoom(client, ROOM_LOBBY_NAME);
+        break;
+    
+    case MSG_ROOM_LIST:
+        SendRoomList(client);
         break;
     }
 }
 
 static void BroadcastTcpMessage(const void* data, int len, uint32_t exclude_id) {
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (g_server.clients[i].active && g_server.clients[i].client_id != exclude_id) {
-            Network_TcpSend(g_server.clients[i].tcp_socket, data, len);
+    for (int i = 0; i < g_server.sessions.limit; i++) {
+        ClientSession* client = (ClientSession*)SessionTable_At(&g_server.sessions, i, NULL);
+        if (client && client->client_id != exclude_id) {
+            SendToClient(client, data, len);
         }
     }
 }
 
-static void BroadcastUdpAudio(const RtpHeader* rtp, const uint8_t* payload, 
-                               uint16_t payload_len, uint32_t exclude_ssrc) {
-    MutexLock(&g_server.clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        ClientSession* c = &g_server.clients[i];
-        if (c->active && c->audio_active && c->ssrc != exclude_ssrc) {
-            Network_SendRtpPacket(g_server.udp_audio, rtp, payload, payload_len, &c->udp_addr);
+/**
+ * @brief 从路由快照收集一个房间的收听者地址, 按收听者所属的工作线程分组 (在读者区间内调用)
+ * @param addrs 输出 (至少 routes->count 项), 0 号工作线程的收听者在前, 依次排列
+ * @param counts 输出, 每个工作线程的收听者数 (worker_count 项)
+ * @return 收听者数
+ */
+static int CollectRecipients(const RouteTable* routes, uint32_t room, uint32_t exclude_ssrc,
+                             SOCKADDR_IN* addrs, int* counts) {
+    int first;
+    int members = RouteTable_RoomRange(routes, room, &first);
+    int workers = g_server.worker_count;
+    memset(counts, 0, workers * sizeof(int));
+    
+    // 只有一个工作线程时不必分组
+    if (workers == 1) {
+        for (int i = first; i < first + members; i++) {
+            const RouteEntry* e = &routes->entries[i];
+            if (e->receiving && e->ssrc != exclude_ssrc) {
+                addrs[counts[0]++] = e->addr;
+            }
         }
+        return counts[0];
     }
-    MutexUnlock(&g_server.clients_mutex);
+    
+    // 先计数, 再按各组起点放置
+    for (int i = first; i < first + members; i++) {
+        const RouteEntry* e = &routes->entries[i];
+        if (e->receiving && e->ssrc != exclude_ssrc) {
+            counts[WorkerForSsrc(e->ssrc)->index]++;
+        }
+    }
+    int offsets[SERVER_MAX_AUDIO_WORKERS];
+    int total = 0;
+    for (int w = 0; w < workers; w++) {
+        offsets[w] = total;
+        total += counts[w];
+    }
+    for (int i = first; i < first + members; i++) {
+        const RouteEntry* e = &routes->entries[i];
+        if (e->receiving && e->ssrc != exclude_ssrc) {
+            addrs[offsets[WorkerForSsrc(e->ssrc)->index]++] = e->addr;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief 把一个 RTP 包发给 CollectRecipients 收集的收听者, 每组从其工作线程的端口发出
+ *
+ * 本线程的一组走自己的批量发送器; 其他组直接 sendto 对方的 socket, 不碰对方的发送器,
+ * 工作线程之间没有锁.
+ * @param self 调用的工作线程 (NULL: 非工作线程, 全部直接发送)
+ * @param direct 累计直接发送的数据报与系统调用数, 可为 NULL
+ */
+static void BroadcastUdpAudio(AudioWorker* self, UdpBatchStats* direct, const RtpHeader* rtp,
+                              const uint8_t* payload, uint16_t payload_len,
+                              const SOCKADDR_IN* addrs, const int* counts) {
+    for (int w = 0; w < g_server.worker_count; w++) {
+        if (counts[w] == 0) continue;
+        
+        AudioWorker* worker = &g_server.workers[w];
+        if (worker == self) {
+            Network_SendRtpBatch(worker->fanout, rtp, payload, payload_len, addrs, counts[w]);
+        } else {
+            int sent = Network_SendRtpMulti(worker->sock, rtp, payload, payload_len, addrs, counts[w]);
+            if (direct) {
+                direct->datagrams += sent;
+                direct->syscalls += counts[w];
+            }
+        }
+        addrs += counts[w];
+    }
+}
+
+/**
+ * @brief 发送者所属的工作线程 (客户端把音频发往该线程的端口, 见 HELLO_ACK)
+ */
+static AudioWorker* WorkerForSsrc(uint32_t ssrc) {
+    return &g_server.workers[ssrc % (uint32_t)g_server.worker_count];
 }
 
-static void NotifyPeerJoin(const PeerInfo* peer) {
+/**
+ * @brief 在工作线程的电平表中查找发送者, 不在表中时占用一个槽 (电平从 0 开始)
+ */
+static SpeechState* SpeechState_Get(SpeechState* table, uint32_t ssrc) {
+    uint32_t h = (ssrc ^ (ssrc >> 16)) * 0x45d9f3bu;
+    SpeechState* victim = NULL;
+    for (int p = 0; p < SPEECH_TABLE_PROBE; p++) {
+        SpeechState* s = &table[(h + p) & (SPEECH_TABLE_SIZE - 1)];
+        if (s->last_ms != 0 && s->ssrc == ssrc) return s;
+        if (!victim || s->last_ms < victim->last_ms) victim = s;
+    }
+    
+    // 空槽或已离开的发送者 (探测范围内最久没有包的槽)
+    memset(victim, 0, sizeof(*victim));
+    victim->ssrc = ssrc;
+    return victim;
+}
+
+static int CompareSsrc(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * @brief 发布工作线程的计数与正在讲话的发送者列表, 并重建合并后的讲话列表
+ *
+ * 老客户端可能把音频发往 0 号端口, 所以合并所有工作线程而不只是 WorkerForSsrc.
+ */
+static void PublishWorkerState(AudioWorker* worker, const ServerPipelineStats* local,
+                               const SpeechState* speech, uint64_t now_ms) {
+    MutexLock(&worker->stats_mutex);
+    worker->stats = *local;
+    MutexUnlock(&worker->stats_mutex);
+    
+    uint32_t talking[SERVER_MAX_SESSIONS];
+    int n = 0;
+    for (int i = 0; i < SPEECH_TABLE_SIZE && n < SERVER_MAX_SESSIONS; i++) {
+        const SpeechState* s = &speech[i];
+        if (s->talking && s->last_ms != 0 && now_ms - s->last_ms < SPEECH_HOLD_MS) {
+            talking[n++] = s->ssrc;
+        }
+    }
+    
+    MutexLock(&g_server.talking_mutex);
+    memcpy(worker->talking, talking, n * sizeof(uint32_t));
+    worker->talking_count = n;
+    int total = 0;
+    for (int w = 0; w < g_server.worker_count; w++) {
+        const AudioWorker* other = &g_server.workers[w];
+        int copy = MIN(other->talking_count, SERVER_MAX_SESSIONS - total);
+        memcpy(g_server.talking + total, other->talking, copy * sizeof(uint32_t));
+        total += copy;
+    }
+    qsort(g_server.talking, total, sizeof(uint32_t), CompareSsrc);
+    g_server.talking_count = total;
+    MutexUnlock(&g_server.talking_mutex);
+}
+
+/**
+ * @brief 复制合并后的讲话列表 (最多滞后 WORKER_PUBLISH_MS)
+ * @param ssrcs 至少 SERVER_MAX_SESSIONS 项
+ * @return 列表长度
+ */
+static int CopyTalking(uint32_t* ssrcs) {
+    MutexLock(&g_server.talking_mutex);
+    int count = g_server.talking_count;
+    memcpy(ssrcs, g_server.talking, count * sizeof(uint32_t));
+    MutexUnlock(&g_server.talking_mutex);
+    return count;
+}
+
+/**
+ * @brief 发送者是否在 CopyTalking 得到的列表中 (二分查找)
+ */
+static bool IsTalking(const uint32_t* talking, int count, uint32_t ssrc) {
+    return bsearch(&ssrc, talking, count, sizeof(uint32_t), CompareSsrc) != NULL;
+}
+
+/**
+ * @brief 为每个工作线程创建音频 socket 与批量发送器
+ *
+ * 指定端口时绑定 udp_port, udp_port + 1, ...; 为 0 时各自自动分配.
+ * 0 号失败时返回 false; 其余失败时以已创建的数量运行.
+ */
+static bool StartAudioWorkers(uint16_t udp_port) {
+    g_server.worker_count = 0;
+    g_server.talking_count = 0;
+    for (int i = 0; i < g_server.audio_workers; i++) {
+        AudioWorker* worker = &g_server.workers[i];
+        uint16_t port = udp_port ? (uint16_t)(udp_port + i) : 0;
+        worker->sock = Network_CreateUdpFanout(port, &worker->port);
+        if (worker->sock == INVALID_SOCKET) {
+            if (i > 0) {
+                LOG_WARN("UDP audio port %u unavailable, running %d audio workers", port, i);
+            }
+            break;
+        }
+        worker->fanout = Network_CreateUdpBatch(worker->sock);
+        memset(&worker->stats, 0, sizeof(worker->stats));
+        worker->talking_count = 0;
+        g_server.worker_count++;
+    }
+    
+    if (g_server.worker_count == 0) return false;
+    g_server.udp_audio_port = g_server.workers[0].port;
+    return true;
+}
+
+/**
+ * @brief 释放工作线程的批量发送器 (socket 已关闭, 线程已退出)
+ */
+static void CloseAudioWorkers(void) {
+    for (int i = 0; i < g_server.worker_count; i++) {
+        Network_DestroyUdpBatch(g_server.workers[i].fanout);
+        g_server.workers[i].fanout = NULL;
+        g_server.workers[i].sock = INVALID_SOCKET;
+    }
+    g_server.worker_count = 0;
+}
+
+static void BroadcastToRoom(uint32_t room_id, const void* data, int len, uint32_t exclude_id) {
+    Room* room = RoomRegistry_Get(&g_server.rooms, room_id);
+    if (!room) return;
+    
+    for (int i = 0; i < room->member_count; i++) {
+        ClientSession* client = (ClientSession*)SessionTable_Get(&g_server.sessions, room->members[i]);
+        if (client && client->client_id != exclude_id) {
+            SendToClient(client, data, len);
+        }
+    }
+}
+
+static void NotifyPeerJoin(uint32_t room_id, const PeerInfo* peer) {
     PeerNotifyPacket pkt;
     PacketHeader_Init(&pkt.header, MSG_PEER_JOIN, sizeof(PeerNotifyPacket) - sizeof(PacketHeader));
     pkt.peer = *peer;
-    BroadcastTcpMessage(&pkt, sizeof(pkt), peer->client_id);
+    BroadcastToRoom(room_id, &pkt, sizeof(pkt), peer->client_id);
 }
 
-static void NotifyPeerLeave(uint32_t client_id) {
+static void NotifyPeerLeave(uint32_t room_id, uint32_t client_id) {
     PeerNotifyPacket pkt;
+    memset(&pkt, 0, sizeof(pkt));
     PacketHeader_Init(&pkt.header, MSG_PEER_LEAVE, sizeof(PeerNotifyPacket) - sizeof(PacketHeader));
     pkt.peer.client_id = client_id;
-    BroadcastTcpMessage(&pkt, sizeof(pkt), client_id);
+    BroadcastToRoom(room_id, &pkt, sizeof(pkt), client_id);
+}
+
+/**
+ * @brief 发送一个已填好 count 个 PeerInfo 的用户列表包
+ */
+static void SendPeerListPacket(ClientSession* client, uint8_t* list_buf, int count, uint8_t flags) {
+    PeerListPacket* list = (PeerListPacket*)list_buf;
+    PacketHeader_Init(&list->header, MSG_PEER_LIST,
+                      sizeof(PeerListPacket) - sizeof(PacketHeader) + count * sizeof(PeerInfo));
+    list->peer_count = (uint8_t)count;
+    list->flags = flags;
+    list->reserved[0] = list->reserved[1] = 0;
+    SendToClient(client, list_buf, sizeof(PeerListPacket) + count * sizeof(PeerInfo));
 }
 
-static void RemoveClient(int index) {
-    ClientSession* client = &g_server.clients[index];
-    if (client->active) {
-        Network_CloseSocket(client->tcp_socket);
-        client->active = false;
-        g_server.client_count--;
-        LOG_INFO("Client removed: %s (id=%u)", client->name, client->client_id);
+/**
+ * @brief 向客户端发送其所在房间的用户列表 (不含自己)
+ *
+ * 超出一个数据包容量时分成多个包, 第一个之后的包置 PEER_LIST_APPEND.
+ */
+static void SendPeerList(ClientSession* client) {
+    uint8_t list_buf[MAX_PACKET_SIZE];
+    PeerListPacket* list = (PeerListPacket*)list_buf;
+    PeerInfo* peers = (PeerInfo*)(list_buf + sizeof(PeerListPacket));
+    int count = 0;
+    uint8_t flags = 0;
+    uint32_t talking[SERVER_MAX_SESSIONS];
+    int talking_count = CopyTalking(talking);
+    
+    Room* room = RoomRegistry_Get(&g_server.rooms, client->room_id);
+    for (int i = 0; room && i < room->member_count; i++) {
+        ClientSession* other = (ClientSession*)SessionTable_Get(&g_server.sessions, room->members[i]);
+        if (other && other != client) {
+            if (count == PEER_LIST_MAX_PEERS) {
+                SendPeerListPacket(client, list_buf, count, flags);
+                count = 0;
+                flags = PEER_LIST_APPEND;
+            }
+            memset(&peers[count], 0, sizeof(PeerInfo));
+            peers[count].client_id = other->client_id;
+            peers[count].ssrc = other->ssrc;
+            strncpy(peers[count].name, other->name, MAX_NAME_LEN);
+            peers[count].is_talking = IsTalking(talking, talking_count, other->ssrc);
+            peers[count].is_muted = other->is_muted;
+            peers[count].audio_active = other->audio_active;
+            count++;
+        }
     }
+    
+    SendPeerListPacket(client, list_buf, count, flags);
 }
 
-static ClientSession* FindClientBySSRC(uint32_t ssrc) {
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (g_server.clients[i].active && g_server.clients[i].ssrc == ssrc) {
-            return &g_server.clients[i];
+/**
+ * @brief 把客户端移到指定房间 (不存在时创建), 通知新旧房间并发送新房间的用户列表
+ */
+static void MoveToRoom(ClientSession* client, const char* room_name) {
+    RoomJoinAck ack;
+    memset(&ack, 0, sizeof(ack));
+    PacketHeader_Init(&ack.header, MSG_ROOM_JOIN_ACK, sizeof(RoomJoinAck) - sizeof(PacketHeader));
+    
+    uint32_t old_room = client->room_id;
+    Room* room = RoomRegistry_Find(&g_server.rooms, room_name);
+    if (!room || room->id != old_room) {
+        // 先加入新房间, 失败时留在原房间
+        room = RoomRegistry_Join(&g_server.rooms, room_name, client->handle);
+        if (!room) {
+            ack.result = 1;
+            strncpy(ack.room_name, room_name, MAX_NAME_LEN - 1);
+            SendToClient(client, &ack, sizeof(ack));
+            LOG_WARN("Client %s: cannot join room %s (room limit reached)", client->name, room_name);
+            return;
         }
+        
+        RoomRegistry_Leave(&g_server.rooms, old_room, client->handle);
+        SpeakerSelector_Remove(g_server.speakers, old_room, client->ssrc);
+        client->room_id = room->id;
+        PublishRoutes();
+        NotifyPeerLeave(old_room, client->client_id);
+        
+        PeerInfo peer = {0};
+        peer.client_id = client->client_id;
+        peer.ssrc = client->ssrc;
+        strncpy(peer.name, client->name, MAX_NAME_LEN);
+        peer.is_muted = client->is_muted;
+        peer.audio_active = client->audio_active;
+        NotifyPeerJoin(room->id, &peer);
+        
+        LOG_INFO("Client %s moved to room %s (id=%u, %d members)",
+                 client->name, room->name, room->id, room->member_count);
     }
-    return NULL;
+    
+    ack.result = 0;
+    ack.room_id = room->id;
+    ack.members = (uint16_t)MIN(room->member_count, 0xFFFF);
+    strncpy(ack.room_name, room->name, MAX_NAME_LEN - 1);
+    SendToClient(client, &ack, sizeof(ack));
+    SendPeerList(client);
+}
+
+static void SendRoomList(ClientSession* client) {
+    uint8_t list_buf[MAX_PACKET_SIZE];
+    RoomListPacket* list = (RoomListPacket*)list_buf;
+    RoomInfo* rooms = (RoomInfo*)(list_buf + sizeof(RoomListPacket));
+    
+    int count = RoomRegistry_List(&g_server.rooms, rooms, ROOM_LIST_MAX_ROOMS);
+    PacketHeader_Init(&list->header, MSG_ROOM_LIST,
+                      sizeof(RoomListPacket) - sizeof(PacketHeader) + count * sizeof(RoomInfo));
+    list->room_count = (uint16_t)count;
+    list->reserved = 0;
+    SendToClient(client, list_buf, sizeof(RoomListPacket) + count * sizeof(RoomInfo));
+}
+
+/**
+ * @brief 关闭连接并释放会话 (控制线程中调用, 持有 clients_mutex)
+ */
+static void RemoveClient(ClientSession* client) {
+    LOG_INFO("Client removed: %s (id=%u)", client->name, client->client_id);
+    
+    uint32_t ssrc = client->ssrc;
+    Network_CloseSocket(client->tcp_socket);
+    PollSet_Remove(&g_server.poll_set, client->poll_index);
+    RoomRegistry_Leave(&g_server.rooms, client->room_id, client->handle);
+    SpeakerSelector_Remove(g_server.speakers, client->room_id, ssrc);
+    IdleList_Unlink(client);
+    TcpFramer_Free(&client->framer);
+    TcpSendQueue_Free(&client->send_queue);
+    if (client->closing) g_server.closing_count--;
+    SessionTable_Free(&g_server.sessions, client->handle);
+    
+    PublishRoutes();
+    Mcu_RemoveSource(g_server.mcu, ssrc);
+    DecodePool_Release(g_server.decode_pool, ssrc);
+}
+
+/**
+ * @brief MCU 收听者列表: 已加入会话的客户端
+ */
+static int GetMcuListeners(McuListener* listeners, int max_count, void* ctx) {
+    (void)ctx;
+    int count = 0;
+    int token;
+    const RouteTable* routes = Routing_Acquire(&g_server.routing, &token);
+    for (int i = 0; i < routes->count && count < max_count; i++) {
+        const RouteEntry* e = &routes->entries[i];
+        if (e->receiving) {
+            listeners[count].ssrc = e->ssrc;
+            listeners[count].room = e->room;
+            listeners[count].addr = e->addr;
+            listeners[count].sock = WorkerForSsrc(e->ssrc)->sock;
+            count++;
+        }
+    }
+    bool truncated = count == max_count && routes->count > max_count;
+    Routing_Release(&g_server.routing, token);
+    
+    // 会话数已限制为 MCU_MAX_LISTENERS, 不应发生; 只报告一次, 避免每个周期刷屏
+    static bool warned = false;
+    if (truncated && !warned) {
+        LOG_WARN("MCU: more than %d listeners, extra listeners get no mix", max_count);
+        warned = true;
+    }
+    return count;
+}
+
+/**
+ * @brief MCU 发送者所在房间 (按 SSRC 查路由快照; 已离开的发送者为 MCU_NO_ROOM)
+ */
+static void GetMcuSourceRooms(const uint32_t* ssrcs, int count, uint32_t* rooms, void* ctx) {
+    (void)ctx;
+    int token;
+    const RouteTable* routes = Routing_Acquire(&g_server.routing, &token);
+    for (int k = 0; k < count; k++) {
+        const RouteEntry* e = RouteTable_Find(routes, ssrcs[k]);
+        rooms[k] = e ? e->room : MCU_NO_ROOM;
+    }
+    Routing_Release(&g_server.routing, token);
+}
+
+/**
+ * @brief 记录一个包从收到到转发完成的耗时 (工作线程的本地计数)
+ */
+static void UpdateForwardStats(ServerPipelineStats* st, uint64_t recv_time_us) {
+    uint64_t now = GetTimeUs();
+    float latency_us = now > recv_time_us ? (float)(now - recv_time_us) : 0.0f;
+    
+    st->packets_forwarded++;
+    st->forward_latency_us += (latency_us - st->forward_latency_us) / 64.0f;
+    if (latency_us > st->forward_latency_max_us) {
+        st->forward_latency_max_us = latency_us;
+    }
+}
+
+/**
+ * @brief 记录一个被拒绝的包
+ * @param spoofed true: SSRC 属于某个会话但源地址不符; false: 未知的源地址与 SSRC
+ */
+static void CountRejected(ServerPipelineStats* st, bool spoofed, uint32_t ssrc, const SOCKADDR_IN* from) {
+    uint32_t n = spoofed ? ++st->packets_spoofed : ++st->packets_unknown;
+    
+    // 只记录 (每个工作线程) 每类的第一个及此后每 1000 个, 避免被刷屏
+    if (n % 1000 == 1) {
+        LOG_WARN("Dropped %s RTP ssrc=%u from %s:%u (%u so far)",
+                 spoofed ? "spoofed" : "unknown", ssrc, inet_ntoa(from->sin_addr),
+                 ntohs(from->sin_port), n);
+    }
+}
+
+/**
+ * @brief 按当前会话表发布新的路由快照 (调用者持有 clients_mutex)
+ *
+ * 等待音频面读者离开旧快照 (微秒级), 音频面从不等待这里.
+ */
+static void PublishRoutes(void) {
+    RouteTable* table = RouteTable_Create(g_server.sessions.count);
+    if (!table) {
+        LOG_ERROR("Failed to allocate route table");
+        return;
+    }
+    
+    for (int i = 0; i < g_server.sessions.limit; i++) {
+        ClientSession* c = (ClientSession*)SessionTable_At(&g_server.sessions, i, NULL);
+        if (!c || c->ssrc == 0) continue;
+        
+        RouteEntry* e = &table->entries[table->count++];
+        e->ssrc = c->ssrc;
+        e->client_id = c->client_id;
+        e->room = c->room_id;
+        e->addr = c->udp_addr;
+        e->receiving = c->audio_active;
+        e->muted = c->is_muted;
+    }
+    
+    Routing_Publish(&g_server.routing, table);
 }
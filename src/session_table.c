@@ -0,0 +1,140 @@
+/**
+ * @file session_table.c
+ * @brief 动态会话表实现
+ *
+ * 每个槽位由槽位头 (代数, 使用标志, 空闲链表指针) 和紧随其后的会话结构组成.
+ * 新页的槽位按从小到大的顺序挂到空闲链表, 释放的槽位放回表头, 优先复用.
+ */
+
+#include "session_table.h"
+
+//=============================================================================
+// 内部结构
+//=============================================================================
+
+#define SLOT_BITS   16
+#define SLOT_MASK   ((1u << SLOT_BITS) - 1)
+
+typedef struct {
+    uint16_t    generation;     // 每次分配加一 (跳过 0, 保证句柄非 0)
+    bool        used;
+    int         next_free;
+} SlotHeader;
+
+#define SLOT_HEADER_SIZE    ((sizeof(SlotHeader) + 7) & ~(size_t)7)
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+static SlotHeader* slot_at(const SessionTable* table, int slot) {
+    uint8_t* page = table->pages[slot / SESSION_TABLE_PAGE_SIZE];
+    return (SlotHeader*)(page + (size_t)(slot % SESSION_TABLE_PAGE_SIZE) * table->slot_size);
+}
+
+static void* slot_item(SlotHeader* header) {
+    return (uint8_t*)header + SLOT_HEADER_SIZE;
+}
+
+static SessionHandle make_handle(int slot, uint16_t generation) {
+    return ((uint32_t)generation << SLOT_BITS) | (uint32_t)slot;
+}
+
+/**
+ * @brief 分配新的一页并把其槽位挂到空闲链表
+ */
+static bool grow(SessionTable* table) {
+    if (table->limit >= table->max_slots) return false;
+
+    int page_index = table->limit / SESSION_TABLE_PAGE_SIZE;
+    uint8_t* page = (uint8_t*)calloc(SESSION_TABLE_PAGE_SIZE, table->slot_size);
+    if (!page) return false;
+
+    table->pages[page_index] = page;
+    int first = table->limit;
+    int last = MIN(first + SESSION_TABLE_PAGE_SIZE, table->max_slots);
+    for (int i = last - 1; i >= first; i--) {
+        SlotHeader* header = slot_at(table, i);
+        header->next_free = table->free_head;
+        table->free_head = i;
+    }
+    table->limit = last;
+
+    LOG_DEBUG("Session table grown to %d slots", table->limit);
+    return true;
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+void SessionTable_Init(SessionTable* table, size_t item_size, int max_sessions) {
+    memset(table, 0, sizeof(*table));
+    table->item_size = item_size;
+    table->slot_size = SLOT_HEADER_SIZE + ((item_size + 7) & ~(size_t)7);
+    table->max_slots = CLAMP(max_sessions, 1, SESSION_TABLE_PAGE_SIZE * SESSION_TABLE_MAX_PAGES);
+    table->free_head = -1;
+}
+
+void SessionTable_Destroy(SessionTable* table) {
+    for (int i = 0; i < SESSION_TABLE_MAX_PAGES; i++) {
+        free(table->pages[i]);
+        table->pages[i] = NULL;
+    }
+    table->limit = 0;
+    table->count = 0;
+    table->free_head = -1;
+}
+
+void* SessionTable_Alloc(SessionTable* table, SessionHandle* handle) {
+    if (table->free_head < 0 && !grow(table)) {
+        return NULL;
+    }
+
+    int slot = table->free_head;
+    SlotHeader* header = slot_at(table, slot);
+    table->free_head = header->next_free;
+
+    header->generation++;
+    if (header->generation == 0) header->generation = 1;
+    header->used = true;
+    header->next_free = -1;
+    table->count++;
+
+    void* item = slot_item(header);
+    memset(item, 0, table->item_size);
+    if (handle) *handle = make_handle(slot, header->generation);
+    return item;
+}
+
+void SessionTable_Free(SessionTable* table, SessionHandle handle) {
+    if (!SessionTable_Get(table, handle)) return;
+
+    int slot = (int)(handle & SLOT_MASK);
+    SlotHeader* header = slot_at(table, slot);
+    header->used = false;
+    header->next_free = table->free_head;
+    table->free_head = slot;
+    table->count--;
+}
+
+void* SessionTable_Get(const SessionTable* table, SessionHandle handle) {
+    int slot = (int)(handle & SLOT_MASK);
+    if (handle == SESSION_HANDLE_INVALID || slot >= table->limit) return NULL;
+
+    SlotHeader* header = slot_at(table, slot);
+    if (!header->used || header->generation != (uint16_t)(handle >> SLOT_BITS)) {
+        return NULL;
+    }
+    return slot_item(header);
+}
+
+void* SessionTable_At(const SessionTable* table, int slot, SessionHandle* handle) {
+    if (slot < 0 || slot >= table->limit) return NULL;
+
+    SlotHeader* header = slot_at(table, slot);
+    if (!header->used) return NULL;
+
+    if (handle) *handle = make_handle(slot, header->generation);
+    return slot_item(header);
+}
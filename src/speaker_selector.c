@@ -0,0 +1,247 @@
+/**
+ * @file speaker_selector.c
+ * @brief 活跃发言者选择实现
+ *
+ * 房间按 ID 哈希到 SPEAKER_STRIPES 个分段之一, 每个分段一把锁和一张开放寻址哈希表
+ * (线性探测, 删除时后移填补, 不留墓碑), 多个音频工作线程处理不同房间的包时互不等待.
+ * 只有存在席位的房间占用表项. 每个房间最多 SPEAKER_MAX_FORWARD 个席位,
+ * 查找与淘汰都是线性扫描.
+ */
+
+#include "speaker_selector.h"
+
+//=============================================================================
+// 内部结构
+//=============================================================================
+
+#define SPEAKER_STRIPES     8                           // 分段数 (不少于音频工作线程数上限)
+#define ROOM_BUCKETS        256                         // 每个分段的桶数 (服务器房间数上限, 房间全部落在
+                                                        // 同一分段时也放得下)
+#define UNKNOWN_LEVEL       (RTP_LEVEL_MAX - 40)        // 未携带电平的语音包按 -40 dBov 计
+
+typedef struct {
+    uint32_t    ssrc;
+    uint8_t     level;          // 平滑电平
+    uint64_t    seated_ms;      // 获得席位的时间
+    uint64_t    last_ms;        // 最近一个包的时间
+} SpeakerSeat;
+
+typedef struct {
+    bool        used;
+    uint32_t    room;
+    int         count;
+    uint64_t    clock_ms;       // 本房间见过的最新时间 (各线程在加锁前取时钟, 传入的时间可能略有倒退)
+    SpeakerSeat seats[SPEAKER_MAX_FORWARD];
+} SpeakerRoom;
+
+typedef struct {
+    Mutex       mutex;
+    SpeakerRoom rooms[ROOM_BUCKETS];
+} SpeakerStripe;
+
+struct SpeakerSelector {
+    int           max_forward;
+    SpeakerStripe stripes[SPEAKER_STRIPES];
+};
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+static uint32_t hash_room(uint32_t room) {
+    return room * 2654435761u;
+}
+
+/**
+ * @brief 房间所在分段 (取哈希高位, 桶号取低位, 两者独立)
+ */
+static SpeakerStripe* stripe_for(SpeakerSelector* selector, uint32_t room) {
+    return &selector->stripes[(hash_room(room) >> 24) % SPEAKER_STRIPES];
+}
+
+static uint32_t home_bucket(uint32_t room) {
+    return hash_room(room) & (ROOM_BUCKETS - 1);
+}
+
+static SpeakerRoom* find_room(SpeakerStripe* stripe, uint32_t room, bool create) {
+    uint32_t i = home_bucket(room);
+    for (int probes = 0; probes < ROOM_BUCKETS; probes++) {
+        SpeakerRoom* r = &stripe->rooms[i];
+        if (!r->used) {
+            if (!create) return NULL;
+            r->used = true;
+            r->room = room;
+            r->count = 0;
+            r->clock_ms = 0;
+            return r;
+        }
+        if (r->room == room) return r;
+        i = (i + 1) & (ROOM_BUCKETS - 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 删除房间表项, 把后续探测链上的表项前移填补空位
+ */
+static void delete_room(SpeakerStripe* stripe, SpeakerRoom* r) {
+    uint32_t hole = (uint32_t)(r - stripe->rooms);
+    uint32_t j = hole;
+    for (int probes = 1; probes < ROOM_BUCKETS; probes++) {
+        j = (j + 1) & (ROOM_BUCKETS - 1);
+        SpeakerRoom* next = &stripe->rooms[j];
+        if (!next->used) break;
+
+        // 表项的起始桶不在 (hole, j] 区间内时, 才能移到 hole
+        uint32_t home = home_bucket(next->room);
+        bool between = (hole <= j) ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!between) {
+            stripe->rooms[hole] = *next;
+            hole = j;
+        }
+    }
+    stripe->rooms[hole].used = false;
+    stripe->rooms[hole].count = 0;
+}
+
+static void remove_seat(SpeakerRoom* r, int index) {
+    r->seats[index] = r->seats[--r->count];
+}
+
+static int find_seat(const SpeakerRoom* r, uint32_t ssrc) {
+    for (int i = 0; i < r->count; i++) {
+        if (r->seats[i].ssrc == ssrc) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief 最弱的席位: 电平最低, 相同时取最久没有包的
+ */
+static int weakest_seat(const SpeakerRoom* r) {
+    int weakest = 0;
+    for (int i = 1; i < r->count; i++) {
+        const SpeakerSeat* s = &r->seats[i];
+        const SpeakerSeat* w = &r->seats[weakest];
+        if (s->level < w->level || (s->level == w->level && s->last_ms < w->last_ms)) {
+            weakest = i;
+        }
+    }
+    return weakest;
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+SpeakerSelector* SpeakerSelector_Create(int max_forward) {
+    SpeakerSelector* selector = (SpeakerSelector*)calloc(1, sizeof(SpeakerSelector));
+    if (!selector) return NULL;
+
+    selector->max_forward = CLAMP(max_forward, 1, SPEAKER_MAX_FORWARD);
+    for (int i = 0; i < SPEAKER_STRIPES; i++) {
+        MutexInit(&selector->stripes[i].mutex);
+    }
+
+    LOG_INFO("Active speaker selection: top %d per room", selector->max_forward);
+    return selector;
+}
+
+void SpeakerSelector_Destroy(SpeakerSelector* selector) {
+    if (!selector) return;
+    for (int i = 0; i < SPEAKER_STRIPES; i++) {
+        MutexDestroy(&selector->stripes[i].mutex);
+    }
+    free(selector);
+}
+
+uint8_t SpeakerSelector_Smooth(uint8_t previous, const RtpHeader* rtp) {
+    int score = 0;
+    if (RtpHeader_GetVadActive(rtp)) {
+        uint8_t level = RtpHeader_GetLevel(rtp);
+        score = level ? level : UNKNOWN_LEVEL;
+    }
+
+    int level = previous;
+    if (score > level) {
+        level += (score - level + 1) / 2;
+    } else {
+        level -= (level - score + 7) / 8;
+    }
+    return (uint8_t)level;
+}
+
+bool SpeakerSelector_Admit(SpeakerSelector* selector, uint32_t room, uint32_t ssrc,
+                           uint8_t level, uint64_t now_ms, bool* promoted) {
+    if (promoted) *promoted = false;
+
+    SpeakerStripe* stripe = stripe_for(selector, room);
+    MutexLock(&stripe->mutex);
+
+    SpeakerRoom* r = find_room(stripe, room, level > 0);
+    if (!r) {
+        MutexUnlock(&stripe->mutex);
+        return false;
+    }
+
+    // 时间在房间内单调不减, 下面的经过时间不会因为回绕而变成极大值
+    now_ms = MAX(now_ms, r->clock_ms);
+    r->clock_ms = now_ms;
+
+    bool forward = false;
+    int seat = find_seat(r, ssrc);
+    if (seat >= 0) {
+        r->seats[seat].level = level;
+        r->seats[seat].last_ms = now_ms;
+        forward = true;
+    } else if (level > 0) {
+        // 静音的包不争夺席位; 先腾出空闲席位
+        for (int i = r->count - 1; i >= 0; i--) {
+            if (now_ms - r->seats[i].last_ms > SPEAKER_IDLE_MS) {
+                remove_seat(r, i);
+            }
+        }
+
+        if (r->count < selector->max_forward) {
+            seat = r->count++;
+        } else {
+            int w = weakest_seat(r);
+            const SpeakerSeat* weakest = &r->seats[w];
+            if (level > weakest->level + SPEAKER_HYSTERESIS &&
+                (weakest->level == 0 || now_ms - weakest->seated_ms >= SPEAKER_MIN_HOLD_MS)) {
+                seat = w;
+            }
+        }
+
+        if (seat >= 0) {
+            SpeakerSeat* s = &r->seats[seat];
+            s->ssrc = ssrc;
+            s->level = level;
+            s->seated_ms = now_ms;
+            s->last_ms = now_ms;
+            forward = true;
+            if (promoted) *promoted = true;
+        }
+    }
+
+    if (r->count == 0) {
+        delete_room(stripe, r);
+    }
+
+    MutexUnlock(&stripe->mutex);
+    return forward;
+}
+
+void SpeakerSelector_Remove(SpeakerSelector* selector, uint32_t room, uint32_t ssrc) {
+    if (!selector) return;
+
+    SpeakerStripe* stripe = stripe_for(selector, room);
+    MutexLock(&stripe->mutex);
+    SpeakerRoom* r = find_room(stripe, room, false);
+    if (r) {
+        int seat = find_seat(r, ssrc);
+        if (seat >= 0) remove_seat(r, seat);
+        if (r->count == 0) delete_room(stripe, r);
+    }
+    MutexUnlock(&stripe->mutex);
+}
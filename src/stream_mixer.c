@@ -0,0 +1,376 @@
+/**
+ * @file stream_mixer.c
+ * @brief 多路接收混音器实现
+ *
+ * 工作原理:
+ * 1. UDP 接收线程 -> StreamMixer_Put -> 按 SSRC 找到 (或创建) 流 -> JitterBuffer_Put
+ * 2. 播放线程 -> StreamMixer_Mix -> 每路 JitterBuffer_Get 一帧 -> Audio_Mix
+ *    (服务器 MCU 用 StreamMixer_GetFrames 取各路 PCM 与总和, 自行生成 mix-minus)
+ * 3. 流只在播放线程中销毁, 接收线程只会新增流, 因此取帧时无需持有表锁
+ */
+
+#include "stream_mixer.h"
+#include "opus_codec.h"
+#include "audio.h"
+#include <math.h>
+
+//=============================================================================
+// 内部结构
+//=============================================================================
+
+/**
+ * @brief 单路接收流
+ */
+typedef struct {
+    bool          active;           // 槽是否使用中
+    bool          removing;         // 等待回收
+    uint32_t      ssrc;             // 来源标识
+    OpusCodec*    decoder;          // 独立解码器
+    JitterBuffer* jitter_buffer;    // 独立抖动缓冲
+    uint64_t      last_packet_time; // 最后收包时间
+} MixerStream;
+
+struct StreamMixer {
+    // 配置
+    JitterConfig config;
+    bool         has_config;
+
+    // 流表
+    MixerStream  streams[MIXER_MAX_STREAMS];
+    int          stream_count;
+
+    // 混音缓冲 (仅播放线程使用)
+    int16_t      pcm[MIXER_MAX_STREAMS][AUDIO_FRAME_SAMPLES];
+
+    // 同步 (保护流表)
+    Mutex        mutex;
+};
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 查找 SSRC 对应的流 (调用者持有锁)
+ */
+static MixerStream* find_stream(StreamMixer* mixer, uint32_t ssrc) {
+    for (int i = 0; i < MIXER_MAX_STREAMS; i++) {
+        MixerStream* s = &mixer->streams[i];
+        if (s->active && !s->removing && s->ssrc == ssrc) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 创建新流 (调用者持有锁)
+ */
+static MixerStream* create_stream(StreamMixer* mixer, uint32_t ssrc) {
+    MixerStream* s = NULL;
+    for (int i = 0; i < MIXER_MAX_STREAMS; i++) {
+        if (!mixer->streams[i].active) {
+            s = &mixer->streams[i];
+            break;
+        }
+    }
+
+    if (!s) {
+        return NULL;  // 流表已满
+    }
+
+    OpusDecoderConfig dec_config;
+    OpusCodec_GetDefaultDecoderConfig(&dec_config);
+    s->decoder = OpusCodec_Create(NULL, &dec_config);
+    if (!s->decoder) {
+        return NULL;
+    }
+
+    s->jitter_buffer = JitterBuffer_Create(mixer->has_config ? &mixer->config : NULL);
+    if (!s->jitter_buffer) {
+        OpusCodec_Destroy(s->decoder);
+        s->decoder = NULL;
+        return NULL;
+    }
+
+    JitterBuffer_SetDecoder(s->jitter_buffer, OpusCodec_GetDecoder(s->decoder),
+                            OpusCodec_JitterDecode);
+    JitterBuffer_SetPlc(s->jitter_buffer, OpusCodec_JitterPlc);
+    JitterBuffer_SetPacketSamples(s->jitter_buffer, OpusCodec_GetPacketSamples);
+
+    s->ssrc = ssrc;
+    s->removing = false;
+    s->last_packet_time = GetTickCount64Ms();
+    s->active = true;
+    mixer->stream_count++;
+
+    LOG_INFO("StreamMixer: stream added (ssrc=%u, total=%d)", ssrc, mixer->stream_count);
+    return s;
+}
+
+/**
+ * @brief 销毁流 (调用者持有锁, 且不能与该流的 Get 并发)
+ */
+static void destroy_stream(StreamMixer* mixer, MixerStream* s) {
+    if (!s->active) return;
+
+    JitterBuffer_Destroy(s->jitter_buffer);
+    OpusCodec_Destroy(s->decoder);
+
+    LOG_INFO("StreamMixer: stream removed (ssrc=%u)", s->ssrc);
+
+    memset(s, 0, sizeof(*s));
+    mixer->stream_count--;
+}
+
+/**
+ * @brief 从所有流各取 num_samples 个采样到 mixer->pcm, 并回收已移除或超时的流 (播放线程)
+ * @param ssrcs 输出有数据的流 SSRC (可为 NULL)
+ * @return 有数据的流数, 其 PCM 依次位于 mixer->pcm[0..n)
+ */
+static int pull_streams(StreamMixer* mixer, int num_samples, uint32_t* ssrcs) {
+    // 快照当前流 (流只在本线程销毁, 解锁后指针仍然有效)
+    JitterBuffer* buffers[MIXER_MAX_STREAMS];
+    uint32_t buffer_ssrcs[MIXER_MAX_STREAMS];
+    int buffer_count = 0;
+
+    MutexLock(&mixer->mutex);
+    for (int i = 0; i < MIXER_MAX_STREAMS; i++) {
+        MixerStream* s = &mixer->streams[i];
+        if (s->active && !s->removing) {
+            buffer_ssrcs[buffer_count] = s->ssrc;
+            buffers[buffer_count++] = s->jitter_buffer;
+        }
+    }
+    MutexUnlock(&mixer->mutex);
+
+    // 逐路取相同数量的采样
+    int input_count = 0;
+
+    for (int i = 0; i < buffer_count; i++) {
+        int n = JitterBuffer_Get(buffers[i], mixer->pcm[input_count], num_samples);
+        if (n <= 0) continue;
+
+        if (ssrcs) ssrcs[input_count] = buffer_ssrcs[i];
+        input_count++;
+    }
+
+    // 回收已移除或超时的流
+    uint64_t now = GetTickCount64Ms();
+    MutexLock(&mixer->mutex);
+    for (int i = 0; i < MIXER_MAX_STREAMS; i++) {
+        MixerStream* s = &mixer->streams[i];
+        if (s->active && (s->removing || now - s->last_packet_time > MIXER_STREAM_TIMEOUT)) {
+            destroy_stream(mixer, s);
+        }
+    }
+    MutexUnlock(&mixer->mutex);
+
+    return input_count;
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+StreamMixer* StreamMixer_Create(const JitterConfig* config) {
+    StreamMixer* mixer = (StreamMixer*)calloc(1, sizeof(StreamMixer));
+    if (!mixer) return NULL;
+
+    if (config) {
+        mixer->config = *config;
+        mixer->has_config = true;
+    }
+
+    MutexInit(&mixer->mutex);
+
+    LOG_INFO("StreamMixer created: max %d streams", MIXER_MAX_STREAMS);
+    return mixer;
+}
+
+void StreamMixer_Destroy(StreamMixer* mixer) {
+    if (!mixer) return;
+
+    StreamMixer_Reset(mixer);
+    MutexDestroy(&mixer->mutex);
+    free(mixer);
+
+    LOG_INFO("StreamMixer destroyed");
+}
+
+void StreamMixer_Reset(StreamMixer* mixer) {
+    if (!mixer) return;
+
+    MutexLock(&mixer->mutex);
+    for (int i = 0; i < MIXER_MAX_STREAMS; i++) {
+        destroy_stream(mixer, &mixer->streams[i]);
+    }
+    mixer->stream_count = 0;
+    MutexUnlock(&mixer->mutex);
+}
+
+int StreamMixer_Put(StreamMixer* mixer, const RtpHeader* rtp,
+                    const uint8_t* payload, uint16_t payload_len, uint64_t recv_time_us) {
+    if (!mixer || !rtp || !payload || payload_len == 0) {
+        return -1;
+    }
+
+    MutexLock(&mixer->mutex);
+
+    MixerStream* s = find_stream(mixer, rtp->ssrc);
+    if (!s) {
+        s = create_stream(mixer, rtp->ssrc);
+        if (!s) {
+            MutexUnlock(&mixer->mutex);
+            return -1;
+        }
+    }
+
+    s->last_packet_time = GetTickCount64Ms();
+    int ret = JitterBuffer_Put(s->jitter_buffer, rtp, payload, payload_len, recv_time_us);
+
+    MutexUnlock(&mixer->mutex);
+    return ret;
+}
+
+int StreamMixer_Mix(StreamMixer* mixer, int16_t* samples, int num_samples) {
+    if (!mixer || !samples || num_samples <= 0) {
+        return -1;
+    }
+    
+    // 每次最多混合一帧 (混音暂存缓冲大小)
+    num_samples = MIN(num_samples, AUDIO_FRAME_SAMPLES);
+
+    int input_count = pull_streams(mixer, num_samples, NULL);
+    if (input_count == 0) {
+        return 0;
+    }
+
+    const int16_t* inputs[MIXER_MAX_STREAMS];
+    for (int i = 0; i < input_count; i++) {
+        inputs[i] = mixer->pcm[i];
+    }
+
+    if (input_count == 1) {
+        memcpy(samples, inputs[0], num_samples * sizeof(int16_t));
+    } else {
+        Audio_Mix(samples, inputs, input_count, num_samples);
+    }
+
+    return num_samples;
+}
+
+int StreamMixer_GetFrames(StreamMixer* mixer, int num_samples, uint32_t* ssrcs,
+                          const int16_t** pcm, int32_t* total) {
+    if (!mixer || !ssrcs || !pcm || !total || num_samples <= 0 || num_samples > AUDIO_FRAME_SAMPLES) {
+        return -1;
+    }
+
+    int count = pull_streams(mixer, num_samples, ssrcs);
+
+    memset(total, 0, num_samples * sizeof(int32_t));
+    for (int i = 0; i < count; i++) {
+        const int16_t* x = mixer->pcm[i];
+        for (int j = 0; j < num_samples; j++) {
+            total[j] += x[j];
+        }
+        pcm[i] = x;
+    }
+
+    return count;
+}
+
+void StreamMixer_RemoveStream(StreamMixer* mixer, uint32_t ssrc) {
+    if (!mixer) return;
+
+    MutexLock(&mixer->mutex);
+    MixerStream* s = find_stream(mixer, ssrc);
+    if (s) {
+        s->removing = true;
+    }
+    MutexUnlock(&mixer->mutex);
+}
+
+int StreamMixer_GetStreamCount(StreamMixer* mixer) {
+    if (!mixer) return 0;
+    return mixer->stream_count;
+}
+
+bool StreamMixer_GetStreamStats(StreamMixer* mixer, uint32_t ssrc,
+                                JitterStats* stats, int* level_ms) {
+    if (!stats) return false;
+
+    JitterSnapshot snap;
+    if (!StreamMixer_GetStreamSnapshot(mixer, ssrc, &snap)) {
+        return false;
+    }
+
+    *stats = snap.stats;
+    if (level_ms) *level_ms = snap.level_ms;
+    return true;
+}
+
+bool StreamMixer_GetStreamSnapshot(StreamMixer* mixer, uint32_t ssrc, JitterSnapshot* snap) {
+    if (!mixer || !snap) return false;
+
+    // 表锁只防止流被销毁; 快照本身不经过抖动缓冲的互斥锁
+    MutexLock(&mixer->mutex);
+    MixerStream* s = find_stream(mixer, ssrc);
+    bool ok = s && JitterBuffer_GetSnapshot(s->jitter_buffer, snap);
+    MutexUnlock(&mixer->mutex);
+
+    return ok;
+}
+
+void StreamMixer_GetStats(StreamMixer* mixer, JitterStats* stats, int* level_ms) {
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+    if (level_ms) *level_ms = 0;
+    if (!mixer) return;
+
+    MutexLock(&mixer->mutex);
+    for (int i = 0; i < MIXER_MAX_STREAMS; i++) {
+        MixerStream* s = &mixer->streams[i];
+        if (!s->active || s->removing) continue;
+
+        JitterSnapshot snap;
+        if (!JitterBuffer_GetSnapshot(s->jitter_buffer, &snap)) {
+            continue;  // 连续与写入冲突 (极少见), 本次不计
+        }
+        const JitterStats* st = &snap.stats;
+
+        stats->packets_received += st->packets_received;
+        stats->packets_lost += st->packets_lost;
+        stats->packets_recovered += st->packets_recovered;
+        stats->packets_concealed += st->packets_concealed;
+        stats->packets_late += st->packets_late;
+        stats->packets_reorder += st->packets_reorder;
+        stats->packets_oversize += st->packets_oversize;
+        stats->underruns += st->underruns;
+        stats->overruns += st->overruns;
+        stats->frames_dropped += st->frames_dropped;
+        stats->resyncs += st->resyncs;
+        stats->frames_accelerated += st->frames_accelerated;
+        stats->frames_decelerated += st->frames_decelerated;
+        stats->frames_comfort_noise += st->frames_comfort_noise;
+        stats->stretch_cost_us = MAX(stats->stretch_cost_us, st->stretch_cost_us);
+        stats->put_cost_us = MAX(stats->put_cost_us, st->put_cost_us);
+        stats->put_cost_max_us = MAX(stats->put_cost_max_us, st->put_cost_max_us);
+        stats->target_delay_ms = MAX(stats->target_delay_ms, st->target_delay_ms);
+        stats->avg_jitter_ms = MAX(stats->avg_jitter_ms, st->avg_jitter_ms);
+        if (fabsf(st->drift_ppm) > fabsf(stats->drift_ppm)) {
+            stats->drift_ppm = st->drift_ppm;   // 偏差最大的一路
+        }
+
+        if (level_ms) {
+            *level_ms = MAX(*level_ms, snap.level_ms);
+        }
+    }
+    MutexUnlock(&mixer->mutex);
+
+    uint32_t total = stats->packets_received + stats->packets_lost;
+    if (total > 0) {
+        stats->loss_rate = (float)stats->packets_lost / total;
+    }
+}
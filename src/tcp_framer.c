@@ -0,0 +1,132 @@
+/**
+ * @file tcp_framer.c
+ * @brief TCP 控制报文分帧与发送队列实现
+ */
+
+#include "tcp_framer.h"
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+#define RING_MASK   (TCP_FRAMER_RING_SIZE - 1)
+
+/**
+ * @brief 从读位置复制 len 字节 (可跨越缓冲末尾)
+ */
+static void copy_out(const TcpFramer* framer, uint32_t pos, void* dst, uint32_t len) {
+    uint32_t offset = pos & RING_MASK;
+    uint32_t first = MIN(len, TCP_FRAMER_RING_SIZE - offset);
+    memcpy(dst, framer->ring + offset, first);
+    memcpy((uint8_t*)dst + first, framer->ring, len - first);
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+bool TcpFramer_Init(TcpFramer* framer) {
+    framer->ring = (uint8_t*)malloc(TCP_FRAMER_RING_SIZE);
+    framer->head = 0;
+    framer->tail = 0;
+    return framer->ring != NULL;
+}
+
+void TcpFramer_Free(TcpFramer* framer) {
+    free(framer->ring);
+    framer->ring = NULL;
+    framer->head = framer->tail = 0;
+}
+
+int TcpFramer_Recv(TcpFramer* framer, SOCKET sock) {
+    // 未处理的数据总是不足一个报文, 空闲区至少有 TCP_FRAMER_RING_SIZE - MAX_PACKET_SIZE 字节
+    uint32_t used = framer->tail - framer->head;
+    uint32_t offset = framer->tail & RING_MASK;
+    uint32_t space = MIN(TCP_FRAMER_RING_SIZE - used, TCP_FRAMER_RING_SIZE - offset);
+
+    int len = recv(sock, (char*)framer->ring + offset, (int)space, 0);
+    if (len > 0) {
+        framer->tail += (uint32_t)len;
+    }
+    return len;
+}
+
+int TcpFramer_Next(TcpFramer* framer, const uint8_t** frame, uint8_t* scratch) {
+    uint32_t avail = framer->tail - framer->head;
+    if (avail < sizeof(PacketHeader)) return 0;
+
+    uint32_t offset = framer->head & RING_MASK;
+    PacketHeader header;
+    const PacketHeader* hdr = (const PacketHeader*)(framer->ring + offset);
+    if (offset + sizeof(PacketHeader) > TCP_FRAMER_RING_SIZE) {
+        copy_out(framer, framer->head, &header, sizeof(header));
+        hdr = &header;
+    }
+
+    if (!PacketHeader_Validate(hdr) || hdr->payload_len > MAX_PACKET_SIZE - sizeof(PacketHeader)) {
+        framer->head = framer->tail = 0;
+        return -1;
+    }
+
+    uint32_t len = (uint32_t)sizeof(PacketHeader) + hdr->payload_len;
+    if (avail < len) return 0;
+
+    if (offset + len <= TCP_FRAMER_RING_SIZE) {
+        *frame = framer->ring + offset;
+    } else {
+        copy_out(framer, framer->head, scratch, len);
+        *frame = scratch;
+    }
+
+    framer->head += len;
+    if (framer->head == framer->tail) {
+        framer->head = framer->tail = 0;
+    }
+    return (int)len;
+}
+
+int TcpSendQueue_Send(TcpSendQueue* queue, SOCKET sock, const void* data, int len) {
+    const uint8_t* ptr = (const uint8_t*)data;
+    
+    if (queue->len == 0) {
+        int n = send(sock, (const char*)ptr, len, 0);
+        if (n == SOCKET_ERROR) {
+            if (WSAGetLastError() != WSAEWOULDBLOCK) return -1;
+            n = 0;
+        }
+        ptr += n;
+        len -= n;
+        if (len == 0) return 0;
+    }
+    
+    if (queue->len + len > TCP_SEND_QUEUE_LIMIT) return -1;
+    if (queue->len + len > queue->capacity) {
+        int capacity = MAX(queue->capacity, MAX_PACKET_SIZE);
+        while (capacity < queue->len + len) capacity *= 2;
+        capacity = MIN(capacity, TCP_SEND_QUEUE_LIMIT);
+        uint8_t* buf = (uint8_t*)realloc(queue->buf, capacity);
+        if (!buf) return -1;
+        queue->buf = buf;
+        queue->capacity = capacity;
+    }
+    memcpy(queue->buf + queue->len, ptr, len);
+    queue->len += len;
+    return queue->len;
+}
+
+int TcpSendQueue_Flush(TcpSendQueue* queue, SOCKET sock) {
+    if (queue->len == 0) return 0;
+    
+    int n = send(sock, (const char*)queue->buf, queue->len, 0);
+    if (n == SOCKET_ERROR) {
+        return WSAGetLastError() == WSAEWOULDBLOCK ? queue->len : -1;
+    }
+    queue->len -= n;
+    memmove(queue->buf, queue->buf + n, queue->len);
+    return queue->len;
+}
+
+void TcpSendQueue_Free(TcpSendQueue* queue) {
+    free(queue->buf);
+    memset(queue, 0, sizeof(*queue));
+}
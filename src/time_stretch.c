@@ -0,0 +1,141 @@
+/**
+ * @file time_stretch.c
+ * @brief WSOLA 时间伸缩实现
+ *
+ * 以帧内固定位置 splice 为参考段 A = in[splice, splice + OVERLAP):
+ * - 加速: 在 lag ∈ [MIN_LAG, MAX_LAG] 中找 in[splice + lag, ...) 与 A 最相似的位置,
+ *         输出 in[0, splice) + 淡化(A -> B) + in[splice + lag + OVERLAP, end), 长度 in_len - lag
+ * - 减速: 同样搜索 lag, 输出 in[0, splice + lag) + 淡化(B -> A) + in[splice + OVERLAP, end),
+ *         即重复 [splice, splice + lag) 一段, 长度 in_len + lag
+ *
+ * 帧首尾样本保持不变, 因此与前后帧天然连续.
+ */
+
+#include "time_stretch.h"
+#include <math.h>
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 计算能量
+ */
+static int64_t energy(const int16_t* x, int len) {
+    int64_t sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += (int32_t)x[i] * x[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief 计算互相关
+ */
+static int64_t cross_correlation(const int16_t* x, const int16_t* y, int len) {
+    int64_t sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += (int32_t)x[i] * y[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief 搜索与参考段最相似的偏移
+ * @param ref 参考段 (长度 TSM_OVERLAP_SAMPLES)
+ * @param silent 输出: 参考段是否为静音
+ * @return 最佳 lag, <0 表示没有足够相似的位置
+ */
+static int find_best_lag(const int16_t* ref, bool* silent) {
+    int64_t ref_energy = energy(ref, TSM_OVERLAP_SAMPLES);
+
+    *silent = ref_energy < (int64_t)TSM_SILENCE_ENERGY * TSM_SILENCE_ENERGY * TSM_OVERLAP_SAMPLES;
+    if (*silent) {
+        return TSM_MAX_LAG_SAMPLES;  // 静音段: 直接取最大伸缩量
+    }
+
+    // 候选段能量用滑动窗口递推
+    const int16_t* cand = ref + TSM_MIN_LAG_SAMPLES;
+    int64_t cand_energy = energy(cand, TSM_OVERLAP_SAMPLES);
+
+    int best_lag = -1;
+    float best_score = TSM_MIN_CORRELATION;
+
+    for (int lag = TSM_MIN_LAG_SAMPLES; lag <= TSM_MAX_LAG_SAMPLES; lag++) {
+        const int16_t* seg = ref + lag;
+
+        if (lag > TSM_MIN_LAG_SAMPLES) {
+            int32_t out_s = seg[-1];
+            int32_t in_s = seg[TSM_OVERLAP_SAMPLES - 1];
+            cand_energy += in_s * in_s - out_s * out_s;
+        }
+
+        int64_t xc = cross_correlation(ref, seg, TSM_OVERLAP_SAMPLES);
+        if (xc <= 0 || cand_energy <= 0) continue;
+
+        float score = (float)((double)xc / sqrt((double)ref_energy * (double)cand_energy));
+        if (score > best_score) {
+            best_score = score;
+            best_lag = lag;
+        }
+    }
+
+    return best_lag;
+}
+
+/**
+ * @brief 线性交叉淡化: out = from * (1 - w) + to * w
+ */
+static void cross_fade(const int16_t* from, const int16_t* to, int16_t* out, int len) {
+    for (int i = 0; i < len; i++) {
+        int32_t w = (i << 15) / len;
+        int32_t v = (from[i] * (32768 - w) + to[i] * w) >> 15;
+        out[i] = (int16_t)v;
+    }
+}
+
+//=============================================================================
+// 公共接口实现
+//=============================================================================
+
+int TimeStretch_Process(TsmMode mode, const int16_t* in, int in_len,
+                        int16_t* out, int max_out) {
+    if (!in || !out || in_len <= 0 || max_out < in_len) {
+        return -1;
+    }
+
+    // 拼接点居中, 保证前后都留有完整的淡化区
+    int splice = (in_len - TSM_MAX_LAG_SAMPLES - TSM_OVERLAP_SAMPLES) / 2;
+
+    if (mode == TSM_NORMAL || splice < 0 ||
+        (mode == TSM_DECELERATE && max_out < in_len + TSM_MAX_LAG_SAMPLES)) {
+        memcpy(out, in, in_len * sizeof(int16_t));
+        return in_len;
+    }
+
+    bool silent;
+    int lag = find_best_lag(in + splice, &silent);
+    if (lag < 0) {
+        // 非平稳信号, 拼接会产生可闻失真: 本帧不处理
+        memcpy(out, in, in_len * sizeof(int16_t));
+        return in_len;
+    }
+
+    const int16_t* a = in + splice;         // 参考段
+    const int16_t* b = in + splice + lag;   // 匹配段
+
+    if (mode == TSM_ACCELERATE) {
+        memcpy(out, in, splice * sizeof(int16_t));
+        cross_fade(a, b, out + splice, TSM_OVERLAP_SAMPLES);
+        int tail = in_len - (splice + lag + TSM_OVERLAP_SAMPLES);
+        memcpy(out + splice + TSM_OVERLAP_SAMPLES, b + TSM_OVERLAP_SAMPLES, tail * sizeof(int16_t));
+        return in_len - lag;
+    }
+
+    // TSM_DECELERATE
+    memcpy(out, in, (splice + lag) * sizeof(int16_t));
+    cross_fade(b, a, out + splice + lag, TSM_OVERLAP_SAMPLES);
+    int tail = in_len - (splice + TSM_OVERLAP_SAMPLES);
+    memcpy(out + splice + lag + TSM_OVERLAP_SAMPLES, a + TSM_OVERLAP_SAMPLES, tail * sizeof(int16_t));
+    return in_len + lag;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file fanout_bench.c
+ * @brief UDP 一对多转发基准测试 (回环)
+ *
+ * 对 16 / 64 / 256 个回环收听者 (各自绑定一个不读取的 UDP socket, 接收缓冲满后
+ * 由协议栈丢弃) 反复转发同一个 RTP 包, 比较:
+ *   per-packet  原有路径: 每个目标调用一次 Network_SendRtpPacket (重新构造数据报 + sendto)
+ *   sendto      Network_SendRtpBatch 的退回路径: 数据报只构造一次, 逐个 sendto
+ *               (批量发送器建在未以 WSA_FLAG_REGISTERED_IO 创建的 socket 上)
+ *   rio         Network_SendRtpBatch: RIO_MSG_DEFER 排队后整批一次提交 (系统不支持 RIO 时不输出)
+ * 输出每秒数据报数与每个数据报的系统调用次数.
+ *
+ * 构建 (Windows, 不属于 SharedVoice 工程):
+ *   cl /O2 /Iinclude tools\fanout_bench.c src\network.c
+ *
+ * 用法:
+ *   fanout_bench [-t seconds] [-b payload_bytes]
+ */
+
+#include "common.h"
+#include "network.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define BENCH_DEFAULT_SECONDS   2           // 每组测试时长
+#define BENCH_DEFAULT_PAYLOAD   80          // 32kbps Opus 20ms 帧约 80 字节
+#define BENCH_MAX_RECIPIENTS    256
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 创建 count 个回环收听者
+ */
+static int open_recipients(SOCKET* socks, SOCKADDR_IN* addrs, int count) {
+    for (int i = 0; i < count; i++) {
+        socks[i] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (socks[i] == INVALID_SOCKET) return i;
+
+        int rcvbuf = 4096;
+        setsockopt(socks[i], SOL_SOCKET, SO_RCVBUF, (char*)&rcvbuf, sizeof(rcvbuf));
+
+        Network_MakeAddr(&addrs[i], "127.0.0.1", 0);
+        int len = sizeof(addrs[i]);
+        if (bind(socks[i], (SOCKADDR*)&addrs[i], sizeof(addrs[i])) == SOCKET_ERROR ||
+            getsockname(socks[i], (SOCKADDR*)&addrs[i], &len) == SOCKET_ERROR) {
+            closesocket(socks[i]);
+            return i;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 运行一组测试
+ * @param batch NULL 表示原有的逐个发送路径
+ */
+static void run(const char* label, SOCKET sock, UdpBatch* batch, const SOCKADDR_IN* addrs,
+                int count, int payload_len, int seconds) {
+    uint8_t payload[OPUS_MAX_PACKET];
+    memset(payload, 0x5A, sizeof(payload));
+
+    RtpHeader rtp;
+    RtpHeader_Init(&rtp, 1, PAYLOAD_OPUS);
+    rtp.payload_len = (uint16_t)payload_len;
+
+    UdpBatchStats before;
+    Network_GetUdpBatchStats(batch, &before);
+
+    uint64_t datagrams = 0;
+    uint64_t syscalls = 0;
+    uint64_t start = GetTimeUs();
+    uint64_t end = start + (uint64_t)seconds * 1000000;
+    uint64_t now = start;
+
+    while (now < end) {
+        // 每轮 64 次转发后再读时钟
+        for (int k = 0; k < 64; k++) {
+            rtp.sequence++;
+            rtp.timestamp += AUDIO_FRAME_SAMPLES;
+            if (batch) {
+                datagrams += Network_SendRtpBatch(batch, &rtp, payload, (uint16_t)payload_len,
+                                                  addrs, count);
+            } else {
+                for (int i = 0; i < count; i++) {
+                    if (Network_SendRtpPacket(sock, &rtp, payload, (uint16_t)payload_len,
+                                              &addrs[i]) > 0) {
+                        datagrams++;
+                    }
+                    syscalls++;
+                }
+            }
+        }
+        now = GetTimeUs();
+    }
+
+    uint32_t fallbacks = 0;
+    if (batch) {
+        UdpBatchStats after;
+        Network_GetUdpBatchStats(batch, &after);
+        syscalls = after.syscalls - before.syscalls;
+        fallbacks = after.fallbacks - before.fallbacks;
+    }
+
+    double elapsed = (double)(now - start) / 1000000.0;
+    printf("%10d %-12s %14.0f %16.3f %10u\n", count, label,
+           datagrams / elapsed, datagrams ? (double)syscalls / datagrams : 0.0, fallbacks);
+}
+
+//=============================================================================
+// 主函数
+//=============================================================================
+
+int main(int argc, char** argv) {
+    int seconds = BENCH_DEFAULT_SECONDS;
+    int payload_len = BENCH_DEFAULT_PAYLOAD;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-t") == 0) {
+            seconds = MAX(atoi(argv[i + 1]), 1);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            payload_len = CLAMP(atoi(argv[i + 1]), 1, OPUS_MAX_PACKET);
+        } else {
+            fprintf(stderr, "usage: fanout_bench [-t seconds] [-b payload_bytes]\n");
+            return 1;
+        }
+    }
+
+    if (!Network_Init()) return 1;
+
+    static SOCKET socks[BENCH_MAX_RECIPIENTS];
+    static SOCKADDR_IN addrs[BENCH_MAX_RECIPIENTS];
+    int opened = open_recipients(socks, addrs, BENCH_MAX_RECIPIENTS);
+    if (opened < BENCH_MAX_RECIPIENTS) {
+        fprintf(stderr, "only %d recipient sockets could be opened\n", opened);
+    }
+
+    // plain_sock 不支持 RIO, 其批量发送器总是逐个 sendto
+    SOCKET sock = Network_CreateUdpFanout(0, NULL);
+    SOCKET plain_sock = Network_CreateUdpAudio(0, NULL);
+    UdpBatch* batch = sock != INVALID_SOCKET ? Network_CreateUdpBatch(sock) : NULL;
+    UdpBatch* plain = plain_sock != INVALID_SOCKET ? Network_CreateUdpBatch(plain_sock) : NULL;
+    if (!batch || !plain) {
+        Network_Shutdown();
+        return 1;
+    }
+
+    UdpBatchStats info;
+    Network_GetUdpBatchStats(batch, &info);
+    printf("payload %d bytes, %d s per run, RIO %s\n\n", payload_len, seconds,
+           info.rio ? "available" : "unavailable");
+    printf("%10s %-12s %14s %16s %10s\n", "recipients", "path", "datagrams/s", "syscalls/dgram",
+           "fallbacks");
+
+    static const int sizes[] = { 16, 64, 256 };
+    for (int i = 0; i < (int)ARRAY_SIZE(sizes); i++) {
+        int count = MIN(sizes[i], opened);
+        run("per-packet", sock, NULL, addrs, count, payload_len, seconds);
+        run("sendto", plain_sock, plain, addrs, count, payload_len, seconds);
+        if (info.rio) {
+            run("rio", sock, batch, addrs, count, payload_len, seconds);
+        }
+    }
+
+    Network_CloseSocket(sock);
+    Network_CloseSocket(plain_sock);
+    Network_DestroyUdpBatch(batch);
+    Network_DestroyUdpBatch(plain);
+    for (int i = 0; i < opened; i++) {
+        closesocket(socks[i]);
+    }
+    Network_Shutdown();
+    return 0;
+}
@@ -0,0 +1,510 @@
+/**
+ * @file jitter_bench.c
+ * @brief 抖动缓冲收包 (Put) 争用基准测试
+ *
+ * 一个生产者线程 (相当于 UDP 接收线程) 每 -i 微秒 Put 一个包,
+ * 一个消费者线程 (相当于播放线程) 在缓冲中有数据时 Get 一帧,
+ * 解码器回调忙等 -d 微秒模拟 Opus 解码. 分别以加锁模式 (Get 持锁解码时 Put 等待)
+ * 与无锁模式 (JitterConfig.lock_free) 运行, 输出单次 Put 耗时的
+ * P50 / P99 / P99.9 / 最大值 (微秒).
+ *
+ * 包的接收时间与时钟回调使用虚拟时间 (每包 AUDIO_FRAME_MS), 抖动缓冲看到的是
+ * 理想的 20ms 节奏, 实际运行速度由 -i 决定.
+ * 单核机器上两个线程轮流运行, 测到的主要是调度而非锁争用, 结果应在多核上比较.
+ *
+ * 开始前先做两项检查, 失败时退出码为 2:
+ * - 默认配置能否收下最长的包 (JB_MAX_FRAME_SAMPLES, 按 OPUS_BITRATE 计)
+ * - 混合包长 (20/60ms 持续流; 收缩丢帧后 80ms 之后跟 120ms) 与任意大小取数据时,
+ *   每包都以不小于包长的缓冲解码, 不出现 PLC / 舒适噪声
+ * - 自适应目标延迟已增大时, 重新同步后的新讲话段在第一次取帧就开始播放
+ *
+ * 构建 (不属于 SharedVoice 工程):
+ *   Linux:   gcc -std=gnu11 -O2 -Iinclude -o jitter_bench tools/jitter_bench.c
+ *                src/jitter_buffer.c src/time_stretch.c src/resampler.c -lpthread -lm
+ *   Windows: cl /O2 /Iinclude tools\jitter_bench.c src\jitter_buffer.c
+ *                src\time_stretch.c src\resampler.c
+ *
+ * 用法:
+ *   jitter_bench [-n packets] [-i interval_us] [-d decode_us]
+ */
+
+#include "common.h"
+#include "jitter_buffer.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define BENCH_DEFAULT_PACKETS   5000
+#define BENCH_DEFAULT_INTERVAL  1000        // 生产者发包间隔 (微秒)
+#define BENCH_DEFAULT_DECODE    100         // 模拟解码耗时 (微秒)
+#define BENCH_PAYLOAD_LEN       80
+#define BENCH_PREFILL           3           // 消费者开始取帧前缓冲的包数
+#define BENCH_SSRC              1234
+#define BENCH_MIXED_PULLS       2000        // 混合包长检查: 持续流的取数据次数
+#define BENCH_RESYNC_PACKETS    250         // 重新同步检查: 建立目标延迟的包数
+#define BENCH_RESYNC_LATE_MS    150         // 重新同步检查: 每隔一包的额外到达延迟
+#define BENCH_MIXED_UNIT        (AUDIO_SAMPLE_RATE / 100)   // 混合包长负载首字节的单位 (10ms)
+
+//=============================================================================
+// 全局变量
+//=============================================================================
+static JitterBuffer* g_jb = NULL;
+static AtomicInt     g_produced = 0;
+static AtomicInt     g_done = 0;
+static int           g_packets = BENCH_DEFAULT_PACKETS;
+static int           g_interval_us = BENCH_DEFAULT_INTERVAL;
+static int           g_decode_us = BENCH_DEFAULT_DECODE;
+static uint32_t*     g_costs_ns = NULL;
+static int           g_short_decodes = 0;   // 混合包长检查: 输出缓冲小于包长的解码次数
+static int           g_mixed_decodes = 0;   // 混合包长检查: 成功解码次数
+
+//=============================================================================
+// 计时 / 线程
+//=============================================================================
+
+#ifdef _WIN32
+static uint64_t now_ns(void) {
+    LARGE_INTEGER counter, freq;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&freq);
+    return (uint64_t)(counter.QuadPart / freq.QuadPart * 1000000000 +
+                      counter.QuadPart % freq.QuadPart * 1000000000 / freq.QuadPart);
+}
+
+static void sleep_us(int us) {
+    Sleep(MAX(us / 1000, 1));
+}
+
+typedef HANDLE BenchThread;
+#define BENCH_THREAD_PROC(name) static DWORD WINAPI name(LPVOID param)
+#define BENCH_THREAD_RETURN     return 0
+
+static void bench_start(BenchThread* t, DWORD (WINAPI *proc)(LPVOID)) {
+    ThreadCreate(t, proc, NULL);
+}
+
+static void bench_join(BenchThread t) {
+    ThreadJoin(t);
+    ThreadClose(t);
+}
+#else
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleep_us(int us) {
+    struct timespec ts = { us / 1000000, (long)(us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+typedef pthread_t BenchThread;
+#define BENCH_THREAD_PROC(name) static void* name(void* param)
+#define BENCH_THREAD_RETURN     return NULL
+
+static void bench_start(BenchThread* t, void* (*proc)(void*)) {
+    pthread_create(t, NULL, proc, NULL);
+}
+
+static void bench_join(BenchThread t) {
+    pthread_join(t, NULL);
+}
+#endif
+
+//=============================================================================
+// 抖动缓冲回调
+//=============================================================================
+
+static uint64_t bench_clock(void* ctx) {
+    (void)ctx;
+    return (uint64_t)AtomicRead(&g_produced) * AUDIO_FRAME_MS * 1000;
+}
+
+static int bench_packet_samples(const uint8_t* data, int len) {
+    (void)data;
+    (void)len;
+    return AUDIO_FRAME_SAMPLES;
+}
+
+static int bench_long_packet_samples(const uint8_t* data, int len) {
+    (void)data;
+    (void)len;
+    return JB_MAX_FRAME_SAMPLES;
+}
+
+/**
+ * @brief 忙等 g_decode_us 微秒, 输出静音
+ */
+static int bench_decode(void* decoder, const uint8_t* data, int len,
+                        int16_t* pcm, int frame_size, int decode_fec) {
+    (void)decoder;
+    (void)data;
+    (void)len;
+    (void)decode_fec;
+    uint64_t end = now_ns() + (uint64_t)g_decode_us * 1000;
+    while (now_ns() < end) {
+    }
+    int n = MIN(frame_size, AUDIO_FRAME_SAMPLES);
+    memset(pcm, 0, n * sizeof(int16_t));
+    return n;
+}
+
+static int bench_mixed_packet_samples(const uint8_t* data, int len) {
+    return len > 0 ? data[0] * BENCH_MIXED_UNIT : -1;
+}
+
+/**
+ * @brief 与 Opus 一致: 输出缓冲小于包长时解码失败
+ */
+static int bench_mixed_decode(void* decoder, const uint8_t* data, int len,
+                              int16_t* pcm, int frame_size, int decode_fec) {
+    (void)decoder;
+    (void)decode_fec;
+    int n = bench_mixed_packet_samples(data, len);
+    if (n > frame_size) {
+        g_short_decodes++;
+        return -1;
+    }
+    memset(pcm, 0, n * sizeof(int16_t));
+    g_mixed_decodes++;
+    return n;
+}
+
+static int bench_plc(void* decoder, int16_t* pcm, int frame_size) {
+    (void)decoder;
+    memset(pcm, 0, frame_size * sizeof(int16_t));
+    return frame_size;
+}
+
+//=============================================================================
+// 生产者 / 消费者
+//=============================================================================
+
+BENCH_THREAD_PROC(producer_proc) {
+    (void)param;
+    uint8_t payload[BENCH_PAYLOAD_LEN];
+    memset(payload, 0x5A, sizeof(payload));
+
+    RtpHeader rtp;
+    RtpHeader_Init(&rtp, BENCH_SSRC, PAYLOAD_OPUS);
+    RtpHeader_SetVadActive(&rtp, true);
+
+    uint64_t next = now_ns();
+    for (int i = 0; i < g_packets; i++) {
+        rtp.sequence = (uint16_t)i;
+        rtp.timestamp = (uint32_t)i * AUDIO_FRAME_SAMPLES;
+        rtp.payload_len = BENCH_PAYLOAD_LEN;
+
+        uint64_t recv_us = (uint64_t)i * AUDIO_FRAME_MS * 1000;
+        uint64_t t0 = now_ns();
+        JitterBuffer_Put(g_jb, &rtp, payload, BENCH_PAYLOAD_LEN, recv_us);
+        g_costs_ns[i] = (uint32_t)MIN(now_ns() - t0, UINT32_MAX);
+        AtomicInc(&g_produced);
+
+        next += (uint64_t)g_interval_us * 1000;
+        uint64_t now = now_ns();
+        if (next > now) sleep_us((int)((next - now) / 1000));
+    }
+
+    AtomicSet(&g_done, 1);
+    BENCH_THREAD_RETURN;
+}
+
+BENCH_THREAD_PROC(consumer_proc) {
+    (void)param;
+    int16_t pcm[AUDIO_FRAME_SAMPLES];
+    int pulled = 0;
+
+    while (!AtomicRead(&g_done)) {
+        if (AtomicRead(&g_produced) > pulled + BENCH_PREFILL) {
+            JitterBuffer_Get(g_jb, pcm, AUDIO_FRAME_SAMPLES);
+            pulled++;
+        } else {
+            sleep_us(g_interval_us / 4);
+        }
+    }
+    BENCH_THREAD_RETURN;
+}
+
+//=============================================================================
+// 主函数
+//=============================================================================
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run(bool lock_free) {
+    JitterConfig config;
+    JitterBuffer_GetDefaultConfig(&config);
+    config.lock_free = lock_free;
+
+    g_jb = JitterBuffer_Create(&config);
+    if (!g_jb) return;
+    JitterBuffer_SetClock(g_jb, bench_clock, NULL);
+    JitterBuffer_SetDecoder(g_jb, (void*)&g_decode_us, bench_decode);     // 句柄不使用, 只需非空
+    JitterBuffer_SetPlc(g_jb, bench_plc);
+    JitterBuffer_SetPacketSamples(g_jb, bench_packet_samples);
+
+    AtomicSet(&g_produced, 0);
+    AtomicSet(&g_done, 0);
+
+    BenchThread consumer, producer;
+    bench_start(&consumer, consumer_proc);
+    bench_start(&producer, producer_proc);
+    bench_join(producer);
+    bench_join(consumer);
+
+    JitterStats stats;
+    JitterBuffer_GetStats(g_jb, &stats);
+    JitterBuffer_Destroy(g_jb);
+    g_jb = NULL;
+
+    qsort(g_costs_ns, g_packets, sizeof(uint32_t), compare_u32);
+    printf("%-10s %8.2f %8.2f %8.2f %8.2f %8u\n",
+           lock_free ? "lock-free" : "locked",
+           g_costs_ns[g_packets / 2] / 1000.0,
+           g_costs_ns[(int)((g_packets - 1) * 0.99)] / 1000.0,
+           g_costs_ns[(int)((g_packets - 1) * 0.999)] / 1000.0,
+           g_costs_ns[g_packets - 1] / 1000.0,
+           stats.overruns);
+}
+
+/**
+ * @brief 默认配置 (加锁 / 无锁) 须能收下 OPUS_BITRATE 下最长一包
+ */
+static bool check_long_packet(void) {
+    int len = OPUS_BITRATE / 8 * JB_MAX_FRAME_SAMPLES / AUDIO_SAMPLE_RATE;
+    uint8_t* payload = (uint8_t*)calloc(1, len);
+    if (!payload) return false;
+
+    RtpHeader rtp;
+    RtpHeader_Init(&rtp, BENCH_SSRC, PAYLOAD_OPUS);
+    RtpHeader_SetVadActive(&rtp, true);
+    rtp.payload_len = (uint16_t)len;
+
+    bool ok = true;
+    for (int lock_free = 0; lock_free <= 1; lock_free++) {
+        JitterConfig config;
+        JitterBuffer_GetDefaultConfig(&config);
+        config.lock_free = lock_free != 0;
+
+        JitterBuffer* jb = JitterBuffer_Create(&config);
+        if (!jb) {
+            ok = false;
+            break;
+        }
+        JitterBuffer_SetPacketSamples(jb, bench_long_packet_samples);
+        int ret = JitterBuffer_Put(jb, &rtp, payload, (uint16_t)len, 1);
+        JitterBuffer_Destroy(jb);
+        if (ret != 0) {
+            fprintf(stderr, "%s: %d ms packet of %d bytes rejected (%d)\n",
+                    lock_free ? "lock-free" : "locked",
+                    JB_MAX_FRAME_SAMPLES * 1000 / AUDIO_SAMPLE_RATE, len, ret);
+            ok = false;
+        }
+    }
+
+    free(payload);
+    return ok;
+}
+
+/**
+ * @brief 创建混合包长检查用的抖动缓冲 (加锁, 固定目标延迟, 无漂移补偿)
+ */
+static JitterBuffer* create_mixed(uint32_t target_ms) {
+    JitterConfig config;
+    JitterBuffer_GetDefaultConfig(&config);
+    config.adaptive = false;
+    config.target_delay_ms = target_ms;
+    config.lock_free = false;
+    config.drift_compensation = false;
+
+    JitterBuffer* jb = JitterBuffer_Create(&config);
+    if (!jb) return NULL;
+    JitterBuffer_SetDecoder(jb, (void*)&g_decode_us, bench_mixed_decode);  // 句柄不使用, 只需非空
+    JitterBuffer_SetPlc(jb, bench_plc);
+    JitterBuffer_SetPacketSamples(jb, bench_mixed_packet_samples);
+    return jb;
+}
+
+/**
+ * @brief 放入一个混合包长检查用的包 (负载首字节为包长, 单位 10ms)
+ */
+static void put_mixed(JitterBuffer* jb, uint16_t sequence, uint32_t* timestamp, uint8_t units) {
+    uint8_t payload[BENCH_PAYLOAD_LEN];
+    memset(payload, 0x5A, sizeof(payload));
+    payload[0] = units;
+
+    RtpHeader rtp;
+    RtpHeader_Init(&rtp, BENCH_SSRC, PAYLOAD_OPUS);
+    RtpHeader_SetVadActive(&rtp, true);
+    rtp.sequence = sequence;
+    rtp.timestamp = *timestamp;
+    rtp.payload_len = BENCH_PAYLOAD_LEN;
+    JitterBuffer_Put(jb, &rtp, payload, BENCH_PAYLOAD_LEN, 1);
+    *timestamp += units * BENCH_MIXED_UNIT;
+}
+
+/**
+ * @brief 混合包长检查: 每包都以不小于包长的缓冲解码, 不出现 PLC / 舒适噪声
+ * 
+ * 1. 20/60ms 交替的持续流, 每次取 5/10ms, 缓冲级别维持在目标附近
+ * 2. 收缩丢帧: 10ms 前缀使收缩计数达到 JB_SHRINK_HOLD 时 head 恰为 80ms 包,
+ *    其后是 120ms 包; 首次取数据大小以 1ms 步长扫描, 使丢帧落在调用者缓冲的
+ *    各个位置, 之后每次取 100ms. 丢帧后的 120ms 包不能解码进剩余的 80-120ms.
+ */
+static bool check_mixed_durations(void) {
+    static const uint8_t stream_units[] = { 2, 6, 2, 2, 6 };
+    static const int stream_pulls[] = { 240, 480 };
+    static const uint8_t shrink_units[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 8, 12, 4 };
+
+    int16_t pcm[AUDIO_SAMPLE_RATE / 10];
+    int concealed = 0, comfort_noise = 0;
+    g_short_decodes = 0;
+
+    JitterBuffer* jb = create_mixed(JITTER_BUFFER_MS);
+    if (!jb) return false;
+    uint32_t timestamp = 0;
+    uint16_t sequence = 0;
+    for (int i = 0; i < BENCH_MIXED_PULLS; i++) {
+        while (JitterBuffer_GetLevel(jb) < JITTER_BUFFER_MS) {
+            put_mixed(jb, sequence, &timestamp, stream_units[sequence % ARRAY_SIZE(stream_units)]);
+            sequence++;
+        }
+        JitterBuffer_Get(jb, pcm, stream_pulls[i % ARRAY_SIZE(stream_pulls)]);
+    }
+    JitterStats stats;
+    JitterBuffer_GetStats(jb, &stats);
+    JitterBuffer_Destroy(jb);
+    concealed += stats.packets_concealed;
+    comfort_noise += stats.frames_comfort_noise;
+
+    // 级别 240ms (80 + 120 + 40) 高于 目标 + JB_SHRINK_MARGIN_MS, 扣除 80ms head 后仍在加速死区内
+    uint32_t target_ms = 120;
+    for (int first = BENCH_MIXED_UNIT / 10; first <= (int)ARRAY_SIZE(pcm); first += BENCH_MIXED_UNIT / 10) {
+        jb = create_mixed(target_ms);
+        if (!jb) return false;
+        timestamp = 0;
+        for (int i = 0; i < (int)ARRAY_SIZE(shrink_units); i++) {
+            put_mixed(jb, (uint16_t)i, &timestamp, shrink_units[i]);
+        }
+        JitterBuffer_Get(jb, pcm, first);
+        while (JitterBuffer_GetLevel(jb) > 0) {
+            JitterBuffer_Get(jb, pcm, ARRAY_SIZE(pcm));
+        }
+        JitterBuffer_GetStats(jb, &stats);
+        JitterBuffer_Destroy(jb);
+        concealed += stats.packets_concealed;
+        comfort_noise += stats.frames_comfort_noise;
+    }
+
+    bool ok = g_short_decodes == 0 && concealed == 0 && comfort_noise == 0;
+    if (!ok) {
+        fprintf(stderr, "mixed durations: %d short decodes, %d concealed, %d comfort noise\n",
+                g_short_decodes, concealed, comfort_noise);
+    }
+    return ok;
+}
+
+/**
+ * @brief 重新同步检查: 新讲话段以最小延迟开始, 第一次取帧即输出解码音频
+ * 
+ * 一半包晚到 BENCH_RESYNC_LATE_MS, 使自适应目标延迟远大于一帧; 取空缓冲后
+ * 发送带 marker 且时间戳跳过 2 * JB_RESYNC_GAP_MS 的 20ms 包, 放入后立即取一帧.
+ */
+static bool check_resync(void) {
+    JitterConfig config;
+    JitterBuffer_GetDefaultConfig(&config);
+    config.lock_free = false;
+    config.drift_compensation = false;
+
+    JitterBuffer* jb = JitterBuffer_Create(&config);
+    if (!jb) return false;
+    JitterBuffer_SetDecoder(jb, (void*)&g_decode_us, bench_mixed_decode);  // 句柄不使用, 只需非空
+    JitterBuffer_SetPlc(jb, bench_plc);
+    JitterBuffer_SetPacketSamples(jb, bench_mixed_packet_samples);
+
+    uint8_t payload[BENCH_PAYLOAD_LEN];
+    memset(payload, 0x5A, sizeof(payload));
+    payload[0] = AUDIO_FRAME_SAMPLES / BENCH_MIXED_UNIT;
+
+    RtpHeader rtp;
+    RtpHeader_Init(&rtp, BENCH_SSRC, PAYLOAD_OPUS);
+    RtpHeader_SetVadActive(&rtp, true);
+    rtp.payload_len = BENCH_PAYLOAD_LEN;
+
+    int16_t pcm[AUDIO_FRAME_SAMPLES];
+    uint64_t recv_us = 1;
+    for (int i = 0; i < BENCH_RESYNC_PACKETS; i++) {
+        rtp.sequence = (uint16_t)i;
+        rtp.timestamp = (uint32_t)i * AUDIO_FRAME_SAMPLES;
+        recv_us = 1 + (uint64_t)i * AUDIO_FRAME_MS * 1000 + (i % 2 ? BENCH_RESYNC_LATE_MS * 1000 : 0);
+        JitterBuffer_Put(jb, &rtp, payload, BENCH_PAYLOAD_LEN, recv_us);
+        JitterBuffer_Get(jb, pcm, AUDIO_FRAME_SAMPLES);
+    }
+    for (int i = 0; i < JITTER_BUFFER_SLOTS * 4 && JitterBuffer_Get(jb, pcm, AUDIO_FRAME_SAMPLES) > 0; i++) {
+    }
+
+    JitterStats before, after;
+    JitterBuffer_GetStats(jb, &before);
+
+    // 新讲话段
+    RtpHeader_SetMarker(&rtp, true);
+    rtp.sequence = BENCH_RESYNC_PACKETS;
+    rtp.timestamp += 2 * JB_RESYNC_GAP_MS * (AUDIO_SAMPLE_RATE / 1000);
+    JitterBuffer_Put(jb, &rtp, payload, BENCH_PAYLOAD_LEN, recv_us + 2 * JB_RESYNC_GAP_MS * 1000);
+
+    int decodes = g_mixed_decodes;
+    int n = JitterBuffer_Get(jb, pcm, AUDIO_FRAME_SAMPLES);
+    JitterBuffer_GetStats(jb, &after);
+    JitterBuffer_Destroy(jb);
+
+    bool ok = before.target_delay_ms >= 2 * JITTER_MIN_MS && after.resyncs == before.resyncs + 1 &&
+              n == AUDIO_FRAME_SAMPLES && g_mixed_decodes == decodes + 1;
+    if (!ok) {
+        fprintf(stderr, "resync: target %u ms, %u -> %u resyncs, first pull %d samples, %d decodes\n",
+                before.target_delay_ms, before.resyncs, after.resyncs, n, g_mixed_decodes - decodes);
+    }
+    return ok;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: jitter_bench [-n packets] [-i interval_us] [-d decode_us]\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        int value = atoi(argv[++i]);
+        if (strcmp(argv[i - 1], "-n") == 0) {
+            g_packets = MAX(value, 1);
+        } else if (strcmp(argv[i - 1], "-i") == 0) {
+            g_interval_us = MAX(value, 1);
+        } else if (strcmp(argv[i - 1], "-d") == 0) {
+            g_decode_us = MAX(value, 0);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!check_long_packet() || !check_mixed_durations() || !check_resync()) return 2;
+
+    g_costs_ns = (uint32_t*)malloc(g_packets * sizeof(uint32_t));
+    if (!g_costs_ns) return 1;
+
+    printf("%d packets, put every %d us, decode %d us\n\n", g_packets, g_interval_us, g_decode_us);
+    printf("%-10s %8s %8s %8s %8s %8s\n", "mode", "p50(us)", "p99", "p99.9", "max", "overruns");
+
+    run(false);
+    run(true);
+
+    free(g_costs_ns);
+    return 0;
+}
@@ -0,0 +1,467 @@
+/**
+ * @file jitter_replay.c
+ * @brief 抖动缓冲离线回放工具
+ *
+ * 读取客户端以 --jitter-trace 录制的到达轨迹, 用虚拟时钟按录制的到达时间
+ * 把包送入 JitterBuffer, 并每 AUDIO_FRAME_MS 取一次帧, 快于实时运行且结果可复现.
+ * 对多组 JitterConfig 逐一回放, 输出:
+ * - 端到端附加延迟 (相对最小传输时延的网络排队 + 缓冲延迟) 平均值 / P95
+ * - 迟到丢包率 (packets_late / 收到的包)
+ * - 补偿率 (PLC 补偿的包 / 应播放的包), 欠载次数, 舒适噪声帧数
+ * - 时间伸缩 / 丢弃的帧数, 估计的发送端时钟漂移 (各流中偏差最大者)
+ * - 每秒音频的 CPU 耗时 (Put + Get, 不含 Opus 解码)
+ *
+ * 解码器用固定音调代替, 使时间伸缩走与真实语音相同的相关搜索路径.
+ * 包时长取录制时由 Opus TOC 解析的值, 以 [uint16 采样数][原始负载] 的形式
+ * 交给 JitterBuffer, 回放端不依赖 Opus 库.
+ *
+ * 构建 (不属于 SharedVoice 工程):
+ *   Linux:   gcc -std=gnu11 -O2 -Iinclude -o jitter_replay tools/jitter_replay.c
+ *                src/jitter_buffer.c src/time_stretch.c src/resampler.c src/jitter_trace.c
+ *                -lpthread -lm
+ *   Windows: cl /O2 /Iinclude tools\jitter_replay.c src\jitter_buffer.c
+ *                src\time_stretch.c src\resampler.c src\jitter_trace.c
+ *
+ * 用法:
+ *   jitter_replay <trace> [-m min_ms] [-M max_ms] [-d 0|1] [-c a:<late_loss> | -c f:<delay_ms>]...
+ *   -d 0 关闭时钟漂移补偿.
+ *   未指定 -c 时回放默认的一组自适应 / 固定延迟配置.
+ */
+
+#include "common.h"
+#include "jitter_buffer.h"
+#include "jitter_trace.h"
+#include <math.h>
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define REPLAY_MAX_CONFIGS      16
+#define REPLAY_MAX_SSRCS        MAX_SESSIONS
+#define REPLAY_FRAME_HDR        2                   // 回放负载前缀: 包时长
+#define REPLAY_TONE_HZ          220.0
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+/**
+ * @brief 内存中的一条记录
+ */
+typedef struct {
+    JitterTraceRecord rec;
+    uint32_t          payload_off;  // 在负载池中的偏移
+} ReplayPacket;
+
+/**
+ * @brief 一组待回放的配置
+ */
+typedef struct {
+    char         name[32];
+    JitterConfig config;
+} ReplayConfig;
+
+/**
+ * @brief 回放结果 (所有 SSRC 累计)
+ */
+typedef struct {
+    uint32_t packets;           // 送入的包数
+    uint32_t late;              // 迟到丢弃
+    uint32_t lost;              // 丢包 (恢复 + 补偿)
+    uint32_t concealed;         // PLC 补偿
+    uint32_t underruns;         // 缓冲区空
+    uint32_t comfort_noise;     // DTX 舒适噪声帧
+    uint32_t resyncs;
+    uint32_t stretched;         // 加速 + 减速帧
+    uint32_t dropped;           // 为降低延迟丢弃的帧
+    float    drift_ppm;         // 漂移补偿量 (偏差最大的流)
+    uint64_t audio_ms;          // 播放的音频时长
+    uint64_t cpu_us;            // Put + Get 耗时
+
+    float*   delays;            // 每包附加延迟 (毫秒)
+    uint32_t delay_count;
+} ReplayResult;
+
+//=============================================================================
+// 全局变量
+//=============================================================================
+static ReplayPacket* g_packets = NULL;
+static uint32_t      g_packet_count = 0;
+static uint8_t*      g_payloads = NULL;
+static uint32_t      g_sample_rate = AUDIO_SAMPLE_RATE;
+
+static uint64_t      g_virtual_us = 0;              // 虚拟时钟 (微秒)
+
+//=============================================================================
+// 回放用的解码器 / 时钟
+//=============================================================================
+
+static uint64_t replay_clock(void* ctx) {
+    (void)ctx;
+    return g_virtual_us;
+}
+
+static int replay_packet_samples(const uint8_t* data, int len) {
+    if (len < REPLAY_FRAME_HDR) return -1;
+    int samples = data[0] | (data[1] << 8);
+    return samples > 0 ? samples : -1;
+}
+
+/**
+ * @brief 以固定音调代替解码输出, 保证时间伸缩有可匹配的周期
+ */
+static void fill_tone(int16_t* pcm, int count) {
+    static double phase = 0.0;
+    double step = 2.0 * 3.14159265358979 * REPLAY_TONE_HZ / AUDIO_SAMPLE_RATE;
+    for (int i = 0; i < count; i++) {
+        pcm[i] = (int16_t)(8000.0 * sin(phase));
+        phase += step;
+    }
+    phase = fmod(phase, 2.0 * 3.14159265358979);
+}
+
+static int replay_decode(void* decoder, const uint8_t* data, int len,
+                         int16_t* pcm, int frame_size, int decode_fec) {
+    (void)decoder;
+    (void)decode_fec;
+    int samples = replay_packet_samples(data, len);
+    if (samples <= 0 || samples > frame_size) return -1;
+    fill_tone(pcm, samples);
+    return samples;
+}
+
+static int replay_plc(void* decoder, int16_t* pcm, int frame_size) {
+    (void)decoder;
+    memset(pcm, 0, frame_size * sizeof(int16_t));
+    return frame_size;
+}
+
+//=============================================================================
+// 轨迹加载
+//=============================================================================
+
+static bool load_trace(const char* path) {
+    JitterTrace* trace = JitterTrace_Open(path);
+    if (!trace) return false;
+
+    uint32_t cap = 4096;
+    size_t pool_cap = (size_t)cap * 128, pool_used = 0;
+    g_packets = (ReplayPacket*)malloc(cap * sizeof(ReplayPacket));
+    g_payloads = (uint8_t*)malloc(pool_cap);
+    if (!g_packets || !g_payloads) {
+        JitterTrace_Close(trace);
+        return false;
+    }
+
+    uint8_t payload[OPUS_MAX_PACKET];
+    JitterTraceRecord rec;
+    while (JitterTrace_Read(trace, &rec, payload, sizeof(payload))) {
+        if (g_packet_count == cap) {
+            cap *= 2;
+            ReplayPacket* p = (ReplayPacket*)realloc(g_packets, cap * sizeof(ReplayPacket));
+            if (!p) break;
+            g_packets = p;
+        }
+        if (pool_used + REPLAY_FRAME_HDR + rec.payload_len > pool_cap) {
+            pool_cap *= 2;
+            uint8_t* p = (uint8_t*)realloc(g_payloads, pool_cap);
+            if (!p) break;
+            g_payloads = p;
+        }
+
+        // 未知时长按一帧计
+        uint16_t samples = rec.samples ? rec.samples : AUDIO_FRAME_SAMPLES;
+        uint8_t* dst = g_payloads + pool_used;
+        dst[0] = (uint8_t)(samples & 0xFF);
+        dst[1] = (uint8_t)(samples >> 8);
+        memcpy(dst + REPLAY_FRAME_HDR, payload, rec.payload_len);
+
+        g_packets[g_packet_count].rec = rec;
+        g_packets[g_packet_count].payload_off = (uint32_t)pool_used;
+        g_packet_count++;
+        pool_used += REPLAY_FRAME_HDR + rec.payload_len;
+    }
+
+    JitterTrace_Close(trace);
+    return g_packet_count > 0;
+}
+
+//=============================================================================
+// 回放
+//=============================================================================
+
+/**
+ * @brief 按到达顺序回放单个 SSRC
+ */
+static void replay_ssrc(const ReplayConfig* rc, uint32_t ssrc, ReplayResult* res) {
+    // 最小传输时延 (接收时间 - 发送时间戳), 时间戳按 32 位回绕展开
+    int64_t min_transit = INT64_MAX;
+    int64_t ts_base = 0;
+    uint32_t last_ts = 0;
+    bool first = true;
+    for (uint32_t i = 0; i < g_packet_count; i++) {
+        const JitterTraceRecord* r = &g_packets[i].rec;
+        if (r->ssrc != ssrc) continue;
+        if (!first) ts_base += (int32_t)(r->timestamp - last_ts);
+        first = false;
+        last_ts = r->timestamp;
+        int64_t transit = (int64_t)r->recv_time_us - ts_base * 1000000 / g_sample_rate;
+        min_transit = MIN(min_transit, transit);
+    }
+
+    JitterConfig config = rc->config;
+    config.lock_free = false;   // Put 后立即可见, 便于采样缓冲级别
+    config.max_payload = OPUS_MAX_PACKET + REPLAY_FRAME_HDR;
+
+    JitterBuffer* jb = JitterBuffer_Create(&config);
+    if (!jb) return;
+    JitterBuffer_SetClock(jb, replay_clock, NULL);
+    JitterBuffer_SetDecoder(jb, (void*)&g_sample_rate, replay_decode);  // 句柄不使用, 只需非空
+    JitterBuffer_SetPlc(jb, replay_plc);
+    JitterBuffer_SetPacketSamples(jb, replay_packet_samples);
+
+    int16_t pcm[AUDIO_FRAME_SAMPLES];
+    uint64_t next_pull_us = 0;
+    uint64_t last_recv_us = 0;
+    bool started = false;
+
+    ts_base = 0;
+    first = true;
+    for (uint32_t i = 0; i < g_packet_count; i++) {
+        const ReplayPacket* p = &g_packets[i];
+        const JitterTraceRecord* r = &p->rec;
+        if (r->ssrc != ssrc) continue;
+
+        if (!started) {
+            next_pull_us = r->recv_time_us;
+            started = true;
+        }
+
+        // 先完成这个包到达之前的所有播放
+        while (next_pull_us <= r->recv_time_us) {
+            g_virtual_us = next_pull_us;
+            uint64_t t0 = GetTimeUs();
+            JitterBuffer_Get(jb, pcm, AUDIO_FRAME_SAMPLES);
+            res->cpu_us += GetTimeUs() - t0;
+            res->audio_ms += AUDIO_FRAME_MS;
+            next_pull_us += AUDIO_FRAME_MS * 1000;
+        }
+
+        if (!first) ts_base += (int32_t)(r->timestamp - last_ts);
+        first = false;
+        last_ts = r->timestamp;
+
+        RtpHeader rtp = {0};
+        rtp.version = 2;
+        rtp.payload_type = PAYLOAD_OPUS;
+        rtp.sequence = r->sequence;
+        rtp.timestamp = r->timestamp;
+        rtp.ssrc = r->ssrc;
+        rtp.flags = r->flags;
+        rtp.payload_len = r->payload_len + REPLAY_FRAME_HDR;
+
+        JitterStats before;
+        JitterBuffer_GetStats(jb, &before);
+
+        g_virtual_us = r->recv_time_us;
+        uint64_t t0 = GetTimeUs();
+        JitterBuffer_Put(jb, &rtp, g_payloads + p->payload_off, rtp.payload_len, r->recv_time_us);
+        res->cpu_us += GetTimeUs() - t0;
+        res->packets++;
+        last_recv_us = r->recv_time_us;
+
+        JitterStats after;
+        JitterBuffer_GetStats(jb, &after);
+        if (after.packets_late != before.packets_late) continue;
+
+        // 附加延迟 = 网络排队 + 包首样本在缓冲中的等待时间
+        int samples = r->samples ? r->samples : AUDIO_FRAME_SAMPLES;
+        int64_t transit = (int64_t)r->recv_time_us - ts_base * 1000000 / g_sample_rate;
+        float queue_ms = (float)(transit - min_transit) / 1000.0f;
+        float buffer_ms = (float)JitterBuffer_GetLevel(jb) - samples * 1000.0f / AUDIO_SAMPLE_RATE;
+        res->delays[res->delay_count++] = queue_ms + MAX(buffer_ms, 0.0f);
+    }
+
+    // 排空缓冲
+    while (next_pull_us <= last_recv_us + (uint64_t)config.max_delay_ms * 1000 &&
+           JitterBuffer_GetLevel(jb) > 0) {
+        g_virtual_us = next_pull_us;
+        uint64_t t0 = GetTimeUs();
+        JitterBuffer_Get(jb, pcm, AUDIO_FRAME_SAMPLES);
+        res->cpu_us += GetTimeUs() - t0;
+        res->audio_ms += AUDIO_FRAME_MS;
+        next_pull_us += AUDIO_FRAME_MS * 1000;
+    }
+
+    JitterStats stats;
+    JitterBuffer_GetStats(jb, &stats);
+    res->late += stats.packets_late;
+    res->lost += stats.packets_lost;
+    res->concealed += stats.packets_concealed;
+    res->underruns += stats.underruns;
+    res->comfort_noise += stats.frames_comfort_noise;
+    res->resyncs += stats.resyncs;
+    res->stretched += stats.frames_accelerated + stats.frames_decelerated;
+    res->dropped += stats.frames_dropped;
+    if (fabsf(stats.drift_ppm) > fabsf(res->drift_ppm)) {
+        res->drift_ppm = stats.drift_ppm;
+    }
+
+    JitterBuffer_Destroy(jb);
+}
+
+static int compare_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_config(const ReplayConfig* rc, const uint32_t* ssrcs, int ssrc_count) {
+    ReplayResult res = {0};
+    res.delays = (float*)malloc(g_packet_count * sizeof(float));
+    if (!res.delays) return;
+
+    for (int i = 0; i < ssrc_count; i++) {
+        replay_ssrc(rc, ssrcs[i], &res);
+    }
+
+    float avg = 0.0f, p95 = 0.0f;
+    if (res.delay_count > 0) {
+        double sum = 0.0;
+        for (uint32_t i = 0; i < res.delay_count; i++) sum += res.delays[i];
+        avg = (float)(sum / res.delay_count);
+        qsort(res.delays, res.delay_count, sizeof(float), compare_float);
+        p95 = res.delays[(uint32_t)((res.delay_count - 1) * 0.95)];
+    }
+
+    uint32_t expected = res.packets + res.lost;
+    printf("%-14s %8.1f %8.1f %8.2f%% %8.2f%% %9u %8u %8u %8u %8u %8.1f %10.1f\n",
+           rc->name, avg, p95,
+           res.packets ? 100.0 * res.late / res.packets : 0.0,
+           expected ? 100.0 * res.concealed / expected : 0.0,
+           res.underruns, res.comfort_noise, res.resyncs,
+           res.stretched, res.dropped, res.drift_ppm,
+           res.audio_ms ? res.cpu_us * 1000.0 / res.audio_ms : 0.0);
+
+    free(res.delays);
+}
+
+//=============================================================================
+// 主函数
+//=============================================================================
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: jitter_replay <trace> [-m min_ms] [-M max_ms] [-d 0|1]"
+            " [-c a:<late_loss> | -c f:<delay_ms>]...\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    JitterConfig base;
+    JitterBuffer_GetDefaultConfig(&base);
+
+    ReplayConfig configs[REPLAY_MAX_CONFIGS];
+    int config_count = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* arg = argv[++i];
+        if (strcmp(argv[i - 1], "-m") == 0) {
+            base.min_delay_ms = (uint32_t)atoi(arg);
+        } else if (strcmp(argv[i - 1], "-M") == 0) {
+            base.max_delay_ms = (uint32_t)atoi(arg);
+        } else if (strcmp(argv[i - 1], "-d") == 0) {
+            base.drift_compensation = atoi(arg) != 0;
+        } else if (strcmp(argv[i - 1], "-c") == 0 && config_count < REPLAY_MAX_CONFIGS) {
+            ReplayConfig* rc = &configs[config_count++];
+            if (arg[0] == 'a' && arg[1] == ':') {
+                rc->config.adaptive = true;
+                rc->config.late_loss_rate = (float)atof(arg + 2);
+                snprintf(rc->name, sizeof(rc->name), "adaptive %.3f", rc->config.late_loss_rate);
+            } else if (arg[0] == 'f' && arg[1] == ':') {
+                rc->config.adaptive = false;
+                rc->config.target_delay_ms = (uint32_t)atoi(arg + 2);
+                snprintf(rc->name, sizeof(rc->name), "fixed %ums", rc->config.target_delay_ms);
+            } else {
+                usage();
+                return 1;
+            }
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    // 默认扫描
+    if (config_count == 0) {
+        static const float losses[] = { 0.005f, 0.01f, 0.02f, 0.05f };
+        static const uint32_t fixed[] = { 40, 80, 120 };
+        for (size_t i = 0; i < ARRAY_SIZE(losses); i++) {
+            ReplayConfig* rc = &configs[config_count++];
+            rc->config.adaptive = true;
+            rc->config.late_loss_rate = losses[i];
+            snprintf(rc->name, sizeof(rc->name), "adaptive %.3f", losses[i]);
+        }
+        for (size_t i = 0; i < ARRAY_SIZE(fixed); i++) {
+            ReplayConfig* rc = &configs[config_count++];
+            rc->config.adaptive = false;
+            rc->config.target_delay_ms = fixed[i];
+            snprintf(rc->name, sizeof(rc->name), "fixed %ums", fixed[i]);
+        }
+    }
+
+    // 套用公共参数
+    for (int i = 0; i < config_count; i++) {
+        JitterConfig* c = &configs[i].config;
+        bool adaptive = c->adaptive;
+        float loss = c->late_loss_rate;
+        uint32_t target = c->target_delay_ms;
+        *c = base;
+        c->adaptive = adaptive;
+        if (adaptive) {
+            c->late_loss_rate = loss;
+        } else {
+            c->target_delay_ms = target;
+            c->min_delay_ms = MIN(c->min_delay_ms, target);
+            c->max_delay_ms = MAX(c->max_delay_ms, target);
+        }
+    }
+
+    if (!load_trace(argv[1])) {
+        fprintf(stderr, "cannot load trace %s\n", argv[1]);
+        return 1;
+    }
+
+    // 收集 SSRC
+    uint32_t ssrcs[REPLAY_MAX_SSRCS];
+    int ssrc_count = 0;
+    for (uint32_t i = 0; i < g_packet_count; i++) {
+        uint32_t ssrc = g_packets[i].rec.ssrc;
+        int j = 0;
+        while (j < ssrc_count && ssrcs[j] != ssrc) j++;
+        if (j == ssrc_count && ssrc_count < REPLAY_MAX_SSRCS) {
+            ssrcs[ssrc_count++] = ssrc;
+        }
+    }
+
+    uint64_t span_us = g_packets[g_packet_count - 1].rec.recv_time_us - g_packets[0].rec.recv_time_us;
+    printf("%u packets, %d streams, %.1f s\n\n", g_packet_count, ssrc_count, span_us / 1e6);
+    printf("%-14s %8s %8s %9s %9s %9s %8s %8s %8s %8s %8s %10s\n",
+           "config", "avg(ms)", "p95(ms)", "late", "conceal", "underruns", "cng", "resyncs",
+           "stretch", "dropped", "ppm", "us/audio-s");
+
+    for (int i = 0; i < config_count; i++) {
+        run_config(&configs[i], ssrcs, ssrc_count);
+    }
+
+    free(g_packets);
+    free(g_payloads);
+    return 0;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file mcu_bench.c
+ * @brief 服务器混音 (MCU) CPU 基准测试
+ *
+ * 不经过网络接收与混音线程, 直接以最快速度驱动 Mcu:
+ * 每个周期把各发送者的一帧 Opus 包 (虚拟到达时间) 交给 Mcu_Put, 然后调用 Mcu_Tick,
+ * 统计 Put + Tick 的耗时 (抖动缓冲 + 解码 + 混音 + 每个收听者编码 + 发送到回环丢弃端口).
+ * 对 2..MCU_MAX_LISTENERS 个参与者逐一测试, 输出每周期耗时、每个参与者耗时、
+ * 实时运行时占单核的百分比及每个参与者所占的单核百分比.
+ *
+ * 输入为预先编码的合成语音 (基频各不相同的谐波 + 噪声, 编码耗时不计入).
+ * 每个周期只有 -s 个参与者在说话, 其余参与者处于 DTX (不发包), 与实际会议一致.
+ *
+ * 构建 (Windows, 不属于 SharedVoice 工程):
+ *   cl /O2 /Iinclude tools\mcu_bench.c src\mcu.c src\stream_mixer.c src\jitter_buffer.c
+ *      src\time_stretch.c src\resampler.c src\opus_codec.c src\opus_dynamic.c
+ *      src\dll_loader.c src\network.c src\audio.c ole32.lib
+ * 运行需要 %TEMP%\SharedVoice\opus.dll (运行过一次 SharedVoice 即已提取).
+ *
+ * 用法:
+ *   mcu_bench [-s speakers] [-t seconds]
+ */
+
+#include "common.h"
+#include "network.h"
+#include "opus_codec.h"
+#include "opus_dynamic.h"
+#include "mcu.h"
+#include <math.h>
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define BENCH_DEFAULT_SPEAKERS  3           // 同时说话人数
+#define BENCH_DEFAULT_SECONDS   10          // 每组测试的音频时长
+#define BENCH_DISCARD_PORT      9           // 回环 discard 端口 (发送开销计入, 无人接收)
+#define BENCH_SSRC_BASE         1000
+
+//=============================================================================
+// 全局变量
+//=============================================================================
+static int g_participants = 0;              // 当前测试的参与者数 (收听者回调使用)
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 收听者: 所有参与者 (ctx 为发送用的 socket)
+ */
+static int bench_listeners(McuListener* listeners, int max_count, void* ctx) {
+    int count = MIN(g_participants, max_count);
+    for (int i = 0; i < count; i++) {
+        listeners[i].ssrc = BENCH_SSRC_BASE + i;
+        listeners[i].room = MCU_DEFAULT_ROOM;
+        Network_MakeAddr(&listeners[i].addr, "127.0.0.1", BENCH_DISCARD_PORT);
+        listeners[i].sock = *(SOCKET*)ctx;
+    }
+    return count;
+}
+
+/**
+ * @brief 合成一帧类语音信号 (基频 + 谐波 + 噪声)
+ */
+static void synth_frame(int16_t* pcm, int speaker, int frame) {
+    double f0 = 110.0 + 23.0 * speaker;
+    for (int i = 0; i < AUDIO_FRAME_SAMPLES; i++) {
+        double t = (double)(frame * AUDIO_FRAME_SAMPLES + i) / AUDIO_SAMPLE_RATE;
+        double v = 0.0;
+        for (int h = 1; h <= 8; h++) {
+            v += sin(2.0 * 3.14159265358979 * f0 * h * t) / h;
+        }
+        v = v * 3000.0 + (rand() % 600 - 300);
+        pcm[i] = (int16_t)CLAMP(v, -32768.0, 32767.0);
+    }
+}
+
+/**
+ * @brief 测试 participants 个参与者
+ */
+static void run_bench(SOCKET sock, int participants, int speakers, int frames) {
+    g_participants = participants;
+    speakers = MIN(speakers, participants);
+
+    // 预先编码各说话者的语音 (不计时)
+    OpusEncoderConfig enc_config;
+    OpusCodec_GetDefaultEncoderConfig(&enc_config);
+    enc_config.dtx = false;
+
+    uint8_t (*packets)[OPUS_MAX_PACKET] = malloc((size_t)speakers * frames * OPUS_MAX_PACKET);
+    int* lengths = (int*)malloc((size_t)speakers * frames * sizeof(int));
+    if (!packets || !lengths) {
+        free(packets);
+        free(lengths);
+        return;
+    }
+
+    int16_t pcm[AUDIO_FRAME_SAMPLES];
+    for (int s = 0; s < speakers; s++) {
+        OpusCodec* enc = OpusCodec_Create(&enc_config, NULL);
+        for (int f = 0; f < frames; f++) {
+            synth_frame(pcm, s, f);
+            int idx = s * frames + f;
+            lengths[idx] = enc ? OpusCodec_Encode(enc, pcm, AUDIO_FRAME_SAMPLES,
+                                                  packets[idx], OPUS_MAX_PACKET) : 0;
+        }
+        OpusCodec_Destroy(enc);
+    }
+
+    Mcu* mcu = Mcu_Create(1, bench_listeners, NULL, &sock);
+    if (!mcu) {
+        free(packets);
+        free(lengths);
+        return;
+    }
+
+    uint64_t base_us = GetTimeUs();
+    uint64_t cpu_us = 0;
+
+    for (int f = 0; f < frames; f++) {
+        uint64_t t0 = GetTimeUs();
+
+        for (int s = 0; s < speakers; s++) {
+            int idx = s * frames + f;
+            if (lengths[idx] <= 0) continue;
+
+            RtpHeader rtp;
+            RtpHeader_Init(&rtp, BENCH_SSRC_BASE + s, PAYLOAD_OPUS);
+            rtp.sequence = (uint16_t)f;
+            rtp.timestamp = (uint32_t)f * AUDIO_FRAME_SAMPLES;
+            rtp.payload_len = (uint16_t)lengths[idx];
+            RtpHeader_SetVadActive(&rtp, true);
+            RtpHeader_SetMarker(&rtp, f == 0);
+            Mcu_Put(mcu, &rtp, packets[idx], rtp.payload_len,
+                    base_us + (uint64_t)f * AUDIO_FRAME_MS * 1000);
+        }
+
+        Mcu_Tick(mcu);
+        cpu_us += GetTimeUs() - t0;
+    }
+
+    McuStats stats;
+    Mcu_GetStats(mcu, &stats);
+    Mcu_Destroy(mcu);
+
+    double tick_us = (double)cpu_us / frames;
+    double core = 100.0 * tick_us / (AUDIO_FRAME_MS * 1000);
+    printf("%12d %9d %10.1f %10.1f %12.1f %9.2f%% %13.3f%% %10u\n",
+           participants, speakers, tick_us, stats.tick_cost_max_us,
+           tick_us / participants, core, core / participants, stats.packets_sent);
+
+    free(packets);
+    free(lengths);
+}
+
+//=============================================================================
+// 主函数
+//=============================================================================
+
+int main(int argc, char** argv) {
+    int speakers = BENCH_DEFAULT_SPEAKERS;
+    int seconds = BENCH_DEFAULT_SECONDS;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-s") == 0) {
+            speakers = MAX(atoi(argv[i + 1]), 1);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            seconds = MAX(atoi(argv[i + 1]), 1);
+        } else {
+            fprintf(stderr, "usage: mcu_bench [-s speakers] [-t seconds]\n");
+            return 1;
+        }
+    }
+
+    if (!opus_dynamic_init()) {
+        fprintf(stderr, "cannot load opus.dll\n");
+        return 1;
+    }
+    if (!Network_Init()) {
+        opus_dynamic_cleanup();
+        return 1;
+    }
+
+    SOCKET sock = Network_CreateUdpAudio(0, NULL);
+    if (sock == INVALID_SOCKET) {
+        Network_Shutdown();
+        opus_dynamic_cleanup();
+        return 1;
+    }
+
+    int frames = seconds * 1000 / AUDIO_FRAME_MS;
+    printf("%d s of audio per run, encoder complexity %d\n\n", seconds, MCU_ENCODER_COMPLEXITY);
+    printf("%12s %9s %10s %10s %12s %10s %14s %10s\n",
+           "participants", "speakers", "us/tick", "max(us)", "us/particip.", "core",
+           "core/particip.", "packets");
+
+    // 2, 4, 8, ... 直到 MCU 模式的会话上限
+    for (int n = 2; ; n = MIN(n * 2, MCU_MAX_LISTENERS)) {
+        run_bench(sock, n, speakers, frames);
+        if (n == MCU_MAX_LISTENERS) break;
+    }
+
+    Network_CloseSocket(sock);
+    Network_Shutdown();
+    opus_dynamic_cleanup();
+    return 0;
+}
@@ -0,0 +1,403 @@
+/**
+ * @file session_bench.c
+ * @brief 服务器容量基准测试 (回环负载生成器)
+ *
+ * 对一个正在运行的服务器 (SharedVoice 服务器模式, 同一台机器) 依次建立 N 个完整的客户端会话
+ * (TCP HELLO + JOIN, 每个会话一个独立的 UDP socket), 按 -r 轮流分到各房间 (1 为全部在大厅),
+ * 每个房间中 -s 个会话每 20ms 发送一个带发送时间戳的 RTP 包, 所有会话接收转发并统计.
+ * 对每个 N 输出:
+ *   join ms     平均每个会话从 HELLO 到收到 JOIN (及加入房间) 确认的耗时 (控制面)
+ *   expected/s  应转发的包速率 = 各房间 min(speakers, K) * (房间人数 - 1) * 50 之和,
+ *               K 为服务器每个房间转发的发言者数 (-k, 与服务器 --speakers 一致, 0 为不限)
+ *   received/s  实际收到的包速率
+ *   loss        丢失比例
+ *   latency     发送到收到的平均/最大时延 (同一台机器, 含负载生成器自身调度)
+ *
+ * 预期容量曲线 (由包速率推算, 尚未实测; 实测须在 Windows 上运行本工具并记录结果):
+ * 逐包转发时服务器每秒需发出 speakers * (N - 1) * 50 个包, 与 N 成正比,
+ * 与参与者总数的平方 (所有人都说话时) 成正比. 随 N 增大, received/s 先与 expected/s 一致,
+ * 到服务器 (或回环接收端) 的包速率上限时开始丢包, 时延随之上升; 该拐点即单房间容量.
+ * 分成 R 个房间后包速率约降为 1/R, 同样的包速率上限可容纳约 R 倍的会话;
+ * 发言者选择把每个房间的发送路数限制为 K, speakers 超过 K 后包速率不再随之增长.
+ *
+ * 多线程转发: 服务器以 --audio-workers N 启动时, 会话按 SSRC 分到 N 个音频端口 (见 HELLO_ACK).
+ * 负载生成器用 -w 个线程分担收发, 避免自身先成为瓶颈; 在丢包拐点附近比较 N = 1, 2, 4
+ * 时的 received/s, 服务器转发能力应随 N 近似线性增长 (直到回环或 CPU 核数成为上限).
+ * 服务器端的转发延迟与系统调用次数见服务器日志 (每 5 秒一次).
+ *
+ * 测量步骤 (须在多核 Windows 机器上运行; 上面的曲线只是推算, 本文件不含实测数据):
+ *   1. 容量曲线: 以服务器模式启动 SharedVoice (--speakers K), 运行
+ *        session_bench -k K    (默认 -n 覆盖到会话上限 MAX_SESSIONS)
+ *      再以 -r 4 重复一次, 对比分房间后的拐点
+ *   2. 多线程扩展: 分别以 --audio-workers 1 / 2 / 4 重启服务器, 运行
+ *        session_bench -k K -w 4 -n <步骤 1 中的拐点附近>
+ *      比较三组的 received/s, loss 与服务器进程的 CPU 占用
+ * 转发延迟取每组测试期间服务器日志中的 "Forward: ... latency X us" (平均值; 括号中的最大值
+ * 从服务器启动起累计, 只在第一组有意义). 每组默认运行 10 秒, 至少覆盖一条 5 秒一次的日志.
+ *
+ * 构建 (Windows, 不属于 SharedVoice 工程):
+ *   cl /O2 /Iinclude tools\session_bench.c src\network.c
+ *
+ * 用法:
+ *   session_bench [-h server_ip] [-p tcp_port] [-n 16,64,128,256,512,1024] [-r rooms]
+ *                 [-s speakers_per_room] [-k server_top_speakers] [-w threads] [-t seconds]
+ */
+
+#include "common.h"
+#include "network.h"
+#include "speaker_selector.h"
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define BENCH_DEFAULT_SIZES     "16,64,128,256,512,1024"    // 到服务器会话上限 (MAX_SESSIONS)
+#define BENCH_DEFAULT_SPEAKERS  4               // 每个房间同时说话的会话数
+#define BENCH_MAX_ROOMS         64
+#define BENCH_DEFAULT_SECONDS   10              // 每组测试时长 (覆盖服务器每 5 秒一次的转发统计日志)
+#define BENCH_MAX_SESSIONS      MAX_SESSIONS
+#define BENCH_MAX_SIZES         16
+#define BENCH_PAYLOAD           80              // 32kbps Opus 20ms 帧约 80 字节
+#define BENCH_LEVEL             (RTP_LEVEL_MAX - 30)    // 发送电平 -30 dBov
+#define BENCH_HEARTBEAT_MS      2000
+#define BENCH_CLIENT_ID_BASE    0x5B000000u
+#define BENCH_MAX_THREADS       16
+
+//=============================================================================
+// 数据结构
+//=============================================================================
+
+typedef struct {
+    SOCKET      tcp;
+    SOCKET      udp;
+    uint32_t    ssrc;
+    uint16_t    sequence;
+    SOCKADDR_IN audio_addr;     // 服务器为该会话分配的音频端口
+} BenchSession;
+
+typedef struct {
+    uint64_t    received;
+    uint64_t    latency_sum_us;
+    uint64_t    latency_max_us;
+} BenchCounters;
+
+/**
+ * @brief 负载生成线程: 负责 [first, first + count) 号会话的收发
+ */
+typedef struct {
+    BenchSession*   sessions;       // 全部会话
+    int             first;
+    int             count;
+    int             senders;        // 前 senders 个会话发言 (全局序号)
+    uint64_t        start_us;
+    uint64_t        end_us;
+    uint64_t        frames;
+    BenchCounters   counters;
+    Thread          thread;
+} BenchThread;
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+/**
+ * @brief 阻塞等待指定类型的控制报文 (跳过其他报文)
+ */
+static bool wait_for(SOCKET sock, uint16_t msg_type, void* buf, int len) {
+    for (;;) {
+        int n = Network_TcpRecvPacket(sock, buf, len);
+        if (n < (int)sizeof(PacketHeader)) return false;
+        if (((PacketHeader*)buf)->msg_type == msg_type) return true;
+    }
+}
+
+/**
+ * @brief 建立一个会话: TCP 连接, HELLO, JOIN, 加入房间 (rooms > 1 时)
+ */
+static bool open_session(BenchSession* s, int index, int rooms, const char* ip, uint16_t tcp_port) {
+    uint8_t buf[MAX_PACKET_SIZE];
+    uint16_t udp_port = 0;
+
+    s->tcp = Network_TcpConnect(ip, tcp_port);
+    s->udp = Network_CreateUdpAudio(0, &udp_port);
+    if (s->tcp == INVALID_SOCKET || s->udp == INVALID_SOCKET) return false;
+
+    HelloRequest hello;
+    memset(&hello, 0, sizeof(hello));
+    PacketHeader_Init(&hello.header, MSG_HELLO, sizeof(HelloRequest) - sizeof(PacketHeader));
+    hello.client_id = BENCH_CLIENT_ID_BASE + (uint32_t)index;
+    hello.capability_flags = CAP_OPUS;
+    snprintf(hello.client_name, sizeof(hello.client_name), "bench-%d", index);
+    Network_TcpSend(s->tcp, &hello, sizeof(hello));
+    if (!wait_for(s->tcp, MSG_HELLO_ACK, buf, sizeof(buf))) return false;
+
+    HelloAck* ack = (HelloAck*)buf;
+    Network_MakeAddr(&s->audio_addr, ip, ack->audio_udp_port);
+
+    JoinSessionRequest join;
+    memset(&join, 0, sizeof(join));
+    PacketHeader_Init(&join.header, MSG_JOIN_SESSION, sizeof(JoinSessionRequest) - sizeof(PacketHeader));
+    join.client_id = hello.client_id;
+    join.local_udp_port = udp_port;
+    Network_TcpSend(s->tcp, &join, sizeof(join));
+    if (!wait_for(s->tcp, MSG_JOIN_SESSION + 1, buf, sizeof(buf))) return false;
+
+    s->ssrc = ((JoinSessionAck*)buf)->ssrc;
+    s->sequence = 0;
+
+    if (rooms > 1) {
+        RoomJoinRequest room;
+        memset(&room, 0, sizeof(room));
+        PacketHeader_Init(&room.header, MSG_ROOM_JOIN, sizeof(RoomJoinRequest) - sizeof(PacketHeader));
+        snprintf(room.room_name, sizeof(room.room_name), "bench-%d", index % rooms);
+        Network_TcpSend(s->tcp, &room, sizeof(room));
+        if (!wait_for(s->tcp, MSG_ROOM_JOIN_ACK, buf, sizeof(buf)) ||
+            ((RoomJoinAck*)buf)->result != 0) {
+            return false;
+        }
+    }
+
+    // 之后只需丢弃服务器的通知, 避免其发送缓冲被填满
+    Network_SetNonBlocking(s->tcp, true);
+    Network_SetNonBlocking(s->udp, true);
+    return true;
+}
+
+static void close_session(BenchSession* s) {
+    Network_CloseSocket(s->tcp);
+    Network_CloseSocket(s->udp);
+    s->tcp = INVALID_SOCKET;
+    s->udp = INVALID_SOCKET;
+}
+
+/**
+ * @brief 收取所有会话的 UDP 包 (统计时延) 并丢弃 TCP 通知
+ */
+static void drain(BenchSession* sessions, int count, BenchCounters* counters) {
+    uint8_t buf[MAX_PACKET_SIZE];
+
+    for (int i = 0; i < count; i++) {
+        for (;;) {
+            int n = recv(sessions[i].udp, (char*)buf, sizeof(buf), 0);
+            if (n < (int)(sizeof(RtpHeader) + sizeof(uint64_t))) break;
+
+            uint64_t sent_us;
+            memcpy(&sent_us, buf + sizeof(RtpHeader), sizeof(sent_us));
+            uint64_t now = GetTimeUs();
+            uint64_t latency = now > sent_us ? now - sent_us : 0;
+            counters->received++;
+            counters->latency_sum_us += latency;
+            counters->latency_max_us = MAX(counters->latency_max_us, latency);
+        }
+        while (recv(sessions[i].tcp, (char*)buf, sizeof(buf), 0) > 0) {
+        }
+    }
+}
+
+static void send_heartbeats(BenchSession* sessions, int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        HeartbeatPacket hb;
+        PacketHeader_Init(&hb.header, MSG_HEARTBEAT, sizeof(HeartbeatPacket) - sizeof(PacketHeader));
+        hb.client_id = BENCH_CLIENT_ID_BASE + (uint32_t)i;
+        hb.local_time = GetTickCount64Ms();
+        Network_TcpSend(sessions[i].tcp, &hb, sizeof(hb));
+    }
+}
+
+/**
+ * @brief 每帧应转发的包数: 各房间 speakers * (房间人数 - 1) 之和
+ * @param speakers 每个房间实际被转发的发言者数
+ */
+static uint64_t expected_per_frame(int count, int rooms, int speakers) {
+    uint64_t total = 0;
+    for (int r = 0; r < rooms; r++) {
+        int members = count / rooms + (r < count % rooms ? 1 : 0);
+        if (members > 0) {
+            total += (uint64_t)MIN(speakers, members) * (uint64_t)(members - 1);
+        }
+    }
+    return total;
+}
+
+static DWORD WINAPI bench_thread_proc(LPVOID param) {
+    BenchThread* t = (BenchThread*)param;
+    BenchSession* mine = t->sessions + t->first;
+
+    uint8_t payload[BENCH_PAYLOAD];
+    memset(payload, 0x5A, sizeof(payload));
+
+    uint64_t next_frame = t->start_us;
+    uint64_t next_heartbeat = t->start_us;
+    int last_sender = MIN(t->first + t->count, t->senders);
+
+    while (GetTimeUs() < t->end_us) {
+        uint64_t now = GetTimeUs();
+        if (now >= next_frame) {
+            for (int i = t->first; i < last_sender; i++) {
+                BenchSession* s = &t->sessions[i];
+                RtpHeader rtp;
+                RtpHeader_Init(&rtp, s->ssrc, PAYLOAD_OPUS);
+                rtp.sequence = s->sequence++;
+                rtp.timestamp = (uint32_t)(t->frames * AUDIO_FRAME_SAMPLES);
+                rtp.payload_len = sizeof(payload);
+                RtpHeader_SetVadActive(&rtp, true);
+                RtpHeader_SetLevel(&rtp, BENCH_LEVEL);
+                memcpy(payload, &now, sizeof(now));
+                Network_SendRtpPacket(s->udp, &rtp, payload, sizeof(payload), &s->audio_addr);
+            }
+            t->frames++;
+            next_frame += AUDIO_FRAME_MS * 1000;
+        }
+        if (now >= next_heartbeat) {
+            send_heartbeats(t->sessions, t->first, t->count);
+            next_heartbeat += BENCH_HEARTBEAT_MS * 1000;
+        }
+
+        drain(mine, t->count, &t->counters);
+        Sleep(1);
+    }
+
+    // 收取在途的包
+    Sleep(100);
+    drain(mine, t->count, &t->counters);
+    return 0;
+}
+
+/**
+ * @brief 对 count 个会话运行一组测试
+ * @param speakers 每个房间的发言会话数 (会话 i 属于房间 i % rooms, 前 speakers * rooms 个会话发言)
+ * @param top_speakers 服务器每个房间转发的发言者数 (0 为不限)
+ * @param threads 负载生成线程数
+ */
+static void run(BenchSession* sessions, int count, int rooms, const char* ip, uint16_t tcp_port,
+                int speakers, int top_speakers, int threads, int seconds) {
+    uint64_t t0 = GetTimeUs();
+    int opened = 0;
+    while (opened < count &&
+           open_session(&sessions[opened], opened, rooms, ip, tcp_port)) {
+        opened++;
+    }
+    uint64_t t1 = GetTimeUs();
+    if (opened < count) {
+        close_session(&sessions[opened]);
+        printf("%8d  only %d sessions could join\n", count, opened);
+        count = opened;
+        if (count < 2) return;
+    }
+    int senders = MIN(speakers * rooms, count);
+
+    // 等待其他会话的加入通知到达, 再开始计数
+    Sleep(200);
+    BenchCounters counters = {0};
+    drain(sessions, count, &counters);
+    memset(&counters, 0, sizeof(counters));
+
+    // 会话平均分给各线程, 所有线程使用同一发送节拍
+    BenchThread workers[BENCH_MAX_THREADS];
+    threads = MIN(threads, count);
+    uint64_t start = GetTimeUs() + 10000;
+    for (int i = 0; i < threads; i++) {
+        BenchThread* t = &workers[i];
+        memset(t, 0, sizeof(*t));
+        t->sessions = sessions;
+        t->first = count * i / threads;
+        t->count = count * (i + 1) / threads - t->first;
+        t->senders = senders;
+        t->start_us = start;
+        t->end_us = start + (uint64_t)seconds * 1000000;
+        ThreadCreate(&t->thread, bench_thread_proc, t);
+    }
+
+    uint64_t frames = 0;
+    for (int i = 0; i < threads; i++) {
+        BenchThread* t = &workers[i];
+        ThreadJoin(t->thread);
+        ThreadClose(t->thread);
+        frames = MAX(frames, t->frames);
+        counters.received += t->counters.received;
+        counters.latency_sum_us += t->counters.latency_sum_us;
+        counters.latency_max_us = MAX(counters.latency_max_us, t->counters.latency_max_us);
+    }
+
+    double elapsed = (double)(GetTimeUs() - start) / 1000000.0;
+    int forwarded = top_speakers > 0 ? MIN(speakers, top_speakers) : speakers;
+    uint64_t expected = frames * expected_per_frame(count, rooms, forwarded);
+    double loss = expected ? 1.0 - (double)counters.received / expected : 0.0;
+    printf("%8d %10.2f %12.0f %12.0f %7.2f%% %10.0f %10.0f\n", count,
+           (double)(t1 - t0) / 1000.0 / count, expected / elapsed, counters.received / elapsed,
+           MAX(loss, 0.0) * 100.0,
+           counters.received ? (double)counters.latency_sum_us / counters.received : 0.0,
+           (double)counters.latency_max_us);
+
+    for (int i = 0; i < count; i++) {
+        close_session(&sessions[i]);
+    }
+
+    // 等待服务器清理会话
+    Sleep(500);
+}
+
+//=============================================================================
+// 主函数
+//=============================================================================
+
+int main(int argc, char** argv) {
+    const char* ip = "127.0.0.1";
+    uint16_t tcp_port = CONTROL_PORT;
+    const char* size_list = BENCH_DEFAULT_SIZES;
+    int speakers = BENCH_DEFAULT_SPEAKERS;
+    int seconds = BENCH_DEFAULT_SECONDS;
+    int rooms = 1;
+    int top_speakers = SPEAKER_DEFAULT_FORWARD;
+    int threads = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-h") == 0) {
+            ip = argv[i + 1];
+        } else if (strcmp(argv[i], "-p") == 0) {
+            tcp_port = (uint16_t)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            size_list = argv[i + 1];
+        } else if (strcmp(argv[i], "-r") == 0) {
+            rooms = CLAMP(atoi(argv[i + 1]), 1, BENCH_MAX_ROOMS);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            speakers = MAX(atoi(argv[i + 1]), 1);
+        } else if (strcmp(argv[i], "-k") == 0) {
+            top_speakers = MAX(atoi(argv[i + 1]), 0);
+        } else if (strcmp(argv[i], "-w") == 0) {
+            threads = CLAMP(atoi(argv[i + 1]), 1, BENCH_MAX_THREADS);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            seconds = MAX(atoi(argv[i + 1]), 1);
+        } else {
+            fprintf(stderr, "usage: session_bench [-h server_ip] [-p tcp_port] "
+                            "[-n 16,64,...] [-r rooms] [-s speakers_per_room] [-k server_top_speakers] "
+                            "[-w threads] [-t seconds]\n");
+            return 1;
+        }
+    }
+
+    int sizes[BENCH_MAX_SIZES];
+    int size_count = 0;
+    for (const char* p = size_list; *p && size_count < BENCH_MAX_SIZES; ) {
+        sizes[size_count++] = CLAMP(atoi(p), 2, BENCH_MAX_SESSIONS);
+        p = strchr(p, ',');
+        if (!p) break;
+        p++;
+    }
+
+    if (!Network_Init()) return 1;
+
+    static BenchSession sessions[BENCH_MAX_SESSIONS];
+
+    printf("server %s:%u, %d rooms, %d speakers per room (server forwards %d), "
+           "%d generator threads, %d s per run\n\n",
+           ip, tcp_port, rooms, speakers, top_speakers, threads, seconds);
+    printf("%8s %10s %12s %12s %8s %10s %10s\n", "sessions", "join ms", "expected/s",
+           "received/s", "loss", "avg us", "max us");
+
+    for (int i = 0; i < size_count; i++) {
+        run(sessions, sizes[i], rooms, ip, tcp_port, speakers, top_speakers, threads, seconds);
+    }
+
+    Network_Shutdown();
+    return 0;
+}
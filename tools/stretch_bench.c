@@ -0,0 +1,155 @@
+/**
+ * @file stretch_bench.c
+ * @brief WSOLA 时间伸缩单帧 CPU 基准测试 (48 kHz 单声道)
+ *
+ * 对若干合成信号逐帧调用 TimeStretch_Process (加速 / 减速各一遍),
+ * 每帧 AUDIO_FRAME_SAMPLES 个采样, 输出单帧耗时的 平均 / P50 / P99 / 最大值 (微秒)
+ * 以及真正完成拼接的帧比例 (相关不足时原样复制, 耗时仍计入).
+ * 对应运行时统计 JitterStats.stretch_cost_us (指数平均).
+ *
+ * 信号:
+ *   tone     200 Hz 正弦
+ *   voiced   基频 90..260 Hz 缓慢滑动的谐波 + 少量噪声 (近似元音)
+ *   noise    白噪声 (相关低, 多数帧不拼接, 搜索仍做满)
+ *   silence  静音 (直接取最大伸缩量, 不做搜索)
+ *
+ * 构建 (不属于 SharedVoice 工程):
+ *   Linux:   gcc -std=gnu11 -O2 -Iinclude -o stretch_bench tools/stretch_bench.c
+ *                src/time_stretch.c -lm
+ *   Windows: cl /O2 /Iinclude tools\stretch_bench.c src\time_stretch.c
+ *
+ * 用法:
+ *   stretch_bench [-n frames]
+ */
+
+#include "common.h"
+#include "time_stretch.h"
+#include <math.h>
+
+//=============================================================================
+// 常量定义
+//=============================================================================
+#define BENCH_DEFAULT_FRAMES    20000
+#define BENCH_PI                3.14159265358979
+
+typedef enum {
+    SIGNAL_TONE,
+    SIGNAL_VOICED,
+    SIGNAL_NOISE,
+    SIGNAL_SILENCE,
+    SIGNAL_COUNT
+} BenchSignal;
+
+static const char* g_signal_names[SIGNAL_COUNT] = { "tone", "voiced", "noise", "silence" };
+
+//=============================================================================
+// 内部函数
+//=============================================================================
+
+static uint32_t g_rand = 12345;
+
+static int next_noise(void) {
+    g_rand = g_rand * 1103515245u + 12345u;
+    return (int)((g_rand >> 16) & 0x7FFF) - 16384;
+}
+
+/**
+ * @brief 生成第 index 帧的信号 (相位跨帧连续)
+ */
+static void make_frame(BenchSignal signal, int index, int16_t* pcm) {
+    static double phase = 0.0;
+
+    for (int i = 0; i < AUDIO_FRAME_SAMPLES; i++) {
+        double v = 0.0;
+        switch (signal) {
+        case SIGNAL_TONE:
+            v = 8000.0 * sin(phase);
+            phase += 2.0 * BENCH_PI * 200.0 / AUDIO_SAMPLE_RATE;
+            break;
+        case SIGNAL_VOICED: {
+            // 基频约 3 秒一个来回
+            double t = (index * AUDIO_FRAME_SAMPLES + i) / (double)AUDIO_SAMPLE_RATE;
+            double f0 = 175.0 + 85.0 * sin(2.0 * BENCH_PI * t / 3.0);
+            for (int h = 1; h <= 8; h++) {
+                v += 6000.0 / h * sin(h * phase);
+            }
+            v += next_noise() / 32.0;
+            phase += 2.0 * BENCH_PI * f0 / AUDIO_SAMPLE_RATE;
+            break;
+        }
+        case SIGNAL_NOISE:
+            v = next_noise() / 2.0;
+            break;
+        default:
+            break;
+        }
+        pcm[i] = (int16_t)CLAMP(v, -32768.0, 32767.0);
+    }
+    phase = fmod(phase, 2.0 * BENCH_PI);
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 运行一组测试
+ */
+static void run(BenchSignal signal, TsmMode mode, int frames, uint32_t* costs) {
+    int16_t in[AUDIO_FRAME_SAMPLES];
+    int16_t out[AUDIO_FRAME_SAMPLES + TSM_MAX_LAG_SAMPLES];
+    int spliced = 0;
+    uint64_t total = 0;
+
+    for (int f = 0; f < frames; f++) {
+        make_frame(signal, f, in);
+
+        uint64_t t0 = GetTimeUs();
+        int n = TimeStretch_Process(mode, in, AUDIO_FRAME_SAMPLES, out, ARRAY_SIZE(out));
+        uint64_t cost = GetTimeUs() - t0;
+
+        costs[f] = (uint32_t)cost;
+        total += cost;
+        if (n > 0 && n != AUDIO_FRAME_SAMPLES) spliced++;
+    }
+
+    qsort(costs, frames, sizeof(uint32_t), compare_u32);
+    printf("%-8s %-10s %8.1f %6u %6u %6u %8.1f%%\n",
+           g_signal_names[signal], mode == TSM_ACCELERATE ? "accelerate" : "decelerate",
+           (double)total / frames, costs[frames / 2], costs[(int)((frames - 1) * 0.99)],
+           costs[frames - 1], 100.0 * spliced / frames);
+}
+
+//=============================================================================
+// 主函数
+//=============================================================================
+
+int main(int argc, char** argv) {
+    int frames = BENCH_DEFAULT_FRAMES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            int value = atoi(argv[++i]);
+            frames = MAX(value, 1);
+        } else {
+            fprintf(stderr, "usage: stretch_bench [-n frames]\n");
+            return 1;
+        }
+    }
+
+    uint32_t* costs = (uint32_t*)malloc(frames * sizeof(uint32_t));
+    if (!costs) return 1;
+
+    printf("%d frames of %d samples @ %d Hz mono\n\n", frames, AUDIO_FRAME_SAMPLES, AUDIO_SAMPLE_RATE);
+    printf("%-8s %-10s %8s %6s %6s %6s %9s\n",
+           "signal", "mode", "avg(us)", "p50", "p99", "max", "spliced");
+
+    for (int s = 0; s < SIGNAL_COUNT; s++) {
+        run((BenchSignal)s, TSM_ACCELERATE, frames, costs);
+        run((BenchSignal)s, TSM_DECELERATE, frames, costs);
+    }
+
+    free(costs);
+    return 0;
+}